@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+    BenchmarkReport.cpp
+
+  ==============================================================================
+*/
+
+#include "BenchmarkReport.h"
+#include "KernelDispatch.h"
+
+bool BenchmarkReport::parseIntList(const String& text, Array<int>& values)
+{
+	values.clear();
+
+	for (auto& token : StringArray::fromTokens(text, ",", ""))
+	{
+		auto value = token.trim().getIntValue();
+
+		if (value < 1)
+			return false;
+
+		values.add(value);
+	}
+
+	return values.size() > 0;
+}
+
+DynamicObject::Ptr BenchmarkReport::createJsonRoot(const String& label)
+{
+	DynamicObject::Ptr root = new DynamicObject();
+	root->setProperty("label", label);
+	root->setProperty("version", ProjectInfo::versionString);
+	root->setProperty("date", Time::getCurrentTime().toISO8601(true));
+	root->setProperty("cpu", SystemStats::getCpuModel());
+	root->setProperty("numCpus", SystemStats::getNumCpus());
+	root->setProperty("cpuFeatures", KernelDispatch::getDescription());
+
+   #if JUCE_DEBUG
+	root->setProperty("build", "debug");
+   #else
+	root->setProperty("build", "release");
+   #endif
+
+	return root;
+}
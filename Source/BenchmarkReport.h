@@ -0,0 +1,24 @@
+/*
+  ==============================================================================
+
+    BenchmarkReport.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//The parts the command line benchmarks share: parsing their list options, and the header every JSON report starts
+//with, so results from OscillatorBenchmark and CapacityPlanner can be matched to the build and machine that made them.
+class BenchmarkReport
+{
+	public:
+		//splits a comma separated list of positive numbers; returns false if any of them isn't one
+		static bool parseIntList(const String& text, Array<int>& values);
+
+		//a JSON root holding the label, version, date, CPU, its features and whether this is a debug build;
+		//the caller adds its own settings and rows to it
+		static DynamicObject::Ptr createJsonRoot(const String& label);
+};
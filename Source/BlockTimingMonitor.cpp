@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    BlockTimingMonitor.cpp
+
+  ==============================================================================
+*/
+
+#include "BlockTimingMonitor.h"
+
+BlockTimingMonitor::BlockTimingMonitor(int capacity)
+	: records(capacity)
+{
+}
+
+void BlockTimingMonitor::addBlock(int64 startTicks, int64 endTicks, int numSamples, double sampleRate, int numVoices) noexcept
+{
+	BlockTimingRecord record;
+	record.startTicks = startTicks;
+	record.durationTicks = endTicks - startTicks;
+	record.deadlineTicks = sampleRate > 0.0 ? Time::secondsToHighResolutionTicks(numSamples / sampleRate) : 0;
+	record.numSamples = numSamples;
+	record.numVoices = numVoices;
+
+	if (! records.push(record))
+		numDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool BlockTimingMonitor::pop(BlockTimingRecord& record) noexcept
+{
+	return records.pop(record);
+}
+
+//==============================================================================
+static double ticksToMicroseconds(int64 ticks) noexcept
+{
+	return Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+}
+
+BlockTimingHistogram::BlockTimingHistogram()
+{
+	buckets.insertMultiple(0, 0, numBuckets);
+}
+
+void BlockTimingHistogram::reset() noexcept
+{
+	buckets.fill(0);
+	numBlocks = numDeadlineMisses = 0;
+	minTicks = maxTicks = totalTicks = 0;
+	lastNumSamples = lastNumVoices = 0;
+	worstLoad = 0.0;
+}
+
+void BlockTimingHistogram::drain(BlockTimingMonitor& monitor) noexcept
+{
+	BlockTimingRecord record;
+
+	while (monitor.pop(record))
+		addRecord(record);
+}
+
+void BlockTimingHistogram::addRecord(const BlockTimingRecord& record) noexcept
+{
+	//bucket 0 holds everything up to a microsecond, then every bucket is 1/16 of an octave wider than the one below
+	auto microseconds = ticksToMicroseconds(record.durationTicks);
+	auto bucket = microseconds > 1.0 ? (int)(std::log2(microseconds) * bucketsPerOctave) + 1 : 0;
+	++buckets.getReference(jmin(bucket, numBuckets - 1));
+
+	minTicks = numBlocks == 0 ? record.durationTicks : jmin(minTicks, record.durationTicks);
+	maxTicks = jmax(maxTicks, record.durationTicks);
+	totalTicks += record.durationTicks;
+	++numBlocks;
+
+	if (record.deadlineTicks > 0)
+	{
+		if (record.durationTicks > record.deadlineTicks)
+			++numDeadlineMisses;
+
+		worstLoad = jmax(worstLoad, record.durationTicks / (double)record.deadlineTicks);
+	}
+
+	lastNumSamples = record.numSamples;
+	lastNumVoices = record.numVoices;
+}
+
+double BlockTimingHistogram::getMinMicroseconds() const noexcept
+{
+	return ticksToMicroseconds(minTicks);
+}
+
+double BlockTimingHistogram::getAverageMicroseconds() const noexcept
+{
+	return numBlocks > 0 ? ticksToMicroseconds(totalTicks) / numBlocks : 0.0;
+}
+
+double BlockTimingHistogram::getMaxMicroseconds() const noexcept
+{
+	return ticksToMicroseconds(maxTicks);
+}
+
+double BlockTimingHistogram::getPercentileMicroseconds(double percentile) const noexcept
+{
+	if (numBlocks == 0)
+		return 0.0;
+
+	//walk up the buckets until enough blocks are below, then report that bucket's upper edge,
+	//which never claims the tail is better than it is
+	auto target = (int64)std::ceil(numBlocks * percentile / 100.0);
+	int64 count = 0;
+
+	for (auto bucket = 0; bucket < numBuckets; ++bucket)
+	{
+		count += buckets.getUnchecked(bucket);
+
+		if (count >= target)
+			return jmin(std::exp2(bucket / (double)bucketsPerOctave), getMaxMicroseconds());
+	}
+
+	return getMaxMicroseconds();
+}
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    BlockTimingMonitor.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "SpscQueue.h"
+
+
+//how long one audio callback took, written by the audio thread at the end of the block
+struct BlockTimingRecord
+{
+	int64 startTicks;		//Time::getHighResolutionTicks() when the block started
+	int64 durationTicks;
+	int64 deadlineTicks;	//the real time the block's samples last for; taking longer than this starves the device
+	int numSamples;
+	int numVoices;
+};
+
+//Single-producer/single-consumer lock-free queue of block timings, the same way ParameterQueue works but in the
+//other direction: the audio thread pushes one record per callback, the message thread drains them on its timer.
+//All storage is allocated in the constructor.
+class BlockTimingMonitor
+{
+	public:
+		//4096 records is several seconds of blocks, much longer than the GUI ever takes between two drains
+		explicit BlockTimingMonitor(int capacity = 4096);
+
+		//audio thread only; the record is dropped (and counted) if the message thread has stopped draining
+		void addBlock(int64 startTicks, int64 endTicks, int numSamples, double sampleRate, int numVoices) noexcept;
+
+		//message thread only; returns false once the queue is empty
+		bool pop(BlockTimingRecord& record) noexcept;
+
+		int getNumDropped() const noexcept { return numDropped.load(std::memory_order_relaxed); }
+
+	private:
+		SpscQueue<BlockTimingRecord> records;
+		std::atomic<int> numDropped { 0 };
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BlockTimingMonitor)
+};
+
+//==============================================================================
+//Message thread side: accumulates the drained records into min/avg/p99/max block times and a count of the blocks
+//that missed their deadline. An averaged CPU figure hides the occasional slow block that actually causes a dropout,
+//the tail of this histogram doesn't.
+//
+//Durations go into logarithmic buckets, sixteen to an octave, so the percentiles are accurate to about 4.5%
+//whether a block takes a microsecond or a second.
+class BlockTimingHistogram
+{
+	public:
+		BlockTimingHistogram();
+
+		void reset() noexcept;
+
+		//pulls everything the audio thread has written since the last call
+		void drain(BlockTimingMonitor& monitor) noexcept;
+		void addRecord(const BlockTimingRecord& record) noexcept;
+
+		int64 getNumBlocks() const noexcept			{ return numBlocks; }
+		int64 getNumDeadlineMisses() const noexcept	{ return numDeadlineMisses; }
+
+		//all in microseconds, 0 before the first block
+		double getMinMicroseconds() const noexcept;
+		double getAverageMicroseconds() const noexcept;
+		double getMaxMicroseconds() const noexcept;
+		double getPercentileMicroseconds(double percentile) const noexcept;
+
+		//the size and voice count of the last block, and its share of the deadline
+		int getLastNumSamples() const noexcept		{ return lastNumSamples; }
+		int getLastNumVoices() const noexcept		{ return lastNumVoices; }
+		double getWorstLoad() const noexcept		{ return worstLoad; }
+
+	private:
+		static constexpr int bucketsPerOctave = 16;
+		static constexpr int numBuckets = bucketsPerOctave * 20;	//1 us up to about a second
+
+		Array<int64> buckets;
+		int64 numBlocks = 0, numDeadlineMisses = 0;
+		int64 minTicks = 0, maxTicks = 0, totalTicks = 0;
+		int lastNumSamples = 0, lastNumVoices = 0;
+		double worstLoad = 0.0;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BlockTimingHistogram)
+};
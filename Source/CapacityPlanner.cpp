@@ -0,0 +1,496 @@
+/*
+  ==============================================================================
+
+    CapacityPlanner.cpp
+
+  ==============================================================================
+*/
+
+#include "CapacityPlanner.h"
+#include "BenchmarkReport.h"
+#include <iostream>
+
+//the names accepted by --types, in the order of SynthEngine::VoiceType
+static const char* const voiceTypeNames[] = { "sine", "wavetable", "pluck", "polyblep", "oversampled" };
+
+//rendered before the timing starts, so the first touches of the tables and the worker threads waking up don't count
+static const double warmUpSeconds = 0.2;
+
+//the search stops once the gap between passing and failing is within this share of the voice count
+static const int searchResolution = 32;
+
+//==============================================================================
+VoiceCountSearch::VoiceCountSearch(int maxVoicesToUse)
+	: maxVoices(jmax(1, maxVoicesToUse)), smallestFailing(maxVoices + 1)
+{
+}
+
+void VoiceCountSearch::addResult(bool passed) noexcept
+{
+	++numSteps;
+
+	if (passed)
+		largestPassing = next;
+	else
+		smallestFailing = next;
+
+	//still doubling until the first step fails
+	if (smallestFailing > maxVoices)
+	{
+		finished = largestPassing == maxVoices;
+		next = jmin(maxVoices, largestPassing * 2);
+		return;
+	}
+
+	finished = smallestFailing - largestPassing <= jmax(1, largestPassing / searchResolution);
+	next = largestPassing + (smallestFailing - largestPassing) / 2;
+}
+
+//==============================================================================
+bool CapacityPlanner::isStressCommandLine(const String& commandLine)
+{
+	return StringArray::fromTokens(commandLine, true).contains("--stress");
+}
+
+bool CapacityPlanner::parseCommandLine(const String& commandLine, Options& options, String& errorMessage)
+{
+	auto args = StringArray::fromTokens(commandLine, true);
+
+	for (auto i = 0; i < args.size(); ++i)
+	{
+		auto arg = args[i];
+
+		if (arg == "--stress")
+			continue;
+
+		//every other option takes exactly one value
+		if (i + 1 >= args.size())
+		{
+			errorMessage = "Missing value for " + arg;
+			return false;
+		}
+
+		auto value = args[++i].unquoted();
+
+		if (arg == "--types")
+		{
+			options.voiceTypes.clear();
+
+			for (auto& token : StringArray::fromTokens(value, ",", ""))
+			{
+				auto found = false;
+
+				for (auto type = 0; type < numElementsInArray(voiceTypeNames); ++type)
+				{
+					if (token.trim().equalsIgnoreCase(voiceTypeNames[type]))
+					{
+						options.voiceTypes.add((SynthEngine::VoiceType)type);
+						found = true;
+					}
+				}
+
+				if (! found)
+				{
+					errorMessage = "Unknown voice type " + token + " (use sine, wavetable, pluck, polyblep or oversampled)";
+					return false;
+				}
+			}
+		}
+		else if (arg == "--blocksizes")
+		{
+			if (! BenchmarkReport::parseIntList(value, options.blockSizes))
+			{
+				errorMessage = arg + " needs a comma separated list of positive numbers";
+				return false;
+			}
+		}
+		else if (arg == "--load")
+			options.targetLoad = value.getDoubleValue();
+		else if (arg == "--seconds-per-step")
+			options.secondsPerStep = value.getDoubleValue();
+		else if (arg == "--max-voices")
+			options.maxVoices = value.getIntValue();
+		else if (arg == "--threads")
+			options.numWorkerThreads = value.getIntValue();
+		else if (arg == "--samplerate")
+			options.sampleRate = value.getDoubleValue();
+		else if (arg == "--format")
+		{
+			if (value != "csv" && value != "json")
+			{
+				errorMessage = "Unknown format " + value + " (use csv or json)";
+				return false;
+			}
+
+			options.json = value == "json";
+		}
+		else if (arg == "--output")
+			options.outputFile = File::getCurrentWorkingDirectory().getChildFile(value);
+		else if (arg == "--label")
+			options.label = value;
+		else
+		{
+			errorMessage = "Unknown option " + arg;
+			return false;
+		}
+	}
+
+	if (options.targetLoad <= 0.0 || options.targetLoad > 1.0)
+		errorMessage = "--load has to be greater than 0 and at most 1";
+	else if (options.secondsPerStep <= 0.0)
+		errorMessage = "--seconds-per-step has to be greater than zero";
+	else if (options.maxVoices < 1)
+		errorMessage = "--max-voices has to be at least 1";
+	else if (options.sampleRate < 8000.0)
+		errorMessage = "--samplerate has to be at least 8000";
+
+	return errorMessage.isEmpty();
+}
+
+String CapacityPlanner::getVoiceTypeName(SynthEngine::VoiceType voiceType)
+{
+	return isPositiveAndBelow((int)voiceType, numElementsInArray(voiceTypeNames)) ? voiceTypeNames[(int)voiceType] : "bank";
+}
+
+std::unique_ptr<SynthEngine> CapacityPlanner::createEngine(SynthEngine::VoiceType voiceType, int numVoices, int numWorkerThreads)
+{
+	std::unique_ptr<SynthEngine> engine(new SynthEngine(numVoices, voiceType, numWorkerThreads));
+	engine->setWaveform(WavetableSet::Shape::saw);
+	return engine;
+}
+
+void CapacityPlanner::startNotes(SynthEngine& engine, int numVoices, int playingVoices)
+{
+	for (auto i = playingVoices; i < numVoices; ++i)
+	{
+		auto noteNumber = 36 + i % 60;
+		engine.startNote(noteNumber, (float)MidiMessage::getMidiNoteInHertz(noteNumber), 1.0f);
+	}
+}
+
+CapacityPlanner::Step CapacityPlanner::judge(int numVoices, const BlockTimingHistogram& blockTimings, double deadlineMicroseconds,
+											 double targetLoad, int64 extraMisses)
+{
+	Step step;
+	step.numVoices = numVoices;
+	step.p99Microseconds = blockTimings.getPercentileMicroseconds(99.0);
+	step.load = step.p99Microseconds / deadlineMicroseconds;
+	step.deadlineMisses = blockTimings.getNumDeadlineMisses() + extraMisses;
+	step.passed = blockTimings.getNumBlocks() > 0 && step.deadlineMisses == 0 && step.load <= targetLoad;
+	return step;
+}
+
+//==============================================================================
+CapacityPlanner::CapacityPlanner(const Options& optionsToUse)
+	: options(optionsToUse)
+{
+}
+
+int CapacityPlanner::run()
+{
+	for (auto voiceType : options.voiceTypes)
+	{
+		for (auto blockSize : options.blockSizes)
+		{
+			auto result = search(voiceType, blockSize);
+			results.add(result);
+
+			std::cerr << getVoiceTypeName(voiceType) << " block " << blockSize << ": " << result.maxVoices << " voices at "
+					  << String(result.load * 100.0, 1) << "% of the " << String(result.deadlineMicroseconds, 1) << " us deadline ("
+					  << result.numSteps << " steps)" << std::endl;
+		}
+	}
+
+	auto text = options.json ? createJson() : createCsv();
+
+	if (options.outputFile.getFullPathName().isEmpty())
+	{
+		std::cout << text;
+	}
+	else if (! options.outputFile.replaceWithText(text))
+	{
+		std::cerr << "Couldn't write " << options.outputFile.getFullPathName() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+CapacityPlanner::Result CapacityPlanner::search(SynthEngine::VoiceType voiceType, int blockSize)
+{
+	VoiceCountSearch voiceCounts(options.maxVoices);
+	Step lastPassed { 0, 0.0, 0.0, 0, false };
+	auto numWorkerThreads = 0;
+
+	while (! voiceCounts.isFinished())
+	{
+		auto step = measure(voiceType, blockSize, voiceCounts.getVoiceCount(), numWorkerThreads);
+		voiceCounts.addResult(step.passed);
+
+		if (step.passed)
+			lastPassed = step;
+
+		std::cerr << "  " << step.numVoices << " voices: p99 " << String(step.load * 100.0, 1) << "% of the deadline, "
+				  << step.deadlineMisses << " misses" << (step.passed ? "" : ", too many") << std::endl;
+	}
+
+	Result result;
+	result.voiceType = voiceType;
+	result.blockSize = blockSize;
+	result.sampleRate = options.sampleRate;
+	result.maxVoices = voiceCounts.getMaxPassingVoices();
+	result.load = lastPassed.load;
+	result.p99Microseconds = lastPassed.p99Microseconds;
+	result.deadlineMicroseconds = blockSize * 1.0e6 / options.sampleRate;
+	result.numWorkerThreads = numWorkerThreads;
+	result.numSteps = voiceCounts.getNumSteps();
+	return result;
+}
+
+CapacityPlanner::Step CapacityPlanner::measure(SynthEngine::VoiceType voiceType, int blockSize, int numVoices, int& numWorkerThreads)
+{
+	//A fresh engine for every count, as the voices are allocated up front. Its notes and saw are queued,
+	//so they are in place from the first block on.
+	auto engine = createEngine(voiceType, numVoices, options.numWorkerThreads);
+	numWorkerThreads = engine->getNumWorkerThreads();
+	startNotes(*engine, numVoices, 0);
+	engine->prepareToPlay(blockSize, options.sampleRate);
+
+	AudioBuffer<float> buffer(2, blockSize);
+	BlockTimingHistogram blockTimings;
+	auto deadlineMicroseconds = blockSize * 1.0e6 / options.sampleRate;
+
+	auto render = [&] (double seconds)
+	{
+		auto numBlocks = jmax(8, (int)std::ceil(seconds * options.sampleRate / blockSize));
+
+		for (auto block = 0; block < numBlocks; ++block)
+		{
+			engine->getNextAudioBlock(AudioSourceChannelInfo(&buffer, 0, blockSize));
+			blockTimings.drain(engine->getTimingMonitor());
+
+			//one block slower than real time fails the step, however long it would still have run
+			if (blockTimings.getNumDeadlineMisses() > 0)
+				return;
+
+			if (blockTimings.getLastNumVoices() < numVoices)
+				startNotes(*engine, numVoices, blockTimings.getLastNumVoices());
+		}
+	};
+
+	render(warmUpSeconds);
+	blockTimings.reset();
+	render(options.secondsPerStep);
+	engine->releaseResources();
+
+	return judge(numVoices, blockTimings, deadlineMicroseconds, options.targetLoad);
+}
+
+//==============================================================================
+String CapacityPlanner::createCsv() const
+{
+	String csv = "label,voice_type,block_size,sample_rate,target_load,max_voices,load,p99_us,deadline_us,threads,steps\n";
+
+	for (auto& result : results)
+	{
+		csv << options.label.quoted() << "," << getVoiceTypeName(result.voiceType) << "," << result.blockSize << ","
+			<< result.sampleRate << "," << options.targetLoad << "," << result.maxVoices << "," << String(result.load, 4) << ","
+			<< String(result.p99Microseconds, 1) << "," << String(result.deadlineMicroseconds, 1) << ","
+			<< result.numWorkerThreads + 1 << "," << result.numSteps << "\n";
+	}
+
+	return csv;
+}
+
+String CapacityPlanner::createJson() const
+{
+	auto root = BenchmarkReport::createJsonRoot(options.label);
+	root->setProperty("targetLoad", options.targetLoad);
+
+	Array<var> rows;
+
+	for (auto& result : results)
+	{
+		DynamicObject::Ptr row = new DynamicObject();
+		row->setProperty("voiceType", getVoiceTypeName(result.voiceType));
+		row->setProperty("blockSize", result.blockSize);
+		row->setProperty("sampleRate", result.sampleRate);
+		row->setProperty("maxVoices", result.maxVoices);
+		row->setProperty("load", result.load);
+		row->setProperty("p99Microseconds", result.p99Microseconds);
+		row->setProperty("deadlineMicroseconds", result.deadlineMicroseconds);
+		row->setProperty("threads", result.numWorkerThreads + 1);
+		row->setProperty("steps", result.numSteps);
+		rows.add(var(row.get()));
+	}
+
+	root->setProperty("results", rows);
+
+	return JSON::toString(var(root.get())) + "\n";
+}
+
+//==============================================================================
+LiveCapacityTest::LiveCapacityTest(AudioDeviceManager& deviceManagerToUse, double targetLoadToUse, double secondsPerStepToUse,
+								   int maxVoicesToUse)
+	: deviceManager(deviceManagerToUse), targetLoad(targetLoadToUse), secondsPerStep(secondsPerStepToUse), maxVoices(maxVoicesToUse)
+{
+}
+
+LiveCapacityTest::~LiveCapacityTest()
+{
+	stop();
+}
+
+void LiveCapacityTest::start(const Array<SynthEngine::VoiceType>& voiceTypesToUse)
+{
+	stop();
+
+	if (deviceManager.getCurrentAudioDevice() == nullptr || voiceTypesToUse.isEmpty())
+		return;
+
+	voiceTypes = voiceTypesToUse;
+	currentType = 0;
+	search.reset(new VoiceCountSearch(maxVoices));
+	lastPassed = { 0, 0.0, 0.0, 0, false };
+	startStep();
+	startTimer(50);
+}
+
+void LiveCapacityTest::stop()
+{
+	stopTimer();
+
+	//once removed, the device won't call back into the engine again
+	if (engine != nullptr)
+		deviceManager.removeAudioCallback(this);
+
+	engine.reset();
+	search.reset();
+}
+
+void LiveCapacityTest::startStep()
+{
+	auto numVoices = search->getVoiceCount();
+	engine = CapacityPlanner::createEngine(voiceTypes[currentType], numVoices, -1);
+	CapacityPlanner::startNotes(*engine, numVoices, 0);
+	blockTimings.reset();
+	warmingUp = true;
+	stepStartSeconds = Time::getMillisecondCounterHiRes() * 0.001;
+
+	//this calls audioDeviceAboutToStart() first, which prepares the engine for the device
+	deviceManager.addAudioCallback(this);
+}
+
+void LiveCapacityTest::finishStep()
+{
+	deviceManager.removeAudioCallback(this);
+	blockTimings.drain(engine->getTimingMonitor());
+
+	auto numVoices = search->getVoiceCount();
+	auto step = CapacityPlanner::judge(numVoices, blockTimings, blockSize * 1.0e6 / sampleRate, targetLoad,
+									   jmax(0, getXRunCount() - xRunsAtStart));
+	search->addResult(step.passed);
+
+	if (step.passed)
+		lastPassed = step;
+
+	if (onProgress != nullptr)
+		onProgress(CapacityPlanner::getVoiceTypeName(voiceTypes[currentType]) + ": " + String(numVoices) + " voices, p99 "
+				   + String(step.load * 100.0, 1) + "% of the deadline, " + String(step.deadlineMisses) + " misses");
+
+	if (search->isFinished())
+	{
+		CapacityPlanner::Result result;
+		result.voiceType = voiceTypes[currentType];
+		result.blockSize = blockSize;
+		result.sampleRate = sampleRate;
+		result.maxVoices = search->getMaxPassingVoices();
+		result.load = lastPassed.load;
+		result.p99Microseconds = lastPassed.p99Microseconds;
+		result.deadlineMicroseconds = blockSize * 1.0e6 / sampleRate;
+		result.numWorkerThreads = engine->getNumWorkerThreads();
+		result.numSteps = search->getNumSteps();
+
+		if (onResult != nullptr)
+			onResult(result);
+
+		search.reset(new VoiceCountSearch(maxVoices));
+		lastPassed = { 0, 0.0, 0.0, 0, false };
+
+		if (++currentType >= voiceTypes.size())
+		{
+			stop();
+
+			if (onFinished != nullptr)
+				onFinished();
+
+			return;
+		}
+	}
+
+	startStep();
+}
+
+int LiveCapacityTest::getXRunCount() const
+{
+	//not every driver counts its xruns, those report -1
+	auto* device = deviceManager.getCurrentAudioDevice();
+	return device != nullptr ? jmax(0, device->getXRunCount()) : 0;
+}
+
+void LiveCapacityTest::timerCallback()
+{
+	blockTimings.drain(engine->getTimingMonitor());
+
+	//the plucked strings die away, so they get plucked again to keep the count up
+	if (blockTimings.getNumBlocks() > 0 && blockTimings.getLastNumVoices() < search->getVoiceCount())
+		CapacityPlanner::startNotes(*engine, search->getVoiceCount(), blockTimings.getLastNumVoices());
+
+	auto elapsed = Time::getMillisecondCounterHiRes() * 0.001 - stepStartSeconds;
+
+	if (warmingUp)
+	{
+		if (elapsed >= warmUpSeconds)
+		{
+			blockTimings.reset();
+			xRunsAtStart = getXRunCount();
+			stepStartSeconds += elapsed;
+			warmingUp = false;
+		}
+
+		return;
+	}
+
+	//a miss already fails the step, no need to sit through the rest of it
+	if (elapsed >= secondsPerStep || blockTimings.getNumDeadlineMisses() > 0 || getXRunCount() > xRunsAtStart)
+		finishStep();
+}
+
+//==============================================================================
+void LiveCapacityTest::audioDeviceAboutToStart(AudioIODevice* device)
+{
+	blockSize = device->getCurrentBufferSizeSamples();
+	sampleRate = device->getCurrentSampleRate();
+	scratch.setSize(2, jmax(1, blockSize));
+	engine->prepareToPlay(blockSize, sampleRate);
+}
+
+void LiveCapacityTest::audioDeviceIOCallback(const float**, int, float** outputChannelData, int numOutputChannels, int numSamples)
+{
+	//the engine renders into the scratch buffer, in pieces if the driver hands over more than it announced
+	for (auto offset = 0; offset < numSamples; offset += scratch.getNumSamples())
+	{
+		auto numToRender = jmin(scratch.getNumSamples(), numSamples - offset);
+		engine->getNextAudioBlock(AudioSourceChannelInfo(&scratch, 0, numToRender));
+	}
+
+	//the device mixes every callback's output, so this one adds silence
+	for (auto channel = 0; channel < numOutputChannels; ++channel)
+		if (outputChannelData[channel] != nullptr)
+			FloatVectorOperations::clear(outputChannelData[channel], numSamples);
+}
+
+void LiveCapacityTest::audioDeviceStopped()
+{
+	engine->releaseResources();
+}
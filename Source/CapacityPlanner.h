@@ -0,0 +1,191 @@
+/*
+  ==============================================================================
+
+    CapacityPlanner.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "SynthEngine.h"
+
+//Finds the largest voice count that fits one step of a growing voice count at a time: the count doubles until a step
+//fails, then the gap between the last count that passed and the first that failed is halved until it is within
+//about 3% (or a single voice). Whoever drives it measures getVoiceCount() voices and reports back with addResult().
+class VoiceCountSearch
+{
+	public:
+		explicit VoiceCountSearch(int maxVoices);
+
+		//the voice count to measure next
+		int getVoiceCount() const noexcept		{ return next; }
+
+		void addResult(bool passed) noexcept;
+		bool isFinished() const noexcept		{ return finished; }
+
+		//the largest count that passed, 0 if even a single voice didn't
+		int getMaxPassingVoices() const noexcept	{ return largestPassing; }
+		int getNumSteps() const noexcept		{ return numSteps; }
+
+	private:
+		const int maxVoices;
+		int next = 1, largestPassing = 0, smallestFailing, numSteps = 0;
+		bool finished = false;
+};
+
+//==============================================================================
+//Sizes hardware: for each voice type and block size it searches for the largest voice count whose callbacks stay under
+//a target share of the block deadline without a single miss, e.g.
+//
+//	AudioApp_juce --stress --types wavetable,polyblep --blocksizes 64,128,256 --load 0.7
+//
+//Headlessly the engine is pulled back to back, so the figures are what the CPU manages with the device out of the
+//picture; LiveCapacityTest runs the same search through the sound card from the GUI.
+//
+//A step passes if its 99th percentile callback takes at most the target share of the deadline and none took longer
+//than the deadline itself. The percentile rather than the average, because it is the slow blocks that drop out.
+class CapacityPlanner
+{
+	public:
+		struct Options
+		{
+			Array<SynthEngine::VoiceType> voiceTypes { SynthEngine::VoiceType::sine, SynthEngine::VoiceType::wavetable,
+													   SynthEngine::VoiceType::pluckedString, SynthEngine::VoiceType::polyBlep,
+													   SynthEngine::VoiceType::oversampled };
+			Array<int> blockSizes { 64, 128, 256, 512 };
+			double sampleRate = 48000.0;
+			double targetLoad = 0.7;		//share of the block deadline the callbacks may take
+			double secondsPerStep = 1.0;	//audio rendered for each voice count
+			int maxVoices = 4096;
+			int numWorkerThreads = -1;		//-1 lets the engine decide, as in the GUI
+			bool json = false;
+			File outputFile;				//stdout if not set
+			String label;					//free text stored with every result, e.g. the machine's name
+		};
+
+		//the outcome of one search
+		struct Result
+		{
+			SynthEngine::VoiceType voiceType;
+			int blockSize;
+			double sampleRate;
+			int maxVoices;					//the largest count that passed, 0 if none did
+			double load;					//p99 callback time over the deadline at maxVoices
+			double p99Microseconds;
+			double deadlineMicroseconds;
+			int numWorkerThreads;
+			int numSteps;
+		};
+
+		//one voice count measured, and whether it fits
+		struct Step
+		{
+			int numVoices;
+			double load;
+			double p99Microseconds;
+			int64 deadlineMisses;
+			bool passed;
+		};
+
+		//true if the command line asks for the stress test instead of the GUI
+		static bool isStressCommandLine(const String& commandLine);
+
+		//fills options from the command line; returns false and describes the problem in errorMessage if it can't
+		static bool parseCommandLine(const String& commandLine, Options& options, String& errorMessage);
+
+		//the names --types takes; the wavetable bank voices are left out, they need a file and play like the wavetable ones
+		static String getVoiceTypeName(SynthEngine::VoiceType voiceType);
+
+		//An engine set up the way the search measures it: saws for the wavetable, PolyBLEP and oversampled voices,
+		//so every level of the tables is busy, and everything else at the engine's defaults.
+		static std::unique_ptr<SynthEngine> createEngine(SynthEngine::VoiceType voiceType, int numVoices, int numWorkerThreads);
+
+		//Starts notes until the engine plays numVoices, spread over five octaves from C2; playingVoices is how many it
+		//already plays. Plucked strings die away by themselves, so the search keeps topping them up with this.
+		static void startNotes(SynthEngine& engine, int numVoices, int playingVoices);
+
+		//judges the blocks timed at numVoices; extraMisses are dropouts the device reported on top of the engine's own
+		static Step judge(int numVoices, const BlockTimingHistogram& blockTimings, double deadlineMicroseconds,
+						  double targetLoad, int64 extraMisses = 0);
+
+		explicit CapacityPlanner(const Options& optionsToUse);
+
+		//runs every search and writes the results; returns the process exit code
+		int run();
+
+	private:
+		Result search(SynthEngine::VoiceType voiceType, int blockSize);
+		Step measure(SynthEngine::VoiceType voiceType, int blockSize, int numVoices, int& numWorkerThreads);
+
+		String createCsv() const;
+		String createJson() const;
+
+		Options options;
+		Array<Result> results;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CapacityPlanner)
+};
+
+//==============================================================================
+//The same search through the sound card, for the GUI: each step plays a separate engine as a second callback on the
+//device, next to whatever the app is playing, at the device's own block size and sample rate. Its output is thrown
+//away, so the steps can't be heard. Besides the engine's own deadline misses, the xruns the driver counts fail a step.
+//
+//Everything here runs on the message thread; a step's engine is only swapped while it isn't registered with the device.
+class LiveCapacityTest  : public AudioIODeviceCallback,
+						  private Timer
+{
+	public:
+		LiveCapacityTest(AudioDeviceManager& deviceManagerToUse, double targetLoad = 0.7, double secondsPerStep = 1.0,
+						 int maxVoices = 4096);
+		~LiveCapacityTest();
+
+		//searches each of the voice types in turn at the current device settings; does nothing if no device is open
+		void start(const Array<SynthEngine::VoiceType>& voiceTypes);
+		void stop();
+		bool isRunning() const noexcept		{ return engine != nullptr; }
+		double getTargetLoad() const noexcept	{ return targetLoad; }
+
+		//called after every step with a line describing it, and with every finished search
+		std::function<void(const String&)> onProgress;
+		std::function<void(const CapacityPlanner::Result&)> onResult;
+		std::function<void()> onFinished;
+
+		//==============================================================================
+		void audioDeviceIOCallback(const float** inputChannelData, int numInputChannels,
+								   float** outputChannelData, int numOutputChannels, int numSamples) override;
+		void audioDeviceAboutToStart(AudioIODevice* device) override;
+		void audioDeviceStopped() override;
+
+	private:
+		//checks on the running step, and moves on to the next once it has played for long enough
+		void timerCallback() override;
+
+		void startStep();
+		void finishStep();
+		int getXRunCount() const;
+
+		AudioDeviceManager& deviceManager;
+		const double targetLoad, secondsPerStep;
+		const int maxVoices;
+
+		Array<SynthEngine::VoiceType> voiceTypes;
+		int currentType = 0;
+		std::unique_ptr<VoiceCountSearch> search;
+
+		std::unique_ptr<SynthEngine> engine;
+		AudioBuffer<float> scratch;
+		BlockTimingHistogram blockTimings;
+		int blockSize = 0;
+		double sampleRate = 0.0;
+		double stepStartSeconds = 0.0;
+		int xRunsAtStart = 0;
+		bool warmingUp = false;
+
+		//the last step that passed, for the result
+		CapacityPlanner::Step lastPassed;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LiveCapacityTest)
+};
@@ -0,0 +1,231 @@
+/*
+  ==============================================================================
+
+    EventLog.cpp
+
+  ==============================================================================
+*/
+
+#include "EventLog.h"
+
+//"AAEL" at the start of every log
+static const int logMagic = 0x4c454141;
+
+//how the records are tagged in the stream; a run of equal blocks gets a tag of its own
+enum RecordTag
+{
+	prepareTag = 0,
+	blockRunTag,
+	parameterTag,
+	wavetableTag,
+	gapTag
+};
+
+//==============================================================================
+EventRecorder::EventRecorder(int capacity)
+	: records(capacity)
+{
+}
+
+void EventRecorder::add(const EventLogRecord& record) noexcept
+{
+	if (! records.push(record))
+		numDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool EventRecorder::pop(EventLogRecord& record) noexcept
+{
+	return records.pop(record);
+}
+
+//==============================================================================
+EventLogWriter::EventLogWriter(OutputStream* streamToUse, const EventLogHeader& header)
+	: stream(streamToUse)
+{
+	stream->writeInt(logMagic);
+	stream->writeCompressedInt(EventLogReader::formatVersion);
+	stream->writeCompressedInt(header.voiceType);
+	stream->writeCompressedInt(header.numVoices);
+	stream->writeCompressedInt(header.numWorkerThreads);
+	stream->writeInt64(header.randomSeed);
+}
+
+EventLogWriter::~EventLogWriter()
+{
+	flush();
+}
+
+void EventLogWriter::drain(EventRecorder& recorder)
+{
+	//A record lost while the queue was full would put the replay out of step, so the gap is marked in the log
+	//rather than left for the replay to stumble over. The records already queued still came before it.
+	auto dropped = recorder.getNumDropped();
+	EventLogRecord record;
+
+	while (recorder.pop(record))
+		write(record);
+
+	if (dropped > droppedSoFar)
+	{
+		droppedSoFar = dropped;
+		EventLogRecord gap;
+		gap.kind = EventLogRecord::Kind::gap;
+		write(gap);
+	}
+}
+
+void EventLogWriter::write(const EventLogRecord& record)
+{
+	if (record.kind == EventLogRecord::Kind::block)
+	{
+		if (runLength > 0 && record.numSamples != runSamples)
+			writeBlockRun();
+
+		runSamples = record.numSamples;
+		++runLength;
+		return;
+	}
+
+	writeBlockRun();
+
+	switch (record.kind)
+	{
+		case EventLogRecord::Kind::prepare:
+			stream->writeByte((char)prepareTag);
+			stream->writeCompressedInt(record.numSamples);
+			stream->writeDouble(record.sampleRate);
+			stream->writeByte((char)record.kernelLevel);
+			break;
+
+		case EventLogRecord::Kind::parameter:
+			stream->writeByte((char)parameterTag);
+			stream->writeCompressedInt(record.sampleOffset);
+			stream->writeByte((char)record.event.type);
+			stream->writeFloat(record.event.value);
+
+			//only the notes carry a note number, and only note on a velocity
+			if (record.event.type == ParameterEvent::Type::noteOn || record.event.type == ParameterEvent::Type::noteOff)
+				stream->writeCompressedInt(record.event.noteNumber);
+
+			if (record.event.type == ParameterEvent::Type::noteOn)
+				stream->writeFloat(record.event.velocity);
+			break;
+
+		case EventLogRecord::Kind::wavetable:
+			stream->writeByte((char)wavetableTag);
+			stream->writeCompressedInt(record.sampleOffset);
+			stream->writeByte((char)record.shape);
+			stream->writeCompressedInt(record.tableSize);
+			break;
+
+		case EventLogRecord::Kind::gap:
+			stream->writeByte((char)gapTag);
+			break;
+
+		case EventLogRecord::Kind::block:
+		default:
+			break;
+	}
+}
+
+void EventLogWriter::writeBlockRun()
+{
+	if (runLength == 0)
+		return;
+
+	stream->writeByte((char)blockRunTag);
+	stream->writeCompressedInt(runSamples);
+	stream->writeCompressedInt(runLength);
+	runLength = 0;
+}
+
+void EventLogWriter::flush()
+{
+	writeBlockRun();
+	stream->flush();
+}
+
+//==============================================================================
+EventLogReader::EventLogReader(InputStream* streamToUse)
+	: stream(streamToUse)
+{
+	if (stream->readInt() != logMagic || stream->readCompressedInt() != formatVersion)
+		return;
+
+	header.voiceType = stream->readCompressedInt();
+	header.numVoices = stream->readCompressedInt();
+	header.numWorkerThreads = stream->readCompressedInt();
+	header.randomSeed = stream->readInt64();
+	valid = header.numVoices > 0;
+}
+
+bool EventLogReader::readNext(EventLogRecord& record)
+{
+	if (! valid)
+		return false;
+
+	record = EventLogRecord();
+	record.samplePosition = samplePosition;
+
+	//the rest of a run of blocks comes first
+	if (runRemaining > 0)
+	{
+		--runRemaining;
+		record.kind = EventLogRecord::Kind::block;
+		record.numSamples = runSamples;
+		samplePosition += runSamples;
+		return true;
+	}
+
+	if (stream->isExhausted())
+		return false;
+
+	switch (stream->readByte())
+	{
+		case prepareTag:
+			record.kind = EventLogRecord::Kind::prepare;
+			record.numSamples = stream->readCompressedInt();
+			record.sampleRate = stream->readDouble();
+			record.kernelLevel = stream->readByte();
+			return true;
+
+		case blockRunTag:
+			runSamples = stream->readCompressedInt();
+			runRemaining = stream->readCompressedInt();
+
+			if (runSamples <= 0 || runRemaining <= 0)
+				return false;
+
+			return readNext(record);
+
+		case parameterTag:
+			record.kind = EventLogRecord::Kind::parameter;
+			record.sampleOffset = stream->readCompressedInt();
+			record.samplePosition += record.sampleOffset;
+			record.event.type = (ParameterEvent::Type)stream->readByte();
+			record.event.value = stream->readFloat();
+
+			if (record.event.type == ParameterEvent::Type::noteOn || record.event.type == ParameterEvent::Type::noteOff)
+				record.event.noteNumber = stream->readCompressedInt();
+
+			if (record.event.type == ParameterEvent::Type::noteOn)
+				record.event.velocity = stream->readFloat();
+			return true;
+
+		case wavetableTag:
+			record.kind = EventLogRecord::Kind::wavetable;
+			record.sampleOffset = stream->readCompressedInt();
+			record.samplePosition += record.sampleOffset;
+			record.shape = stream->readByte();
+			record.tableSize = stream->readCompressedInt();
+			return true;
+
+		case gapTag:
+			record.kind = EventLogRecord::Kind::gap;
+			return true;
+
+		default:
+			//written by a newer version, or damaged
+			return false;
+	}
+}
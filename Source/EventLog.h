@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    EventLog.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "ParameterQueue.h"
+
+
+//One entry of an event log, in the order the audio thread saw it. A parameter or wavetable record is stamped with the
+//sample of the next block it was applied at, so its sample position is the sum of the blocks before it plus that offset.
+//Anything applied before a prepare record belongs to the start of it.
+struct EventLogRecord
+{
+	enum class Kind
+	{
+		prepare,	//prepareToPlay() ran; blockSize, sampleRate and kernelLevel
+		block,		//a block of numSamples was rendered
+		parameter,	//event came out of the parameter queue, or a MIDI note was handled, at sampleOffset
+		wavetable,	//the wavetable voices switched to the set for shape and tableSize, at sampleOffset
+		gap			//the recorder overflowed here and lost records, so the replay won't match from this point on
+	};
+
+	Kind kind = Kind::block;
+	ParameterEvent event { ParameterEvent::Type::frequency, 0.0f };
+	int numSamples = 0;		//block: the samples rendered; prepare: the block size prepareToPlay() was given
+	double sampleRate = 0.0;
+	int kernelLevel = 0;	//a KernelDispatch::Level, after the self-benchmark had its say
+	int shape = 0, tableSize = 0;
+	int sampleOffset = 0;		//parameter and wavetable: from the first sample of the next block
+	int64 samplePosition = 0;	//filled in by EventLogReader: the block's first sample, plus sampleOffset
+};
+
+//what a replay needs to build the same engine
+struct EventLogHeader
+{
+	int voiceType = 0;		//a SynthEngine::VoiceType
+	int numVoices = 0;
+	int numWorkerThreads = 0;	//the chunks the voices are split into depend on it, and so do the rounding errors
+	int64 randomSeed = 0;
+};
+
+//==============================================================================
+//Single-producer/single-consumer lock-free queue of log records, like BlockTimingMonitor: the audio thread adds
+//what it applies and renders, the message thread drains it into an EventLogWriter.
+//All storage is allocated in the constructor, and nothing is added unless recording is enabled.
+class EventRecorder
+{
+	public:
+		//a few seconds of 16 sample blocks with their events, much longer than the GUI ever takes between two drains
+		explicit EventRecorder(int capacity = 16384);
+
+		//Enable before the device starts, so the log begins with the engine's first prepareToPlay() and a replay
+		//can start from a freshly constructed engine.
+		void setEnabled(bool shouldRecord) noexcept		{ enabled.store(shouldRecord, std::memory_order_release); }
+		bool isEnabled() const noexcept					{ return enabled.load(std::memory_order_acquire); }
+
+		//audio thread only; the record is dropped (and counted) if the message thread has stopped draining
+		void add(const EventLogRecord& record) noexcept;
+
+		//message thread only; returns false once the queue is empty
+		bool pop(EventLogRecord& record) noexcept;
+
+		int getNumDropped() const noexcept { return numDropped.load(std::memory_order_relaxed); }
+
+	private:
+		SpscQueue<EventLogRecord> records;
+		std::atomic<bool> enabled { false };
+		std::atomic<int> numDropped { 0 };
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EventRecorder)
+};
+
+//==============================================================================
+//Message thread side: writes the drained records to a compact binary stream. Runs of equal blocks are stored as one
+//record with a count, so a steady device costs a few bytes per drain rather than per block.
+class EventLogWriter
+{
+	public:
+		//takes ownership of the stream and writes the header straight away
+		EventLogWriter(OutputStream* streamToUse, const EventLogHeader& header);
+		~EventLogWriter();
+
+		//writes everything the audio thread has recorded since the last call
+		void drain(EventRecorder& recorder);
+		void write(const EventLogRecord& record);
+
+		//writes out the pending run of blocks and flushes the stream
+		void flush();
+
+	private:
+		void writeBlockRun();
+
+		std::unique_ptr<OutputStream> stream;
+		int runSamples = 0, runLength = 0;
+		int droppedSoFar = 0;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EventLogWriter)
+};
+
+//==============================================================================
+//Reads a log back one record at a time, so an hour of blocks never has to be held in memory.
+class EventLogReader
+{
+	public:
+		//takes ownership of the stream; check isValid() before reading on
+		explicit EventLogReader(InputStream* streamToUse);
+
+		bool isValid() const noexcept					{ return valid; }
+		const EventLogHeader& getHeader() const noexcept	{ return header; }
+
+		//returns false at the end of the log, or at a record it doesn't understand
+		bool readNext(EventLogRecord& record);
+
+		//2 added the sample offsets
+		static constexpr int formatVersion = 2;
+
+	private:
+		std::unique_ptr<InputStream> stream;
+		EventLogHeader header;
+		bool valid = false;
+		int runSamples = 0, runRemaining = 0;
+		int64 samplePosition = 0;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EventLogReader)
+};
@@ -0,0 +1,301 @@
+/*
+  ==============================================================================
+
+    EventLogPlayer.cpp
+
+  ==============================================================================
+*/
+
+#include "EventLogPlayer.h"
+#include <iostream>
+
+//the engine always renders in stereo, like the device callback
+static const int numChannels = 2;
+
+//FNV-1a over the bits of the samples, so any difference in any sample changes it
+static void addToChecksum(uint64& checksum, const float* samples, int numSamples) noexcept
+{
+	for (auto i = 0; i < numSamples; ++i)
+	{
+		uint32 bits;
+		std::memcpy(&bits, samples + i, sizeof(bits));
+		checksum = (checksum ^ bits) * 0x100000001b3ull;
+	}
+}
+
+//==============================================================================
+bool EventLogPlayer::isReplayCommandLine(const String& commandLine)
+{
+	return StringArray::fromTokens(commandLine, true).contains("--replay");
+}
+
+bool EventLogPlayer::parseCommandLine(const String& commandLine, Options& options, String& errorMessage)
+{
+	auto args = StringArray::fromTokens(commandLine, true);
+
+	for (auto i = 0; i < args.size(); ++i)
+	{
+		auto arg = args[i];
+
+		//every option takes exactly one value
+		if (i + 1 >= args.size())
+		{
+			errorMessage = "Missing value for " + arg;
+			return false;
+		}
+
+		auto value = args[++i].unquoted();
+
+		if (arg == "--replay")
+			options.logFile = File::getCurrentWorkingDirectory().getChildFile(value);
+		else if (arg == "--output")
+			options.outputFile = File::getCurrentWorkingDirectory().getChildFile(value);
+		else if (arg == "--repeat")
+			options.numRepeats = value.getIntValue();
+		else
+		{
+			errorMessage = "Unknown option " + arg;
+			return false;
+		}
+	}
+
+	if (options.numRepeats < 1)
+		errorMessage = "--repeat has to be at least 1";
+
+	return errorMessage.isEmpty();
+}
+
+//==============================================================================
+EventLogPlayer::EventLogPlayer(const Options& optionsToUse)
+	: options(optionsToUse)
+{
+}
+
+int EventLogPlayer::run()
+{
+	auto initialKernel = KernelDispatch::getActiveLevel();
+	BlockTimingHistogram blockTimings;
+	int64 numSamples = 0, renderTicks = 0;
+	uint64 firstChecksum = 0;
+	String errorMessage;
+
+	for (auto pass = 0; pass < options.numRepeats; ++pass)
+	{
+		//Every pass starts from a fresh engine with the log's seed, so they all have to come out the same.
+		//If they don't, something in the engine depends on more than the log, and the replay can't be trusted.
+		uint64 checksum = 0xcbf29ce484222325ull;
+
+		if (! play(pass == 0, checksum, numSamples, renderTicks, blockTimings, errorMessage))
+		{
+			std::cerr << errorMessage << std::endl;
+			KernelDispatch::setActiveLevel(initialKernel);
+			return 1;
+		}
+
+		if (pass == 0)
+		{
+			firstChecksum = checksum;
+		}
+		else if (checksum != firstChecksum)
+		{
+			std::cerr << "Pass " << pass + 1 << " came out different from the first, the replay isn't deterministic" << std::endl;
+			KernelDispatch::setActiveLevel(initialKernel);
+			return 1;
+		}
+	}
+
+	auto renderSeconds = Time::highResolutionTicksToSeconds(renderTicks);
+
+	std::cout << "Replayed " << options.logFile.getFileName() << " " << options.numRepeats << " times, "
+			  << numSamples << " samples in " << blockTimings.getNumBlocks() << " blocks" << std::endl
+			  << "checksum: " << String::toHexString((int64)firstChecksum) << std::endl
+			  << "engine:   " << renderSeconds << " s, min " << blockTimings.getMinMicroseconds() << " / avg " << blockTimings.getAverageMicroseconds()
+			  << " / p99 " << blockTimings.getPercentileMicroseconds(99.0) << " / max " << blockTimings.getMaxMicroseconds() << " us per block, "
+			  << blockTimings.getNumDeadlineMisses() << " slower than real time" << std::endl
+			  << "kernel:   " << KernelDispatch::getDescription() << std::endl;
+
+	KernelDispatch::setActiveLevel(initialKernel);
+	return 0;
+}
+
+bool EventLogPlayer::play(bool writeOutput, uint64& checksum, int64& numSamples, int64& renderTicks,
+						  BlockTimingHistogram& blockTimings, String& errorMessage)
+{
+	std::unique_ptr<FileInputStream> file(new FileInputStream(options.logFile));
+
+	if (file->failedToOpen())
+	{
+		errorMessage = "Couldn't open " + options.logFile.getFullPathName();
+		return false;
+	}
+
+	//the records are a few bytes each, so they are read from a buffer rather than straight from the file
+	EventLogReader reader(new BufferedInputStream(file.release(), 1 << 16, true));
+	auto& header = reader.getHeader();
+
+	if (! reader.isValid() || ! isPositiveAndBelow(header.voiceType, (int)SynthEngine::VoiceType::wavetableBank + 1))
+	{
+		errorMessage = options.logFile.getFullPathName() + " isn't an event log this version can read";
+		return false;
+	}
+
+	if (header.voiceType == (int)SynthEngine::VoiceType::wavetableBank)
+	{
+		errorMessage = "Sessions with the wavetable bank voices can't be replayed, the bank isn't in the log";
+		return false;
+	}
+
+	SynthEngine engine(header.numVoices, (SynthEngine::VoiceType)header.voiceType, header.numWorkerThreads);
+	engine.setRandomSeed(header.randomSeed);
+
+	AudioBuffer<float> buffer(numChannels, 512);
+	std::unique_ptr<AudioFormatWriter> writer;
+	auto reportedGap = false;
+	EventLogRecord record;
+
+	//the parameter and wavetable records wait here for the block or prepare record they belong to
+	Array<EventLogRecord> pendingRecords;
+
+	auto replayPending = [&] (int upToOffset)
+	{
+		while (! pendingRecords.isEmpty() && pendingRecords.getReference(0).sampleOffset <= upToOffset)
+		{
+			auto& pending = pendingRecords.getReference(0);
+
+			if (! engine.replayRecord(pending))
+			{
+				errorMessage = "More events at sample " + String(pending.samplePosition) + " than the parameter queue holds";
+				return false;
+			}
+
+			pendingRecords.remove(0);
+		}
+
+		return true;
+	};
+
+	while (reader.readNext(record))
+	{
+		//blocks longer than announced are rare, so the buffer only grows when one turns up
+		if (record.numSamples > buffer.getNumSamples())
+			buffer.setSize(numChannels, record.numSamples);
+
+		switch (record.kind)
+		{
+			case EventLogRecord::Kind::parameter:
+			case EventLogRecord::Kind::wavetable:
+				pendingRecords.add(record);
+				break;
+
+			case EventLogRecord::Kind::prepare:
+			{
+				auto level = (KernelDispatch::Level)record.kernelLevel;
+
+				if (! KernelDispatch::isSupported(level))
+				{
+					errorMessage = "The log was recorded with the " + String(KernelDispatch::getLevelName(level)) + " kernels, which this machine can't run";
+					return false;
+				}
+
+				//whatever came in before a device start was applied by it, whatever offset it was stamped with
+				if (! replayPending(std::numeric_limits<int>::max()))
+					return false;
+
+				KernelDispatch::setActiveLevel(level);
+				engine.prepareToPlay(record.numSamples, record.sampleRate);
+
+				//the wav file starts at the rate of the first device start
+				if (writeOutput && writer == nullptr && options.outputFile.getFullPathName().isNotEmpty())
+				{
+					options.outputFile.deleteFile();
+					std::unique_ptr<FileOutputStream> stream(new FileOutputStream(options.outputFile));
+					WavAudioFormat wavFormat;
+
+					if (! stream->failedToOpen())
+						writer.reset(wavFormat.createWriterFor(stream.get(), record.sampleRate, (unsigned int)numChannels, 24, {}, 0));
+
+					if (writer == nullptr)
+					{
+						errorMessage = "Couldn't create a wav writer for " + options.outputFile.getFullPathName();
+						return false;
+					}
+
+					//the writer owns the stream from here on
+					stream.release();
+				}
+				break;
+			}
+
+			case EventLogRecord::Kind::block:
+			{
+				//The block is rendered in pieces that end where the next records were applied, so each one reaches the
+				//engine at the start of the sub-block it was recorded at. The engine's sub-blocks carry over between calls,
+				//so splitting a block there doesn't change a sample; the pieces are timed as the one block they make up.
+				BlockTimingRecord blockTiming {};
+				auto position = 0;
+
+				for (;;)
+				{
+					if (! replayPending(position))
+						return false;
+
+					auto end = pendingRecords.isEmpty() ? record.numSamples
+														: jmin(pendingRecords.getReference(0).sampleOffset, record.numSamples);
+
+					if (end > position)
+					{
+						AudioSourceChannelInfo info(&buffer, position, end - position);
+
+						auto pieceStart = Time::getHighResolutionTicks();
+						engine.getNextAudioBlock(info);
+						renderTicks += Time::getHighResolutionTicks() - pieceStart;
+
+						BlockTimingRecord pieceTiming;
+
+						while (engine.getTimingMonitor().pop(pieceTiming))
+						{
+							blockTiming.durationTicks += pieceTiming.durationTicks;
+							blockTiming.deadlineTicks += pieceTiming.deadlineTicks;
+							blockTiming.numVoices = jmax(blockTiming.numVoices, pieceTiming.numVoices);
+						}
+
+						//the GUI's timer does this live; without it the engine holds on to the old table once its retired sets fill up
+						engine.collectGarbage();
+						position = end;
+					}
+
+					if (position >= record.numSamples)
+						break;
+				}
+
+				blockTiming.numSamples = record.numSamples;
+				blockTimings.addRecord(blockTiming);
+
+				for (auto channel = 0; channel < numChannels; ++channel)
+					addToChecksum(checksum, buffer.getReadPointer(channel), record.numSamples);
+
+				numSamples += record.numSamples;
+
+				if (writer != nullptr && ! writer->writeFromAudioSampleBuffer(buffer, 0, record.numSamples))
+				{
+					errorMessage = "Writing to " + options.outputFile.getFullPathName() + " failed";
+					return false;
+				}
+				break;
+			}
+
+			case EventLogRecord::Kind::gap:
+				if (! reportedGap)
+					std::cerr << "The recording lost records at sample " << record.samplePosition << ", the replay differs from there on" << std::endl;
+
+				reportedGap = true;
+				break;
+
+			default:
+				break;
+		}
+	}
+
+	engine.releaseResources();
+	return true;
+}
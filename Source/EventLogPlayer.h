@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    EventLogPlayer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "SynthEngine.h"
+
+//Replays an event log recorded by the GUI (AudioApp_juce --record session.aelog) through a fresh engine, without a
+//window or an audio device, e.g.
+//
+//	AudioApp_juce --replay session.aelog --output session.wav
+//
+//The engine is built like the recording one, from the log's header, and is handed every block, note, parameter change
+//and wavetable switch at the sample it came in, on the same kernels. So the output is bit for bit what the device
+//played, rendered as fast as the engine will go, and a dropout seen live can be profiled under perf on another machine.
+//The checksum it prints tells two replays apart, e.g. before and after an optimisation that shouldn't change the sound.
+class EventLogPlayer
+{
+	public:
+		struct Options
+		{
+			File logFile;
+			File outputFile;		//a wav file, or nothing to only render
+			int numRepeats = 1;		//plays the log this many times over, each from a fresh engine, for longer profiles
+		};
+
+		//true if the command line asks for a replay instead of the GUI
+		static bool isReplayCommandLine(const String& commandLine);
+
+		//fills options from the command line; returns false and describes the problem in errorMessage if it can't
+		static bool parseCommandLine(const String& commandLine, Options& options, String& errorMessage);
+
+		explicit EventLogPlayer(const Options& optionsToUse);
+
+		//replays the whole log and prints the throughput and checksum; returns the process exit code
+		int run();
+
+	private:
+		//one pass over the log, adding to the checksum, the sample count, the render time and the block timings
+		bool play(bool writeOutput, uint64& checksum, int64& numSamples, int64& renderTicks,
+				  BlockTimingHistogram& blockTimings, String& errorMessage);
+
+		Options options;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EventLogPlayer)
+};
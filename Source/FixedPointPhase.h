@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    FixedPointPhase.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+
+//Phases as unsigned 32-bit fractions of a cycle: 2^32 is one whole period, so adding the increment wraps
+//by itself through the integer overflow, with no compare, no subtraction and no drift however long a note plays.
+//For a table of 2^k samples the top k bits are the index and the other 32 - k bits are the interpolation
+//fraction, so the same phase works for any power-of-two table size and switching size never touches it.
+struct FixedPointPhase
+{
+	//one whole cycle, as a double so the conversions keep every bit
+	static constexpr double unitsPerCycle = 4294967296.0;
+
+	//The increment for a frequency, rounded to a whole number of units. The pitch error of the rounding is
+	//below a millionth of a cent at audio rates. It's limited to just under Nyquist, so it also fits a signed
+	//int32, which is what the SIMD conversions from float produce.
+	static uint32 getIncrement(double frequency, double sampleRate) noexcept
+	{
+		if (sampleRate <= 0.0)
+			return 0;
+
+		auto increment = std::round(frequency / sampleRate * unitsPerCycle);
+		return (uint32)jlimit(0.0, (double)maxIncrement, increment);
+	}
+
+	//how many samples of a tableSize table an increment moves through, for picking the mipmap level
+	static float getTableDelta(float increment, int tableSize) noexcept
+	{
+		return (float)(increment * (tableSize / unitsPerCycle));
+	}
+
+	//right shift that leaves the index into a table of tableSize (a power of two) samples
+	static int getIndexShift(int tableSize) noexcept
+	{
+		jassert(isPowerOfTwo(tableSize) && tableSize >= 2);
+
+		auto bits = 0;
+		while ((1 << bits) < tableSize)
+			++bits;
+
+		return 32 - bits;
+	}
+
+	//the bits below the index, and the scale that turns them into a 0..1 interpolation fraction
+	static uint32 getFractionMask(int indexShift) noexcept	{ return (uint32)((1ull << indexShift) - 1); }
+	static float getFractionScale(int indexShift) noexcept	{ return 1.0f / (float)(1ull << indexShift); }
+
+	//the largest float below 2^31 (Nyquist), so an increment ramped as a float still converts to a positive int32
+	static constexpr uint32 maxIncrement = 0x7fffff80u;
+};
@@ -0,0 +1,238 @@
+/*
+  ==============================================================================
+
+    HalfbandDecimator.cpp
+
+  ==============================================================================
+*/
+
+#include "HalfbandDecimator.h"
+#include "SimdConfig.h"
+#include "KernelDispatch.h"
+
+//modified Bessel function of the first kind, order 0, for the Kaiser window
+static double besselI0(double x)
+{
+	auto sum = 1.0, term = 1.0;
+
+	for (auto k = 1; term > 1.0e-12 * sum; ++k)
+	{
+		auto factor = x / (2.0 * k);
+		term *= factor * factor;
+		sum += term;
+	}
+
+	return sum;
+}
+
+//The odd-phase taps of a Kaiser-windowed half-band sinc. The window is made as strong as the transition band
+//between passbandEdge and its mirror image allows (Kaiser's formula), and the taps are scaled to a DC gain of 1.
+static void designHalfband(float* coefficients, int numTaps, double passbandEdge)
+{
+	auto halfLength = (double)(numTaps - 1);
+	auto transitionWidth = 0.5 - 2.0 * passbandEdge;
+	auto attenuation = 2.285 * 2.0 * halfLength * MathConstants<double>::twoPi * transitionWidth + 7.95;
+	auto beta = attenuation > 50.0 ? 0.1102 * (attenuation - 8.7)
+			  : attenuation > 21.0 ? 0.5842 * std::pow(attenuation - 21.0, 0.4) + 0.07886 * (attenuation - 21.0)
+			  : 0.0;
+
+	HeapBlock<double> taps((size_t)numTaps);
+	auto sum = 0.0;
+
+	for (auto k = 0; k < numTaps; ++k)
+	{
+		//tap k sits at the odd offset n from the centre, from numTaps - 1 down to -(numTaps - 1)
+		auto n = (double)(numTaps - 1 - 2 * k);
+		auto r = n / halfLength;
+		auto window = besselI0(beta * std::sqrt(jmax(0.0, 1.0 - r * r))) / besselI0(beta);
+		taps[k] = std::sin(MathConstants<double>::halfPi * n) / (MathConstants<double>::pi * n) * window;
+		sum += taps[k];
+	}
+
+	//the centre tap is 1/2, so the odd ones have to add up to the other half
+	for (auto k = 0; k < numTaps; ++k)
+		coefficients[k] = (float)(taps[k] * 0.5 / sum);
+}
+
+//Output m is half the even sample m plus the symmetric filter over odd samples m .. m + numTaps - 1, whose mirrored
+//pairs are added before they are multiplied. The outputs are independent, so 8 (AVX2) or 4 (SSE2) are computed
+//side by side from unaligned loads. Each returns how many samples it wrote and leaves the tail to the caller.
+#if AUDIOAPP_HAS_AVX2
+AUDIOAPP_TARGET_AVX2 static int filterAVX2(const float* odd, const float* even, const float* coefficients, int numTaps,
+										   float* output, int numOutputSamples) noexcept
+{
+	const auto half = _mm256_set1_ps(0.5f);
+	auto sample = 0;
+
+	for (; sample + 8 <= numOutputSamples; sample += 8)
+	{
+		auto sum = _mm256_mul_ps(half, _mm256_loadu_ps(even + sample));
+		auto* first = odd + sample;
+		auto* last = odd + sample + numTaps - 1;
+
+		for (auto k = 0; k < numTaps / 2; ++k)
+		{
+			auto pair = _mm256_add_ps(_mm256_loadu_ps(first + k), _mm256_loadu_ps(last - k));
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(coefficients[k]), pair));
+		}
+
+		_mm256_storeu_ps(output + sample, sum);
+	}
+
+	_mm256_zeroupper();
+	return sample;
+}
+#endif
+
+#if AUDIOAPP_HAS_SSE2
+static int filterSSE2(const float* odd, const float* even, const float* coefficients, int numTaps,
+					  float* output, int numOutputSamples) noexcept
+{
+	const auto half = _mm_set1_ps(0.5f);
+	auto sample = 0;
+
+	for (; sample + 4 <= numOutputSamples; sample += 4)
+	{
+		auto sum = _mm_mul_ps(half, _mm_loadu_ps(even + sample));
+		auto* first = odd + sample;
+		auto* last = odd + sample + numTaps - 1;
+
+		for (auto k = 0; k < numTaps / 2; ++k)
+		{
+			auto pair = _mm_add_ps(_mm_loadu_ps(first + k), _mm_loadu_ps(last - k));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(coefficients[k]), pair));
+		}
+
+		_mm_storeu_ps(output + sample, sum);
+	}
+
+	return sample;
+}
+#endif
+
+//==============================================================================
+HalfbandDecimator::Stage::Stage(int numTapsToUse, double passbandEdge)
+	: numTaps(numTapsToUse)
+{
+	jassert(numTaps >= 2 && numTaps % 2 == 0);
+
+	coefficients.allocate((size_t)numTaps, true);
+	designHalfband(coefficients, numTaps, passbandEdge);
+}
+
+void HalfbandDecimator::Stage::prepare(int maxOutputSamples)
+{
+	if (maxOutputSamples <= capacity)
+		return;
+
+	capacity = maxOutputSamples;
+	oddSamples.allocate((size_t)(numTaps + capacity), true);
+	evenSamples.allocate((size_t)(numTaps / 2 + capacity), true);
+}
+
+void HalfbandDecimator::Stage::reset() noexcept
+{
+	if (capacity > 0)
+	{
+		FloatVectorOperations::clear(oddSamples, numTaps);
+		FloatVectorOperations::clear(evenSamples, numTaps / 2);
+	}
+}
+
+void HalfbandDecimator::Stage::process(const float* input, float* output, int numOutputSamples) noexcept
+{
+	jassert(numOutputSamples <= capacity);
+
+	//split the input into its two branches behind what is left of the last block; this reads all of the input
+	//before anything is written, which is what lets output share its buffer
+	auto* odd = oddSamples.get();
+	auto* even = evenSamples.get();
+	auto evenDelay = numTaps / 2;
+
+	for (auto sample = 0; sample < numOutputSamples; ++sample)
+	{
+		even[evenDelay + sample] = input[2 * sample];
+		odd[numTaps + sample] = input[2 * sample + 1];
+	}
+
+	auto sample = 0;
+
+	switch (KernelDispatch::getActiveLevel())
+	{
+	   #if AUDIOAPP_HAS_AVX2
+		case KernelDispatch::Level::avx512:
+		case KernelDispatch::Level::avx2:	sample = filterAVX2(odd, even, coefficients, numTaps, output, numOutputSamples); break;
+	   #endif
+	   #if AUDIOAPP_HAS_SSE2
+		case KernelDispatch::Level::sse2:	sample = filterSSE2(odd, even, coefficients, numTaps, output, numOutputSamples); break;
+	   #endif
+		default:							break;
+	}
+
+	//whatever doesn't fill a whole vector (or everything, with the scalar kernels)
+	for (; sample < numOutputSamples; ++sample)
+	{
+		auto sum = 0.5f * even[sample];
+
+		for (auto k = 0; k < numTaps / 2; ++k)
+			sum += coefficients[k] * (odd[sample + k] + odd[sample + numTaps - 1 - k]);
+
+		output[sample] = sum;
+	}
+
+	//keep the tail of both branches for the next block
+	std::memmove(odd, odd + numOutputSamples, sizeof(float) * (size_t)numTaps);
+	std::memmove(even, even + numOutputSamples, sizeof(float) * (size_t)evenDelay);
+}
+
+//==============================================================================
+HalfbandDecimator::HalfbandDecimator()
+{
+	//Passband edges as a share of each stage's input rate: the last stage keeps everything up to 0.42 of the device
+	//rate (20 kHz at 48 kHz) and reaches about 80 dB of rejection with 32 taps. Each earlier stage only needs
+	//that same band, which is half as wide again relative to its rate, so much shorter filters reach the same.
+	stages.add(new Stage(32, 0.21));
+	stages.add(new Stage(12, 0.105));
+	stages.add(new Stage(8, 0.0525));
+}
+
+HalfbandDecimator::~HalfbandDecimator()
+{
+}
+
+void HalfbandDecimator::prepare(int maxOutputSamples)
+{
+	for (auto index = 0; index < stages.size(); ++index)
+		stages.getUnchecked(index)->prepare(maxOutputSamples << index);
+
+	setFactor(factor);
+}
+
+void HalfbandDecimator::setFactor(int newFactor) noexcept
+{
+	jassert(newFactor == 1 || newFactor == 2 || newFactor == 4 || newFactor == maxFactor);
+
+	factor = jlimit(1, maxFactor, nextPowerOfTwo(newFactor));
+	numActiveStages = 0;
+
+	while ((1 << numActiveStages) < factor)
+		++numActiveStages;
+
+	for (auto* stage : stages)
+		stage->reset();
+}
+
+void HalfbandDecimator::process(float* input, float* output, int numOutputSamples) noexcept
+{
+	if (numActiveStages == 0)
+	{
+		FloatVectorOperations::copy(output, input, numOutputSamples);
+		return;
+	}
+
+	//every stage but the last writes over the front of the input, which it has already read
+	for (auto index = numActiveStages - 1; index > 0; --index)
+		stages.getUnchecked(index)->process(input, input, numOutputSamples << index);
+
+	stages.getUnchecked(0)->process(input, output, numOutputSamples);
+}
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    HalfbandDecimator.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+
+//Brings a signal rendered at 2, 4 or 8 times the device rate back down to it, filtering out everything above
+//the device's Nyquist frequency on the way so it can't alias.
+//
+//Each halving is a half-band FIR low-pass: every other coefficient is zero, apart from the centre tap of 1/2.
+//Split into its two polyphase branches, the even input samples only need that centre tap and the odd ones go
+//through a short symmetric filter, and both run at the output rate. The stages are cascaded from the highest rate
+//down; the early ones only have to keep their images out of the final audio band, so they get by with far fewer
+//taps than the last one, which has to be steep just below 20 kHz.
+//
+//All storage is allocated in prepare(). setFactor() and process() never allocate, so the factor can change
+//from the audio thread between two blocks.
+class HalfbandDecimator
+{
+	public:
+		HalfbandDecimator();
+		~HalfbandDecimator();
+
+		//room for blocks of up to maxOutputSamples at the device rate, for every factor
+		void prepare(int maxOutputSamples);
+
+		//1, 2, 4 or maxFactor; the stages start again from silence, so switch between notes if a click matters
+		void setFactor(int newFactor) noexcept;
+		int getFactor() const noexcept		{ return factor; }
+
+		//Takes numOutputSamples * getFactor() samples from input and writes numOutputSamples to output.
+		//The input buffer is used as scratch space for the stages in between, so its contents are lost.
+		void process(float* input, float* output, int numOutputSamples) noexcept;
+
+		static constexpr int maxFactor = 8;
+
+	private:
+		//one halving of the rate; its filter is designed in the constructor
+		class Stage
+		{
+			public:
+				//numTaps odd-phase coefficients, which has to be even; passbandEdge as a share of the stage's input rate
+				Stage(int numTaps, double passbandEdge);
+
+				void prepare(int maxOutputSamples);
+				void reset() noexcept;
+
+				//input holds 2 * numOutputSamples samples; output may be the same buffer as input
+				void process(const float* input, float* output, int numOutputSamples) noexcept;
+
+			private:
+				const int numTaps;
+				HeapBlock<float> coefficients;
+
+				//each branch's samples so far: the last numTaps (odd) or numTaps / 2 (even) of the previous block,
+				//followed by the current one
+				HeapBlock<float> oddSamples, evenSamples;
+				int capacity = 0;
+
+				JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Stage)
+		};
+
+		//stages[0] ends at the device rate, stages[1] feeds it from twice the rate and so on
+		OwnedArray<Stage> stages;
+		int factor = 1, numActiveStages = 0;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HalfbandDecimator)
+};
@@ -0,0 +1,168 @@
+/*
+  ==============================================================================
+
+    KernelDispatch.cpp
+
+  ==============================================================================
+*/
+
+#include "KernelDispatch.h"
+#include "SimdConfig.h"
+
+#if JUCE_INTEL && JUCE_MSVC
+ #include <intrin.h>
+#elif JUCE_INTEL
+ #include <cpuid.h>
+#endif
+
+static const char* const levelNames[] = { "scalar", "sse2", "avx2", "avx512" };
+
+//A CPU can report AVX2 while the OS (or a hypervisor) doesn't save the upper halves of the ymm registers
+//on a context switch, and then the AVX2 kernels would crash. That's what the OSXSAVE bit and XCR0 tell us.
+//AVX-512 needs the opmask and zmm state saved as well, bits 5 to 7.
+static bool isAvxStateSavedByOS(unsigned int stateBits = 6) noexcept
+{
+   #if JUCE_INTEL && JUCE_MSVC
+	int info[4];
+	__cpuid(info, 1);
+
+	if ((info[2] & (1 << 27)) == 0)
+		return false;
+
+	return (_xgetbv(0) & stateBits) == stateBits;
+   #elif JUCE_INTEL
+	unsigned int eax, ebx, ecx, edx;
+
+	if (! __get_cpuid(1, &eax, &ebx, &ecx, &edx) || (ecx & (1u << 27)) == 0)
+		return false;
+
+	unsigned int xcr0Low, xcr0High;
+	__asm__ volatile ("xgetbv" : "=a" (xcr0Low), "=d" (xcr0High) : "c" (0));
+	return (xcr0Low & stateBits) == stateBits;
+   #else
+	ignoreUnused(stateBits);
+	return false;
+   #endif
+}
+
+static std::atomic<int>& getLevelStorage() noexcept
+{
+	//detected on the first call, which SynthEngine makes in its constructor
+	static std::atomic<int> level { (int)KernelDispatch::getBestSupportedLevel() };
+	return level;
+}
+
+//==============================================================================
+KernelDispatch::Level KernelDispatch::getActiveLevel() noexcept
+{
+	return (Level)getLevelStorage().load(std::memory_order_relaxed);
+}
+
+void KernelDispatch::setActiveLevel(Level level) noexcept
+{
+	getLevelStorage().store((int)(isSupported(level) ? level : getBestSupportedLevel()), std::memory_order_relaxed);
+}
+
+KernelDispatch::Level KernelDispatch::getBestSupportedLevel() noexcept
+{
+	if (isSupported(Level::avx512))
+		return Level::avx512;
+
+	if (isSupported(Level::avx2))
+		return Level::avx2;
+
+	if (isSupported(Level::sse2))
+		return Level::sse2;
+
+	return Level::scalar;
+}
+
+bool KernelDispatch::isSupported(Level level) noexcept
+{
+	switch (level)
+	{
+	   #if AUDIOAPP_HAS_AVX512
+		case Level::avx512:	return SystemStats::hasAVX2() && SystemStats::hasAVX512F() && isAvxStateSavedByOS(0xe6);
+	   #endif
+	   #if AUDIOAPP_HAS_AVX2
+		case Level::avx2:	return SystemStats::hasAVX2() && isAvxStateSavedByOS();
+	   #endif
+	   #if AUDIOAPP_HAS_SSE2
+		case Level::sse2:	return SystemStats::hasSSE2();
+	   #endif
+		case Level::scalar:	return true;
+		default:			return false;
+	}
+}
+
+KernelDispatch::Level KernelDispatch::selectFastestLevel(const std::function<void()>& renderOnce)
+{
+	auto fastest = getBestSupportedLevel();
+	auto fastestTicks = std::numeric_limits<int64>::max();
+
+	for (auto index = 0; index < numElementsInArray(levelNames); ++index)
+	{
+		auto level = (Level)index;
+
+		if (! isSupported(level))
+			continue;
+
+		setActiveLevel(level);
+		renderOnce();	//warms the caches and the branch predictor, and wakes the core up if it was asleep
+
+		//the quickest of several runs, which is the one the scheduler and the other cores disturbed least
+		auto bestTicks = std::numeric_limits<int64>::max();
+
+		for (auto run = 0; run < 8; ++run)
+		{
+			auto start = Time::getHighResolutionTicks();
+			renderOnce();
+			bestTicks = jmin(bestTicks, Time::getHighResolutionTicks() - start);
+		}
+
+		if (bestTicks < fastestTicks)
+		{
+			fastestTicks = bestTicks;
+			fastest = level;
+		}
+	}
+
+	setActiveLevel(fastest);
+	return fastest;
+}
+
+const char* KernelDispatch::getLevelName(Level level) noexcept
+{
+	return levelNames[jlimit(0, numElementsInArray(levelNames) - 1, (int)level)];
+}
+
+bool KernelDispatch::parseLevelName(const String& name, Level& level) noexcept
+{
+	for (auto index = 0; index < numElementsInArray(levelNames); ++index)
+	{
+		if (name.equalsIgnoreCase(levelNames[index]))
+		{
+			level = (Level)index;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+String KernelDispatch::getDescription()
+{
+	StringArray features;
+
+   #if JUCE_INTEL
+	if (SystemStats::hasSSE2())		features.add("SSE2");
+	if (SystemStats::hasSSE41())	features.add("SSE4.1");
+	if (SystemStats::hasSSE42())	features.add("SSE4.2");
+	if (SystemStats::hasAVX())		features.add("AVX");
+	if (SystemStats::hasAVX2())		features.add("AVX2");
+	if (SystemStats::hasFMA3())		features.add("FMA3");
+	if (SystemStats::hasAVX512F())	features.add("AVX-512F");
+   #endif
+
+	return String(getLevelName(getActiveLevel())) + " kernels (CPU: " + (features.isEmpty() ? String("no SIMD") : features.joinIntoString(" ")) + ")";
+}
@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    KernelDispatch.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+
+//Picks which instruction set the oscillator kernels run with, once per process, from what the CPU reports.
+//Every kernel reads the level at the start of a block and switches to its AVX2, SSE2 or scalar version, so
+//one binary runs on the whole range of machines and still uses the widest path each one has. The avx512 level is
+//AVX-512F for the wavetable voices, which gather 16 voices at once, and AVX2 for every other kernel: those run on
+//one voice's samples, not across voices, and gain little over 8 lanes. SSE4.1 would only take the table offsets
+//in front of SSE2's scalar loads out of scalar code, so the SSE4.2 machines run the SSE2 path.
+//
+//The level is process-wide and can be changed at any time from any thread: every version of a kernel produces
+//the same result within float rounding, so a block rendered with one and the next with another is still correct.
+class KernelDispatch
+{
+	public:
+		enum class Level
+		{
+			scalar = 0,
+			sse2,
+			avx2,
+			avx512
+		};
+
+		//the level in use; the first call detects the CPU, so make it once at startup rather than on the audio thread
+		static Level getActiveLevel() noexcept;
+
+		//forces a level, e.g. for a benchmark; one that isn't supported here falls back to the best one that is
+		static void setActiveLevel(Level level) noexcept;
+
+		//the widest level that is both compiled in and supported by this CPU
+		static Level getBestSupportedLevel() noexcept;
+		static bool isSupported(Level level) noexcept;
+
+		//Times renderOnce with every supported level and keeps the fastest. It confirms the cpuid pick on machines
+		//where the wide path is slow, e.g. from frequency throttling or emulated gathers. Runs renderOnce
+		//a few dozen times, so call it where a few milliseconds don't matter, never on the audio thread.
+		static Level selectFastestLevel(const std::function<void()>& renderOnce);
+
+		static const char* getLevelName(Level level) noexcept;
+
+		//parses the names getLevelName() returns; returns false for anything else
+		static bool parseLevelName(const String& name, Level& level) noexcept;
+
+		//the active kernel and the vector extensions the CPU reports, for the GUI and the logs
+		static String getDescription();
+};
@@ -10,6 +10,11 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "MainComponent.h"
+#include "OfflineRenderer.h"
+#include "OscillatorBenchmark.h"
+#include "CapacityPlanner.h"
+#include "EventLogPlayer.h"
+#include <iostream>
 
 //==============================================================================
 class AudioApp_juceApplication  : public JUCEApplication
@@ -27,7 +32,106 @@ public:
     {
         // This method is where you should put your application's initialisation code..
 
-        mainWindow.reset (new MainWindow (getApplicationName()));
+        // With --render the engine writes straight to a wav file and the app quits again,
+        // without ever opening a window or an audio device.
+        if (OfflineRenderer::isRenderCommandLine (commandLine))
+        {
+            OfflineRenderer::Options options;
+            String errorMessage;
+
+            if (OfflineRenderer::parseCommandLine (commandLine, options, errorMessage))
+            {
+                setApplicationReturnValue (OfflineRenderer (options).run());
+            }
+            else
+            {
+                std::cerr << errorMessage << std::endl
+                          << "usage: --render <file.wav> [--seconds 10] [--voices 1] [--voice sine|wavetable|pluck|polyblep|oversampled|bank] [--wave sine|tri|harmonics|saw|square|noise] [--tablesize 2048]"
+                             " [--interpolation truncate|linear|hermite|lagrange] [--pulsewidth 0.5] [--oversampling 4] [--bank <file.wav|file.wtbk>] [--position 0] [--framesize 2048] [--frequency 440] [--samplerate 48000] [--blocksize 512] [--subblock 32] [--threads <workers>] [--kernel auto|bench|scalar|sse2|avx2|avx512]" << std::endl;
+                setApplicationReturnValue (1);
+            }
+
+            quit();
+            return;
+        }
+
+        // --benchmark sweeps the oscillators headlessly in the same way and prints CSV or JSON
+        if (OscillatorBenchmark::isBenchmarkCommandLine (commandLine))
+        {
+            OscillatorBenchmark::Options options;
+            String errorMessage;
+
+            if (OscillatorBenchmark::parseCommandLine (commandLine, options, errorMessage))
+            {
+                setApplicationReturnValue (OscillatorBenchmark (options).run());
+            }
+            else
+            {
+                std::cerr << errorMessage << std::endl
+                          << "usage: --benchmark [--types sine,wavetable,wavetableBlock,voiceBank,voiceBankThreaded,sineQuadrature,sinePolynomial,polyBlep,naive,oversampled2x,oversampled4x,oversampled8x]"
+                             " [--tablesizes 256,...,4096]"
+                             " [--interpolation truncate,linear,hermite,lagrange] [--blocksizes 32,...,4096] [--voices 1,...,10000] [--seconds-per-run 0.1]"
+                             " [--samplerate 48000] [--format csv|json] [--output <file>] [--label <text>] [--kernels scalar,sse2,avx2]" << std::endl;
+                setApplicationReturnValue (1);
+            }
+
+            quit();
+            return;
+        }
+
+        // --stress finds the most voices of each type that fit each block size, without a device
+        if (CapacityPlanner::isStressCommandLine (commandLine))
+        {
+            CapacityPlanner::Options options;
+            String errorMessage;
+
+            if (CapacityPlanner::parseCommandLine (commandLine, options, errorMessage))
+            {
+                setApplicationReturnValue (CapacityPlanner (options).run());
+            }
+            else
+            {
+                std::cerr << errorMessage << std::endl
+                          << "usage: --stress [--types sine,wavetable,pluck,polyblep,oversampled] [--blocksizes 64,128,256,512] [--load 0.7]"
+                             " [--seconds-per-step 1] [--max-voices 4096] [--threads <workers>] [--samplerate 48000]"
+                             " [--format csv|json] [--output <file>] [--label <text>]" << std::endl;
+                setApplicationReturnValue (1);
+            }
+
+            quit();
+            return;
+        }
+
+        // --replay plays an event log recorded with --record back through a fresh engine, as fast as it will go
+        if (EventLogPlayer::isReplayCommandLine (commandLine))
+        {
+            EventLogPlayer::Options options;
+            String errorMessage;
+
+            if (EventLogPlayer::parseCommandLine (commandLine, options, errorMessage))
+            {
+                setApplicationReturnValue (EventLogPlayer (options).run());
+            }
+            else
+            {
+                std::cerr << errorMessage << std::endl
+                          << "usage: --replay <file.aelog> [--output <file.wav>] [--repeat 1]" << std::endl;
+                setApplicationReturnValue (1);
+            }
+
+            quit();
+            return;
+        }
+
+        // --record <file.aelog> logs everything the GUI's engine plays, for --replay to reproduce
+        auto args = StringArray::fromTokens (commandLine, true);
+        auto recordIndex = args.indexOf ("--record");
+        File eventLogFile;
+
+        if (recordIndex >= 0 && recordIndex + 1 < args.size())
+            eventLogFile = File::getCurrentWorkingDirectory().getChildFile (args[recordIndex + 1].unquoted());
+
+        mainWindow.reset (new MainWindow (getApplicationName(), eventLogFile));
     }
 
     void shutdown() override
@@ -60,13 +164,13 @@ public:
     class MainWindow    : public DocumentWindow
     {
     public:
-        MainWindow (String name)  : DocumentWindow (name,
+        MainWindow (String name, const File& eventLogFile)  : DocumentWindow (name,
                                                     Desktop::getInstance().getDefaultLookAndFeel()
                                                                           .findColour (ResizableWindow::backgroundColourId),
                                                     DocumentWindow::allButtons)
         {
             setUsingNativeTitleBar (true);
-            setContentOwned (new MainComponent(), true);
+            setContentOwned (new MainComponent (eventLogFile), true);
 
            #if JUCE_IOS || JUCE_ANDROID
             setFullScreen (true);
@@ -10,13 +10,27 @@
 
 #include "MainComponent.h"
 
-//whether we use sineosc or wavetable implementation
-bool useWaveTable = 1;
+//whether we use the sineosc, wavetable, karplus-strong plucked string, polyblep, oversampled or wavetable bank implementation
+auto voiceType = SynthEngine::VoiceType::wavetable;
+
+//which kernel the sine oscillators use: libm, quadrature or polynomial
+auto sineMode = SineOscillator::Mode::polynomial;
+
+//how many voices the GUI plays; the stress test button (or --stress) finds how many this machine can take
+auto numberOfOscillators = 1;
+
+//In order to calculate the frequency of a midi note, we use a simple mathematical formula to retrieve the scalar 
+//to multiply the frequency of A440 with.
+//Since we know that the midi note number of A440 is 69, by subtracting the midi note by 69 we get the 
+//semitone distance from A440 that we can then plug into the following formula: 440 * 2 ^ (d / 12)
+static double midiNoteToFrequency(double midiNote)
+{
+	return 440.0 * pow(2.0, (midiNote - 69.0) / 12.0);
+}
 
-// First we define a large number of oscillators to evaluate the CPU load of such a number.
-auto numberOfOscillators = 1; 
 //==============================================================================
-MainComponent::MainComponent()
+MainComponent::MainComponent(const File& eventLogFile)
+	: engine(numberOfOscillators, voiceType)
 {
     // Make sure you set the size of the component after
     // you add any child components.
@@ -26,25 +40,194 @@ MainComponent::MainComponent()
 	cpuUsageText.setJustificationType(Justification::right);
 	addAndMakeVisible(cpuUsageLabel);
 	addAndMakeVisible(cpuUsageText);
+	addAndMakeVisible(blockTimingText);
+	addAndMakeVisible(kernelText);
 
 	addAndMakeVisible(freqSlider);
 	freqSlider.setRange(25.0, 85.0);
 
-	freqSlider.onValueChange = [this]
+	engine.setSineMode(sineMode);
+
+	//The log starts before the device does, so it holds every block from the first one on and a replay can start
+	//from an engine as fresh as this one.
+	if (eventLogFile.getFullPathName().isNotEmpty())
+	{
+		eventLogFile.deleteFile();
+		std::unique_ptr<FileOutputStream> stream(new FileOutputStream(eventLogFile));
+
+		if (stream->openedOk())
+		{
+			eventLog.reset(new EventLogWriter(stream.release(), engine.createEventLogHeader()));
+			engine.getEventRecorder().setEnabled(true);
+		}
+	}
+
+	//the GUI can spare a few milliseconds when the device starts to make sure the kernels cpuid picked really are the fastest
+	engine.setKernelSelfBenchmark(true);
+
+	//The audio thread owns the voices and the sample rate, so the GUI only queues notes for it.
+	//Every oscillator holds the same note from the start; the slider then retunes all of them.
+	startNotes();
+
+	//a plucked string dies away by itself, so it needs plucking again
+	if (engine.getVoiceType() == SynthEngine::VoiceType::pluckedString)
+	{
+		pluckButton.setButtonText("Pluck");
+		addAndMakeVisible(pluckButton);
+
+		pluckButton.onClick = [this]
+		{
+			//with the audio thread stalled and the queue full, leave the old notes alone rather than stack new ones on them
+			if (engine.stopNote(0))
+				startNotes();
+		};
+	}
+
+	//the polyblep pulse and triangle can change their width while they play, and so can the oversampled ones
+	if (engine.getVoiceType() == SynthEngine::VoiceType::polyBlep || engine.getVoiceType() == SynthEngine::VoiceType::oversampled)
+	{
+		addAndMakeVisible(pulseWidthSlider);
+		pulseWidthSlider.setRange(PolyBlepOscillator::minPulseWidth, 1.0 - PolyBlepOscillator::minPulseWidth);
+		pulseWidthSlider.setValue(0.5, dontSendNotification);
+
+		pulseWidthSlider.onValueChange = [this]
+		{
+			engine.setPulseWidth((float)pulseWidthSlider.getValue());
+		};
+	}
+
+	//the oversampling factor can be switched while the notes play, to hear what each step buys
+	if (engine.getVoiceType() == SynthEngine::VoiceType::oversampled)
 	{
-		auto midiNote = freqSlider.getValue();
+		addAndMakeVisible(oversamplingSelect);
+		oversamplingSelect.addItem("1x", 1);
+		oversamplingSelect.addItem("2x", 2);
+		oversamplingSelect.addItem("4x", 4);
+		oversamplingSelect.addItem("8x", 8);
+		oversamplingSelect.setSelectedId(4, dontSendNotification);
+
+		//the item ids are the factors themselves
+		oversamplingSelect.onChange = [this]
+		{
+			engine.setOversamplingFactor(oversamplingSelect.getSelectedId());
+		};
+	}
+
+	//the interpolation of the wavetable voices can be switched while the notes play too, to hear what the small tables lose
+	if (engine.getVoiceType() == SynthEngine::VoiceType::wavetable)
+	{
+		addAndMakeVisible(interpolationSelect);
 
-		//In order to calculate the frequency of that midi note, we use a simple mathematical formula to retrieve the scalar 
-		//to multiply the frequency of A440 with.
-		//Since we know that the midi note number of A440 is 69, by subtracting the midi note by 69 we get the 
-		//semitone distance from A440 that we can then plug into the following formula: 440 * 2 ^ (d / 12)
-		auto frequency = 440.0 * pow(2.0, (midiNote - 69.0) / 12.0);
+		for (auto mode = 0; mode < TableInterpolation::numModes; ++mode)
+			interpolationSelect.addItem(TableInterpolation::getModeName((TableInterpolation::Mode)mode), mode + 1);
 
-		for (int i = 0; i < tabOscillators.size(); i++) 
+		interpolationSelect.setSelectedId((int)TableInterpolation::Mode::linear + 1, dontSendNotification);
+
+		//the item ids are the modes, offset by one because 0 means nothing is selected
+		interpolationSelect.onChange = [this]
 		{
-			auto* oscillator = tabOscillators.getUnchecked(i);
-			oscillator->setFrequency(frequency, currentSampleRate);
+			engine.setInterpolation((TableInterpolation::Mode)(interpolationSelect.getSelectedId() - 1));
+		};
+	}
+
+	//every voice type renders in sub-blocks, which can be switched while the notes play to compare their cost
+	addAndMakeVisible(subBlockSelect);
+	subBlockSelect.addItem("16 samples", 16);
+	subBlockSelect.addItem("32 samples", 32);
+	subBlockSelect.addItem("64 samples", 64);
+	subBlockSelect.addItem("Device blocks", 1);
+	subBlockSelect.setSelectedId(32, dontSendNotification);
+
+	//the item ids are the sizes, except for the device's own blocks, since 0 means nothing is selected
+	subBlockSelect.onChange = [this]
+	{
+		auto id = subBlockSelect.getSelectedId();
+		engine.setSubBlockSize(id == 1 ? 0 : id);
+	};
+
+	//a wavetable bank is loaded from disk, then swept through with the position slider while the notes play
+	if (engine.getVoiceType() == SynthEngine::VoiceType::wavetableBank)
+	{
+		loadBankButton.setButtonText("Load bank...");
+		addAndMakeVisible(loadBankButton);
+		addAndMakeVisible(bankPositionSlider);
+		bankPositionSlider.setRange(0.0, 1.0);
+
+		loadBankButton.onClick = [this]
+		{
+			bankChooser.reset(new FileChooser("Open a wavetable bank", File(), "*.wav;*.wtbk;*.raw;*.f32"));
+
+			bankChooser->launchAsync(FileBrowserComponent::openMode | FileBrowserComponent::canSelectFiles, [this] (const FileChooser& chooser)
+			{
+				auto file = chooser.getResult();
+				String errorMessage;
+
+				if (file.getFullPathName().isNotEmpty() && ! engine.loadWavetableBank(file, errorMessage))
+					AlertWindow::showMessageBoxAsync(AlertWindow::WarningIcon, "Couldn't load the wavetable bank", errorMessage);
+			});
+		};
+
+		bankPositionSlider.onValueChange = [this]
+		{
+			engine.setBankPosition((float)bankPositionSlider.getValue());
+		};
+	}
+
+	//The stress test plays its own engines next to this one, so the notes above keep playing while it runs.
+	//It takes a second or so per step and about a dozen steps per voice type.
+	stressButton.setButtonText("Stress test");
+	addAndMakeVisible(stressButton);
+	addAndMakeVisible(stressText);
+	stressText.setJustificationType(Justification::topLeft);
+
+	stressButton.onClick = [this]
+	{
+		if (stressTest.isRunning())
+		{
+			stressTest.stop();
+			stressButton.setButtonText("Stress test");
+			return;
 		}
+
+		stressResults = "Most voices with the p99 callback under " + String(roundToInt(stressTest.getTargetLoad() * 100.0)) + "% of the deadline:\n";
+		stressText.setText(stressResults, dontSendNotification);
+		stressButton.setButtonText("Stop");
+
+		stressTest.start({ SynthEngine::VoiceType::sine, SynthEngine::VoiceType::wavetable, SynthEngine::VoiceType::pluckedString,
+						   SynthEngine::VoiceType::polyBlep, SynthEngine::VoiceType::oversampled });
+	};
+
+	stressTest.onProgress = [this] (const String& step)
+	{
+		stressText.setText(stressResults + step, dontSendNotification);
+	};
+
+	stressTest.onResult = [this] (const CapacityPlanner::Result& result)
+	{
+		stressResults << CapacityPlanner::getVoiceTypeName(result.voiceType) << ": " << result.maxVoices << " voices at "
+					  << result.blockSize << " samples, p99 " << String(result.load * 100.0, 1) << "% of "
+					  << String(result.deadlineMicroseconds, 1) << " us\n";
+		stressText.setText(stressResults, dontSendNotification);
+	};
+
+	stressTest.onFinished = [this]
+	{
+		stressButton.setButtonText("Stress test");
+	};
+
+	freqSlider.onValueChange = [this]
+	{
+		auto frequency = midiNoteToFrequency(freqSlider.getValue());
+		engine.setFrequency((float)frequency);
+	};
+
+	addAndMakeVisible(gainSlider);
+	gainSlider.setRange(0.0, 1.0);
+	gainSlider.setValue(1.0, dontSendNotification);
+
+	gainSlider.onValueChange = [this]
+	{
+		engine.setGain((float)gainSlider.getValue());
 	};
 
 	addAndMakeVisible(waveSelect);
@@ -58,38 +241,12 @@ MainComponent::MainComponent()
 
 	waveSelect.onChange = [this]
 	{
-		switch(waveSelect.getSelectedId())
-		{
-			case(1):
-				createSinWavetable();
-				break;
-			case(2):
-				createTriWavetable();
-				break;
-			case(3):
-				createWavetableHarmonics();				
-				break;
-			case(4):
-				createSawWavetable();				
-				break;
-			case(5):
-				createSquareWavetable();
-				break;
-			case(6):
-				createNoiseWavetable();
-				break;
-			default:
-				break;
-		}
+		//The item ids follow the order of WavetableSet::Shape. The set comes ready-made from the wavetable cache
+		//and is published for the audio thread to pick up at the start of its next block.
+		auto shape = (WavetableSet::Shape)(waveSelect.getSelectedId() - 1);
+		engine.setWaveform(shape);
 	};
 
-	//create the wavetable
-	createSinWavetable();
-	//createWavetableHarmonics();
-	//createSawWavetable();
-	//createSquareWavetable();
-	//createTriWavetable();
-
     // Some platforms require permissions to open input channels so request that here
     if (RuntimePermissions::isRequired (RuntimePermissions::recordAudio)
         && ! RuntimePermissions::isGranted (RuntimePermissions::recordAudio))
@@ -108,14 +265,52 @@ MainComponent::MainComponent()
 
 MainComponent::~MainComponent()
 {
+	//takes the stress test's engine off the device before the device goes
+	stressTest.stop();
+
     // This shuts down the audio device and clears the audio source.
     shutdownAudio();
+
+	//whatever the audio thread recorded since the last timer tick
+	if (eventLog != nullptr)
+		eventLog->drain(engine.getEventRecorder());
+}
+
+void MainComponent::startNotes()
+{
+	for (auto i = 0; i < numberOfOscillators; ++i)
+		engine.startNote(0, (float)midiNoteToFrequency(freqSlider.getValue()), 1.0f);
 }
 
 void MainComponent::timerCallback()
 {
 	auto cpu = deviceManager.getCpuUsage() * 100;
 	cpuUsageText.setText(String(cpu, 6) + " %", dontSendNotification);
+
+	//The CPU figure above is an average; the block times show the spikes that actually cause dropouts.
+	blockTimings.drain(engine.getTimingMonitor());
+
+	String timing;
+	timing << blockTimings.getLastNumSamples() << " samples, " << blockTimings.getLastNumVoices() << " voices: "
+		   << "min " << String(blockTimings.getMinMicroseconds(), 1)
+		   << " / avg " << String(blockTimings.getAverageMicroseconds(), 1)
+		   << " / p99 " << String(blockTimings.getPercentileMicroseconds(99.0), 1)
+		   << " / max " << String(blockTimings.getMaxMicroseconds(), 1) << " us, "
+		   << blockTimings.getNumDeadlineMisses() << " deadline misses";
+
+	//not every driver counts its xruns, those report -1
+	if (auto* device = deviceManager.getCurrentAudioDevice())
+		if (device->getXRunCount() >= 0)
+			timing << ", " << device->getXRunCount() << " xruns";
+
+	blockTimingText.setText(timing, dontSendNotification);
+	kernelText.setText(KernelDispatch::getDescription(), dontSendNotification);
+
+	if (eventLog != nullptr)
+		eventLog->drain(engine.getEventRecorder());
+
+	//the wavetable sets the audio thread has stopped using get released here, off the audio thread
+	engine.collectGarbage();
 }
 
 //==============================================================================
@@ -126,95 +321,13 @@ void MainComponent::prepareToPlay (int samplesPerBlockExpected, double sampleRat
 
     // You can use this function to initialise any resources you might need,
     // but be careful - it will be called on the audio thread, not the GUI thread.
-	
-	currentSampleRate = sampleRate;
-
-	//we initialise the oscillators and set their frequencies to play based on the sample rate as follows	
-	for (auto i = 0; i < numberOfOscillators; ++i)
-	{
-		//We also select a random midi note using the Random class by shifting the lowest possible note by 4 octaves (+ 48) 
-		//and defining a range of 3 octaves (* 36.0) starting from that lowest note.
-		// ergo, lowest note 48 (C3), highest note 84 (C6)
-		auto midiNote = Random::getSystemRandom().nextDouble() * 36.0 + 48.0;
-		//auto midiNote = 48 + i * 6;
-		//midiNote = 60.0;
-		midiNote = freqSlider.getValue();
-
-		//In order to calculate the frequency of that midi note, we use a simple mathematical formula to retrieve the scalar 
-		//to multiply the frequency of A440 with.
-		//Since we know that the midi note number of A440 is 69, by subtracting the midi note by 69 we get the 
-		//semitone distance from A440 that we can then plug into the following formula: 440 * 2 ^ (d / 12)
-		auto frequency = 440.0 * pow(2.0, (midiNote - 69.0) / 12.0);
-
-		if (useWaveTable) 
-		{
-			//WavetableOsc implementation
-			auto* oscillator = new WavetableOscillator(oscTable);
-
-			//Then, we set the frequency of the oscillator by passing the frequency and sample rate as 
-			//arguments to the setFrequency() function. We also add the oscillator to the array of oscillators.
-			oscillator->setFrequency((float)frequency, sampleRate);
-			tabOscillators.add(oscillator);
-		}
-		else 
-		{
-			//SineOsc implementation
-			//For each oscillator, we instantiate a new SineOscillator object that generates a single sine wave voice.
-			auto* oscillator = new SineOscillator();
-
-			//Then, we set the frequency of the oscillator by passing the frequency and sample rate as 
-			//arguments to the setFrequency() function. We also add the oscillator to the array of oscillators.
-			oscillator->setFrequency((float)frequency, sampleRate);
-			oscillators.add(oscillator);
-		}
-	}
-	//Finally, we define the output level by dividing a quiet gain level by the number of oscillators to prevent clipping 
-	//of the signal by summing such a large number of oscillator samples.
-	level = 0.25f / numberOfOscillators;		
+	engine.prepareToPlay(samplesPerBlockExpected, sampleRate);
 }
 
 void MainComponent::getNextAudioBlock(const AudioSourceChannelInfo& bufferToFill)
 {
 	// Your audio-processing code goes here!
-
-	//First, we retrieve the left and right channel pointers to write to the output buffers.
-	auto* leftBuffer = bufferToFill.buffer->getWritePointer(0, bufferToFill.startSample);
-	auto* rightBuffer = bufferToFill.buffer->getWritePointer(1, bufferToFill.startSample);
-
-	bufferToFill.clearActiveBufferRegion();
-
-	for (auto oscillatorIndex = 0; oscillatorIndex < numberOfOscillators; ++oscillatorIndex)
-	{
-		//For each oscillator in the array we retrieve a pointer to the oscillator instance.
-		if (useWaveTable) 
-		{
-			auto* oscillator = tabOscillators.getUnchecked(oscillatorIndex);
-			for (auto sample = 0; sample < bufferToFill.numSamples; ++sample)
-			{
-				//Then for each sample in the audio sample buffer we get the sine wave sample and trim the gain with the level variable.
-				auto levelSample = oscillator->getNextSample() * level;
-
-				//Finally we can add that sample value to the left and right channel samples and sum the signal with the other oscillators.
-				leftBuffer[sample] += levelSample;
-				rightBuffer[sample] += levelSample;
-			}
-		}
-			
-		else 
-		{
-			auto* oscillator = oscillators.getUnchecked(oscillatorIndex);
-
-			for (auto sample = 0; sample < bufferToFill.numSamples; ++sample)
-			{
-				//Then for each sample in the audio sample buffer we get the sine wave sample and trim the gain with the level variable.
-				auto levelSample = oscillator->getNextSample() * level;
-
-				//Finally we can add that sample value to the left and right channel samples and sum the signal with the other oscillators.
-				leftBuffer[sample] += levelSample;
-				rightBuffer[sample] += levelSample;
-			}
-		}
-	}
+	engine.getNextAudioBlock(bufferToFill);
 }
 
 void MainComponent::releaseResources()
@@ -223,6 +336,7 @@ void MainComponent::releaseResources()
     // restarted due to a setting change.
 
     // For more details, see the help for AudioProcessor::releaseResources()
+	engine.releaseResources();
 }
 
 //==============================================================================
@@ -240,266 +354,16 @@ void MainComponent::resized()
 	cpuUsageText.setBounds(10, 10, getWidth() - 20, 20);
 	waveSelect.setBounds(10, 30, getWidth() - 40, 20);
 	freqSlider.setBounds(10, 70, getWidth() - 20, 20);
-}
-
-
-
-/*
-  ==============================================================================
-
-	WavetableOsc
-
-  ==============================================================================
-*/
-void MainComponent::createNoiseWavetable()
-{
-	oscTable.setSize(1, tableSize + 1);
-	auto* samples = oscTable.getWritePointer(0);
-
-	auto increment = Random::getSystemRandom().nextDouble();
-
-	for (auto i = 0; i < tableSize; ++i)
-	{
-		//sample values between -1.0 and 1.0
-		auto sample = Random::getSystemRandom().nextDouble() * 2.0f - 1.0f;
-		samples[i] = (float)sample;
-	}
-	samples[tableSize] = samples[0];
-}
-
-
-void MainComponent::createTriWavetable() 
-{
-	oscTable.setSize(1, tableSize + 1);
-	auto* samples = oscTable.getWritePointer(0);
-
-	auto delta = 2.0f / (double)(tableSize - 1);
-	auto angleDelta = MathConstants<double>::twoPi / (double)(tableSize - 1);
-	double t = angleDelta / MathConstants<double>::twoPi;
-
-	auto increment = -1.0;
-
-	for (auto i = 0; i < tableSize; ++i)
-	{
-		auto sample = increment;
-		//sample -= poly_blep(t, angleDelta);
-		samples[i] = (float)sample;
-
-		if (i < tableSize / 2)
-			increment += delta * 2;
-		else
-			increment -= delta * 2;
-	}
-
-	samples[tableSize] = samples[0];
-}
-
-void MainComponent::createSawWavetable() 
-{
-	//In this function, initialise the AudioSampleBuffer by calling the setSize() method by specifying that we only need one channel 
-	//and the number of samples equal to the table size, in our case a resolution of 128. 
-	//Then retrieve the write pointer for that single channel buffer.
-	oscTable.setSize(1, tableSize + 1);
-	auto* samples = oscTable.getWritePointer(0);
-
-	auto delta = 2.0f / (double)(tableSize - 1);
-	auto angleDelta = MathConstants<double>::twoPi / (double)(tableSize - 1);
-	double t = angleDelta / MathConstants<double>::twoPi;
-
-	auto increment = -1.0;
-
-	for (auto i = 0; i < tableSize; ++i) 
-	{
-		auto sample = increment;
-		sample -= poly_blep(t, angleDelta);
-		samples[i] = (float)sample;
-		increment += delta;
-	}
-
-	samples[tableSize] = samples[0];
-}
-
-void MainComponent::createSquareWavetable() 
-{
-	//In this function, initialise the AudioSampleBuffer by calling the setSize() method by specifying that we only need one channel 
-	//and the number of samples equal to the table size, in our case a resolution of 128. 
-	//Then retrieve the write pointer for that single channel buffer.
-	oscTable.setSize(1, tableSize + 1);
-	auto* samples = oscTable.getWritePointer(0);
-
-	auto angleDelta = MathConstants<double>::twoPi / (double)(tableSize - 1);
-	double t = angleDelta / MathConstants<double>::twoPi;
-
-	auto sample = 0.0;
-	for (auto i = 0; i < tableSize; ++i)
-	{
-		if (i < tableSize / 2)
-			sample = -1.0;
-		else
-			sample = 1.0;
-
-		sample += poly_blep(t, angleDelta); // Layer output of Poly BLEP on top (flip)
-		sample -= poly_blep(fmod(t + 0.5, 1.0), angleDelta); // Layer output of Poly BLEP on top (flop)
-
-		samples[i] = (float)sample;
-
-	}
-	samples[tableSize] = samples[0];
-}
-
-
-
-void MainComponent::createSinWavetable()
-{
-
-	//In this function, initialise the AudioSampleBuffer by calling the setSize() method by specifying that we only need one channel 
-	//and the number of samples equal to the table size, in our case a resolution of 128. 
-	//Then retrieve the write pointer for that single channel buffer.
-	oscTable.setSize(1, tableSize + 1);
-	auto* samples = oscTable.getWritePointer(0);
-
-	//Next, calculate the angle delta similarly to the SineOscillator, but this time using the table size and thus dividing the full 2pi cycle by 127.
-	auto angleDelta = MathConstants<double>::twoPi / (double)(tableSize - 1);
-	auto currentAngle = 0.0;
-	for (auto i = 0; i < tableSize; ++i)
-	{
-		//Now for each point in our wavetable, retrieve the sine wave value using the std::sin() function, 
-		//assign the value to the buffer sample and increment the current angle by the delta value.
-		auto sample = std::sin(currentAngle);
-		samples[i] = (float)sample;
-		currentAngle += angleDelta;
-	}
-
-	samples[tableSize] = samples[0]; //the last sample is the same as the first
-}
-
-void MainComponent::createWavetableHarmonics()
-{
-	oscTable.setSize(1, tableSize + 1);
-	oscTable.clear();
-	auto* samples = oscTable.getWritePointer(0);
-	//int harmonics[] = { 1, 3, 5, 6, 7, 9, 13, 15 };
-	//int harmonics[] = { 1, 2, 4, 6, 8, 10, 12, 14 };
-	//float harmonicWeights[] = { 0.5f, 0.1f, 0.05f, 0.125f, 0.09f, 0.005, 0.002f, 0.001f }; // [1]
-
-	//additive SAW with 8 harmonics
-	int harmonics[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
-	float harmonicWeights[] = {1.0f, 0.5f, 0.33333333f, 0.25f, 0.2f, 0.16666666f, 0.142857142f, 0.125f }; // [1]
-
-	jassert(numElementsInArray(harmonics) == numElementsInArray(harmonicWeights));
-	for (auto harmonic = 0; harmonic < numElementsInArray(harmonics); ++harmonic)
-	{
-		auto angleDelta = MathConstants<double>::twoPi / (double)(tableSize - 1) * harmonics[harmonic]; // [2]
-		//auto currentAngle = 0.0;
-		//attempting 180 degree phase shift here for upward SAW ramp instead of downward
-		auto currentAngle = MathConstants<double>::pi;
-		for (auto i = 0; i < tableSize; ++i)
-		{
-			auto sample = std::sin(currentAngle);
-			samples[i] += (float)sample * harmonicWeights[harmonic];                      // [3]
-			currentAngle += angleDelta;
-		}
-	}
-	samples[tableSize] = samples[0];
-}
-
-void WavetableOscillator::setFrequency(float frequency, float sampleRate)
-{
-	auto tableSizeOverSampleRate = subTableSize / sampleRate;
-	tableDelta = frequency * tableSizeOverSampleRate;
-}
-
-forcedinline float WavetableOscillator::getNextSample() noexcept
-{
-	auto tableSize = wavetable.getNumSamples();
-
-	//First, temporarily store the two indices of the wavetable that surround the sample value that we are trying to retrieve. 
-	
-	auto index0 = (unsigned int)currentIndex;  
-	//***used before  when we were wrapping the higher index***
-	//If the higher index goes beyond the size of the wavetable then we wrap the value to the start of the table.
-	//auto index1 = index0 == (tableSize - 1) ? (unsigned int)0 : index0 + 1;
-	auto index1 = index0 + 1;
-
-	//Next, calculate the interpolation value as a fraction between the two indices 
-	//by subtracting the actual current sample by the truncated lower index. 
-	//This should give us a value between 0 .. 1 that defines the fraction.
-	auto frac = currentIndex - (float)index0;  // [7]
-
-	//Then get a pointer to the AudioSampleBuffer and read the values at the two indices and store these values temporarily.
-	auto* table = wavetable.getReadPointer(0); // [8]
-	auto value0 = table[index0];
-	auto value1 = table[index1];
-
-	//The interpolated sample value can then be retrieved by using the standard interpolation formula and the fraction value calculated previously.
-	auto currentSample = value0 + frac * (value1 - value0); // [9]
-
-	//Finally, increment the angle delta of the table and wrap the value around if the value exceeds the table size.
-	if ((currentIndex += tableDelta) > subTableSize)           // [10]
-		currentIndex -= subTableSize;
-
-	return currentSample;
-}
-
-
-/*
-  ==============================================================================
-
-	SineOsc
-
-  ==============================================================================
-*/
-
-//calculate the angle delta via 2pi * (frequency / samplerate)
-void SineOscillator::setFrequency(float frequency, float sampleRate)
-{
-	auto cyclesPerSample = frequency / sampleRate;
-	angleDelta = cyclesPerSample * MathConstants<float>::twoPi;
-}
-
-//called by getNextAudioBlock() on every sample in the buffer to get sample value from oscillator.
-//Here we calculate sample by using std::sin() by passing in currentAngle and then updating currentAngle
-forcedinline float SineOscillator::getNextSample() noexcept {
-	auto currentSample = std::sin(currentAngle);
-	updateAngle();
-	return currentSample;
-}
-
-//update the angle by incrementing with angle delta; wrap the value when exceeding 2PI
-forcedinline void SineOscillator::updateAngle() noexcept {
-	currentAngle += angleDelta;
-
-	if (currentAngle >= MathConstants<float>::twoPi)
-		currentAngle -= MathConstants<float>::twoPi;
-}
-
-
-// This function calculates the PolyBLEPs
-//Bleps are a mechanism for reducting aliasing on complex waveforms like saw, square, tri, etc
-//http://metafunction.co.uk/all-about-digital-oscillators-part-2-blits-bleps/
-double MainComponent::poly_blep(double t, double mPhaseIncrement)
-{
-	double dt = mPhaseIncrement / MathConstants<double>::twoPi;
-
-	// t-t^2/2 +1/2
-	// 0 < t <= 1
-	// discontinuities between 0 & 1
-	if (t < dt)
-	{
-		t /= dt;
-		return t + t - t * t - 1.0;
-	}
-
-	// t^2/2 +t +1/2
-	// -1 <= t <= 0
-	// discontinuities between -1 & 0
-	else if (t > 1.0 - dt)
-	{
-		t = (t - 1.0) / dt;
-		return t * t + t + t + 1.0;
-	}
-
-	// no discontinuities 
-	// 0 otherwise
-	else return 0.0;
+	gainSlider.setBounds(10, 100, getWidth() - 20, 20);
+	blockTimingText.setBounds(10, 130, getWidth() - 20, 20);
+	pluckButton.setBounds(10, 160, 100, 20);
+	pulseWidthSlider.setBounds(10, 160, getWidth() - 20, 20);
+	kernelText.setBounds(10, 190, getWidth() - 20, 20);
+	oversamplingSelect.setBounds(10, 220, 100, 20);
+	interpolationSelect.setBounds(10, 220, 100, 20);
+	subBlockSelect.setBounds(120, 220, 120, 20);
+	loadBankButton.setBounds(10, 160, 100, 20);
+	bankPositionSlider.setBounds(120, 160, getWidth() - 130, 20);
+	stressButton.setBounds(10, 250, 100, 20);
+	stressText.setBounds(10, 280, getWidth() - 20, getHeight() - 290);
 }
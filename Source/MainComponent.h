@@ -9,52 +9,8 @@
 #pragma once
 
 #include "../JuceLibraryCode/JuceHeader.h"
-
-
-//https://docs.juce.com/master/tutorial_wavetable_synth.html
-
-//uses std::sin calcullations for 
-class SineOscillator
-{
-	public:
-		SineOscillator() {}
-
-		//calculate the angle delta via 2pi * (frequency / samplerate)
-		void setFrequency(float frequency, float sampleRate);
-
-		//called by getNextAudioBlock() on every sample in the buffer to get sample value from oscillator.
-		//Here we calculate sample by using std::sin() by passing in currentAngle and then updating currentAngle
-		forcedinline float getNextSample() noexcept;
-
-
-		//update the angle by incrementing with angle delta; wrap the value when exceeding 2PI
-		forcedinline void updateAngle() noexcept;
-
-	private:
-		float currentAngle = 0.0f, angleDelta = 0.0f;
-};
-
-
-
-class WavetableOscillator
-{
-	public:
-		WavetableOscillator(const AudioSampleBuffer& wavetableToUse)
-			: wavetable(wavetableToUse),
-			subTableSize (wavetable.getNumSamples() - 1)
-		{
-			jassert(wavetable.getNumChannels() == 1);
-		}
-		
-		//calculate the angle delta via 2pi * (frequency / samplerate)
-		void setFrequency(float frequency, float sampleRate);
-		forcedinline float getNextSample() noexcept;
-
-	private:
-		const AudioSampleBuffer& wavetable;
-		float currentIndex = 0.0f, tableDelta = 0.0f;
-		const int subTableSize;
-};
+#include "SynthEngine.h"
+#include "CapacityPlanner.h"
 
 
 //==============================================================================
@@ -66,7 +22,8 @@ class MainComponent   : public AudioAppComponent, public Timer
 {
 	public:
 		//==============================================================================
-		MainComponent();
+		//records everything the engine plays to eventLogFile, unless it is empty
+		explicit MainComponent(const File& eventLogFile = File());
 		~MainComponent();
 
 		//==============================================================================
@@ -78,32 +35,46 @@ class MainComponent   : public AudioAppComponent, public Timer
 		//==============================================================================
 		void paint (Graphics& g) override;
 		void resized() override;
-		void createSinWavetable();
-		void createSawWavetable();
-		void createSquareWavetable();
-		void createTriWavetable();
-		void createWavetableHarmonics();
-		void createNoiseWavetable();
-		double poly_blep(double t, double mPhaseIncrement);
 
 	private:
+		//starts numberOfOscillators voices on the note the frequency slider is set to
+		void startNotes();
+
 		//==============================================================================
-		//SinOsc std::sin variables
-		double currentSampleRate = 0.0;
-		float currentAngle = 0.0f, angleDelta = 0.0f;
-		float level = 0.0f;
-		OwnedArray<SineOscillator> oscillators;
-		OwnedArray<WavetableOscillator> tabOscillators;
-
-		//wavetable variables
-		AudioSampleBuffer oscTable;
-		const unsigned int tableSize = 1 << 7; //resolution of 128
-	
+		//the oscillators and everything the audio thread needs; this component only adds the device and the controls
+		SynthEngine engine;
+
 		//CPU monitoring
 		Label cpuUsageLabel;
 		Label cpuUsageText;
+
+		//per-block timing, drained from the engine on the timer
+		BlockTimingHistogram blockTimings;
+		Label blockTimingText;
+
+		//where the engine's events go when the app was started with --record, drained on the timer
+		std::unique_ptr<EventLogWriter> eventLog;
+
+		//which SIMD kernels the engine ended up with on this machine
+		Label kernelText;
+
 		ComboBox waveSelect;
 		Slider freqSlider;
+		Slider gainSlider;
+		TextButton pluckButton;
+		Slider pulseWidthSlider;
+		ComboBox oversamplingSelect;
+		ComboBox interpolationSelect;
+		ComboBox subBlockSelect;
+		TextButton loadBankButton;
+		Slider bankPositionSlider;
+		std::unique_ptr<FileChooser> bankChooser;
+
+		//searches for the most voices of each type the device keeps up with, and what it found so far
+		LiveCapacityTest stressTest { deviceManager };
+		TextButton stressButton;
+		Label stressText;
+		String stressResults;
 
 		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainComponent)
 };
@@ -0,0 +1,279 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+#include <iostream>
+
+//the names accepted by --wave, in the order of WavetableSet::Shape
+static const char* const waveNames[] = { "sine", "tri", "harmonics", "saw", "square", "noise" };
+static const char* const voiceTypeNames[] = { "sine", "wavetable", "pluck", "polyblep", "oversampled", "bank" };
+
+//==============================================================================
+bool OfflineRenderer::isRenderCommandLine(const String& commandLine)
+{
+	return StringArray::fromTokens(commandLine, true).contains("--render");
+}
+
+bool OfflineRenderer::parseCommandLine(const String& commandLine, Options& options, String& errorMessage)
+{
+	auto args = StringArray::fromTokens(commandLine, true);
+
+	for (auto i = 0; i < args.size(); ++i)
+	{
+		auto arg = args[i];
+
+		//every option takes exactly one value
+		if (i + 1 >= args.size())
+		{
+			errorMessage = "Missing value for " + arg;
+			return false;
+		}
+
+		auto value = args[++i].unquoted();
+
+		if (arg == "--render")
+			options.outputFile = File::getCurrentWorkingDirectory().getChildFile(value);
+		else if (arg == "--seconds")
+			options.seconds = value.getDoubleValue();
+		else if (arg == "--voices")
+			options.numVoices = value.getIntValue();
+		else if (arg == "--frequency")
+			options.frequency = value.getFloatValue();
+		else if (arg == "--samplerate")
+			options.sampleRate = value.getDoubleValue();
+		else if (arg == "--blocksize")
+			options.blockSize = value.getIntValue();
+		else if (arg == "--subblock")
+			options.subBlockSize = value.getIntValue();
+		else if (arg == "--threads")
+			options.numWorkerThreads = value.getIntValue();
+		else if (arg == "--tablesize")
+			options.tableSize = value.getIntValue();
+		else if (arg == "--interpolation")
+		{
+			if (! TableInterpolation::parseModeName(value, options.interpolation))
+			{
+				errorMessage = "Unknown interpolation " + value + " (use truncate, linear, hermite or lagrange)";
+				return false;
+			}
+		}
+		else if (arg == "--pulsewidth")
+			options.pulseWidth = value.getFloatValue();
+		else if (arg == "--oversampling")
+			options.oversamplingFactor = value.getIntValue();
+		else if (arg == "--bank")
+			options.bankFile = File::getCurrentWorkingDirectory().getChildFile(value);
+		else if (arg == "--position")
+			options.bankPosition = value.getFloatValue();
+		else if (arg == "--framesize")
+			options.bankFrameSize = value.getIntValue();
+		else if (arg == "--kernel")
+		{
+			KernelDispatch::Level level;
+
+			if (value != "auto" && value != "bench" && ! KernelDispatch::parseLevelName(value, level))
+			{
+				errorMessage = "Unknown kernel " + value + " (use auto, bench, scalar, sse2, avx2 or avx512)";
+				return false;
+			}
+
+			options.kernel = value;
+		}
+		else if (arg == "--voice")
+		{
+			auto found = false;
+
+			for (auto type = 0; type < numElementsInArray(voiceTypeNames); ++type)
+			{
+				if (value.equalsIgnoreCase(voiceTypeNames[type]))
+				{
+					options.voiceType = (SynthEngine::VoiceType)type;
+					found = true;
+				}
+			}
+
+			if (! found)
+			{
+				errorMessage = "Unknown voice " + value + " (use sine, wavetable, pluck, polyblep, oversampled or bank)";
+				return false;
+			}
+		}
+		else if (arg == "--wave")
+		{
+			auto found = false;
+
+			for (auto shape = 0; shape < numElementsInArray(waveNames); ++shape)
+			{
+				if (value.equalsIgnoreCase(waveNames[shape]))
+				{
+					options.shape = (WavetableSet::Shape)shape;
+					found = true;
+				}
+			}
+
+			if (! found)
+			{
+				errorMessage = "Unknown waveform " + value + " (use sine, tri, harmonics, saw, square or noise)";
+				return false;
+			}
+		}
+		else
+		{
+			errorMessage = "Unknown option " + arg;
+			return false;
+		}
+	}
+
+	if (options.outputFile.getFullPathName().isEmpty())
+		errorMessage = "No output file given";
+	else if (options.seconds <= 0.0)
+		errorMessage = "--seconds has to be greater than zero";
+	else if (options.numVoices < 1)
+		errorMessage = "--voices has to be at least 1";
+	else if (options.sampleRate < 8000.0)
+		errorMessage = "--samplerate has to be at least 8000";
+	else if (options.blockSize < 1)
+		errorMessage = "--blocksize has to be at least 1";
+	else if (! SynthEngine::isValidSubBlockSize(options.subBlockSize))
+		errorMessage = "--subblock has to be 16, 32 or 64, or 0 to render the blocks as they are";
+	else if (options.tableSize < 16 || ! isPowerOfTwo(options.tableSize))
+		errorMessage = "--tablesize has to be a power of two, at least 16";
+	else if (options.pulseWidth <= 0.0f || options.pulseWidth >= 1.0f)
+		errorMessage = "--pulsewidth has to be between 0 and 1";
+	else if (options.oversamplingFactor < 1 || options.oversamplingFactor > HalfbandDecimator::maxFactor || ! isPowerOfTwo(options.oversamplingFactor))
+		errorMessage = "--oversampling has to be 1, 2, 4 or 8";
+	else if (options.voiceType == SynthEngine::VoiceType::wavetableBank && options.bankFile.getFullPathName().isEmpty())
+		errorMessage = "--voice bank needs a --bank file to play";
+	else if (options.bankPosition < 0.0f || options.bankPosition > 1.0f)
+		errorMessage = "--position has to be between 0 and 1";
+	else if (options.bankFrameSize < WavetableBank::minFrameSize || options.bankFrameSize > WavetableBank::maxFrameSize || ! isPowerOfTwo(options.bankFrameSize))
+		errorMessage = "--framesize has to be a power of two from 16 to 65536";
+
+	return errorMessage.isEmpty();
+}
+
+//==============================================================================
+OfflineRenderer::OfflineRenderer(const Options& optionsToUse)
+	: options(optionsToUse)
+{
+}
+
+int OfflineRenderer::run()
+{
+	//The engine always renders in stereo, like the device callback.
+	const int numChannels = 2;
+
+	options.outputFile.deleteFile();
+	std::unique_ptr<FileOutputStream> stream (new FileOutputStream(options.outputFile));
+
+	if (stream->failedToOpen())
+	{
+		std::cerr << "Couldn't open " << options.outputFile.getFullPathName() << " for writing" << std::endl;
+		return 1;
+	}
+
+	WavAudioFormat wavFormat;
+	std::unique_ptr<AudioFormatWriter> writer (wavFormat.createWriterFor(stream.get(), options.sampleRate, (unsigned int)numChannels, 24, {}, 0));
+
+	if (writer == nullptr)
+	{
+		std::cerr << "Couldn't create a wav writer for " << options.outputFile.getFullPathName() << std::endl;
+		return 1;
+	}
+
+	//the writer owns the stream from here on
+	stream.release();
+
+	//Set everything up the same way the GUI would, then let prepareToPlay pick up the queued values.
+	SynthEngine engine(options.numVoices, options.voiceType, options.numWorkerThreads);
+	engine.setWaveform(options.shape);
+	engine.setPulseWidth(options.pulseWidth);
+	engine.setOversamplingFactor(options.oversamplingFactor);
+	engine.setSubBlockSize(options.subBlockSize);
+
+	engine.setInterpolation(options.interpolation);
+
+	if (options.tableSize != engine.getTableSize())
+		engine.setTableSize(options.tableSize);
+
+	if (options.voiceType == SynthEngine::VoiceType::wavetableBank)
+	{
+		String errorMessage;
+
+		if (! engine.loadWavetableBank(options.bankFile, errorMessage, options.bankFrameSize))
+		{
+			std::cerr << errorMessage << std::endl;
+			return 1;
+		}
+
+		engine.setBankPosition(options.bankPosition);
+	}
+
+	KernelDispatch::Level level;
+
+	if (options.kernel == "bench")
+		engine.setKernelSelfBenchmark(true);
+	else if (KernelDispatch::parseLevelName(options.kernel, level))
+		KernelDispatch::setActiveLevel(level);
+
+	for (auto i = 0; i < options.numVoices; ++i)
+		engine.startNote(0, options.frequency, 1.0f);
+
+	engine.prepareToPlay(options.blockSize, options.sampleRate);
+
+	AudioBuffer<float> buffer(numChannels, options.blockSize);
+	auto totalSamples = (int64)(options.seconds * options.sampleRate);
+	int64 renderTicks = 0;
+	BlockTimingHistogram blockTimings;
+	auto startTicks = Time::getHighResolutionTicks();
+
+	for (int64 position = 0; position < totalSamples; position += options.blockSize)
+	{
+		auto numSamples = (int)jmin((int64)options.blockSize, totalSamples - position);
+		AudioSourceChannelInfo info(&buffer, 0, numSamples);
+
+		//only the engine is timed for the render figure; writing the file is added in for the overall one
+		auto blockStart = Time::getHighResolutionTicks();
+		engine.getNextAudioBlock(info);
+		renderTicks += Time::getHighResolutionTicks() - blockStart;
+		blockTimings.drain(engine.getTimingMonitor());
+
+		if (! writer->writeFromAudioSampleBuffer(buffer, 0, numSamples))
+		{
+			std::cerr << "Writing to " << options.outputFile.getFullPathName() << " failed" << std::endl;
+			return 1;
+		}
+	}
+
+	engine.releaseResources();
+	writer.reset();
+
+	auto renderSeconds = Time::highResolutionTicksToSeconds(renderTicks);
+	auto wallSeconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - startTicks);
+	auto audioSeconds = (double)totalSamples / options.sampleRate;
+
+	//the waveform only matters to the wavetable, PolyBLEP and oversampled voices, the bank plays its own frames
+	auto sound = options.voiceType == SynthEngine::VoiceType::wavetable ? String(waveNames[(int)options.shape]) + " (" + String(options.tableSize) + " samples, "
+																		  + TableInterpolation::getModeName(options.interpolation) + ")"
+			   : options.voiceType == SynthEngine::VoiceType::wavetableBank ? options.bankFile.getFileName() + " (" + String(engine.getWavetableBank()->getNumFrames()) + " frames of "
+																			  + String(engine.getWavetableBank()->getFrameSize()) + ") at position " + String(options.bankPosition)
+			   : options.voiceType == SynthEngine::VoiceType::polyBlep ? String(voiceTypeNames[(int)options.voiceType]) + " " + waveNames[(int)options.shape]
+			   : options.voiceType == SynthEngine::VoiceType::oversampled ? String(options.oversamplingFactor) + "x " + voiceTypeNames[(int)options.voiceType] + " " + waveNames[(int)options.shape]
+																		: String(voiceTypeNames[(int)options.voiceType]);
+
+	std::cout << "Rendered " << audioSeconds << " s of " << sound
+			  << " with " << options.numVoices << " voices and " << engine.getNumWorkerThreads() << " worker threads to " << options.outputFile.getFullPathName() << std::endl
+			  << "engine:  " << audioSeconds / jmax(renderSeconds, 1.0e-9) << " rendered seconds per wall second (" << renderSeconds << " s)" << std::endl
+			  << "overall: " << audioSeconds / jmax(wallSeconds, 1.0e-9) << " rendered seconds per wall second (" << wallSeconds << " s, including the file)" << std::endl
+			  << "blocks:  min " << blockTimings.getMinMicroseconds() << " / avg " << blockTimings.getAverageMicroseconds()
+			  << " / p99 " << blockTimings.getPercentileMicroseconds(99.0) << " / max " << blockTimings.getMaxMicroseconds() << " us, "
+			  << blockTimings.getNumDeadlineMisses() << " of " << blockTimings.getNumBlocks() << " slower than real time" << std::endl
+			  << "kernel:  " << KernelDispatch::getDescription() << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,60 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "SynthEngine.h"
+
+//Renders the synth engine straight into a wav file, without a window or an audio device, e.g.
+//
+//	AudioApp_juce --render out.wav --seconds 60 --voices 512 --wave saw
+//
+//The engine is pulled block by block as fast as it will go, so the time it takes gives a throughput figure
+//(seconds of audio rendered per second of wall-clock time) that doesn't depend on the sound card.
+class OfflineRenderer
+{
+	public:
+		struct Options
+		{
+			File outputFile;
+			double seconds = 10.0;
+			int numVoices = 1;
+			SynthEngine::VoiceType voiceType = SynthEngine::VoiceType::wavetable;
+			WavetableSet::Shape shape = WavetableSet::Shape::saw;
+			float frequency = 440.0f;
+			double sampleRate = 48000.0;
+			int blockSize = 512;
+			int subBlockSize = 32;		//samples the engine renders at a time, 16, 32 or 64, or 0 to follow blockSize
+			int numWorkerThreads = -1;	//-1 lets the engine decide
+			int tableSize = 2048;		//samples per cycle of the wavetables, a power of two
+			TableInterpolation::Mode interpolation = TableInterpolation::Mode::linear;	//how the wavetable voices read their tables
+			float pulseWidth = 0.5f;	//for the PolyBLEP pulse and triangle
+			int oversamplingFactor = 4;	//for the oversampled voices: 1, 2, 4 or 8
+			File bankFile;				//what the wavetable bank voices play
+			float bankPosition = 0.0f;	//through the bank's frames, 0 to 1
+			int bankFrameSize = 2048;	//for banks that don't say how long their frames are
+			String kernel = "auto";		//auto keeps the cpuid pick, bench times them all, or a KernelDispatch level name
+		};
+
+		//true if the command line asks for an offline render instead of the GUI
+		static bool isRenderCommandLine(const String& commandLine);
+
+		//fills options from the command line; returns false and describes the problem in errorMessage if it can't
+		static bool parseCommandLine(const String& commandLine, Options& options, String& errorMessage);
+
+		explicit OfflineRenderer(const Options& optionsToUse);
+
+		//renders the whole file and prints the throughput; returns the process exit code
+		int run();
+
+	private:
+		Options options;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineRenderer)
+};
@@ -0,0 +1,585 @@
+/*
+  ==============================================================================
+
+    OscillatorBenchmark.cpp
+
+  ==============================================================================
+*/
+
+#include "OscillatorBenchmark.h"
+#include "BenchmarkReport.h"
+#include "Oscillators.h"
+#include "VoiceBank.h"
+#include "PolyBlepOscillator.h"
+#include "HalfbandDecimator.h"
+#include "RenderWorkerPool.h"
+#include "SimdConfig.h"
+#include <iostream>
+
+//every measurement renders at least this many blocks, however long they take
+static const int minBlocksPerRun = 3;
+
+static const char* const typeNames[] = { "sine", "wavetable", "wavetableBlock", "voiceBank", "voiceBankThreaded", "sineQuadrature", "sinePolynomial", "polyBlep",
+										 "naive", "oversampled2x", "oversampled4x", "oversampled8x" };
+
+static bool isSineType(OscillatorBenchmark::OscillatorType type)
+{
+	return type == OscillatorBenchmark::OscillatorType::sine
+		|| type == OscillatorBenchmark::OscillatorType::sineQuadrature
+		|| type == OscillatorBenchmark::OscillatorType::sinePolynomial;
+}
+
+//the naive saw at 1, 2, 4 or 8 times the rate, or 0 for the types that aren't one
+static int getOversamplingFactor(OscillatorBenchmark::OscillatorType type)
+{
+	switch (type)
+	{
+		case OscillatorBenchmark::OscillatorType::naive:			return 1;
+		case OscillatorBenchmark::OscillatorType::oversampled2x:	return 2;
+		case OscillatorBenchmark::OscillatorType::oversampled4x:	return 4;
+		case OscillatorBenchmark::OscillatorType::oversampled8x:	return 8;
+		default:													return 0;
+	}
+}
+
+//the types that compute their waveform instead of reading it from a table
+static bool isTablelessType(OscillatorBenchmark::OscillatorType type)
+{
+	return isSineType(type) || type == OscillatorBenchmark::OscillatorType::polyBlep || getOversamplingFactor(type) > 0;
+}
+
+//the mode behind a name in Options::interpolationModes; "none", which the tableless types report, reads as truncate
+static TableInterpolation::Mode getInterpolationMode(const String& name)
+{
+	auto mode = TableInterpolation::Mode::linear;
+	TableInterpolation::parseModeName(name, mode);
+	return mode;
+}
+
+//==============================================================================
+//The oscillators of one type, all built before the clock starts, rendering a block the same way the engine does.
+class BenchmarkVoices
+{
+	public:
+		using OscillatorType = OscillatorBenchmark::OscillatorType;
+
+		BenchmarkVoices(OscillatorType typeToUse, const WavetableSet& wavetables, TableInterpolation::Mode interpolation,
+						const Array<float>& frequencies, double sampleRate, int blockSize)
+			: type(typeToUse),
+			oversamplingFactor(getOversamplingFactor(type)),
+			workerPool(type == OscillatorType::voiceBankThreaded ? RenderWorkerPool::getDefaultNumWorkers(frequencies.size()) : 0)
+		{
+			workerPool.prepare(blockSize, sampleRate);
+
+			if (isSineType(type))
+			{
+				auto mode = type == OscillatorType::sineQuadrature ? SineOscillator::Mode::quadrature
+						  : type == OscillatorType::sinePolynomial ? SineOscillator::Mode::polynomial
+						  : SineOscillator::Mode::libm;
+
+				for (auto frequency : frequencies)
+				{
+					auto* oscillator = sineOscillators.add(new SineOscillator());
+					oscillator->setMode(mode);
+					oscillator->setFrequency(frequency, (float)sampleRate);
+				}
+			}
+			else if (type == OscillatorType::polyBlep || oversamplingFactor > 0)
+			{
+				//the oversampled voices run at the higher rate and share one buffer and one decimator, as in the engine
+				auto voiceRate = (float)sampleRate * (float)jmax(1, oversamplingFactor);
+
+				for (auto frequency : frequencies)
+					blepOscillators.add(new PolyBlepOscillator())->setFrequency(frequency, voiceRate);
+
+				if (oversamplingFactor > 1)
+				{
+					oversampled.allocate((size_t)(blockSize * oversamplingFactor), true);
+					decimated.allocate((size_t)blockSize, true);
+					decimator.prepare(blockSize);
+					decimator.setFactor(oversamplingFactor);
+				}
+			}
+			else if (type == OscillatorType::voiceBank || type == OscillatorType::voiceBankThreaded)
+			{
+				voiceBank.setCapacity(frequencies.size());
+				voiceBank.setWavetableSet(&wavetables);
+				voiceBank.setInterpolation(interpolation);
+
+				for (auto frequency : frequencies)
+					voiceBank.addVoice(frequency, (float)sampleRate, 1.0f);
+			}
+			else
+			{
+				for (auto frequency : frequencies)
+				{
+					auto* oscillator = wavetableOscillators.add(new WavetableOscillator(wavetables));
+					oscillator->setInterpolation(interpolation);
+					oscillator->setFrequency(frequency, (float)sampleRate);
+				}
+			}
+		}
+
+		//renders one block of every voice, added into dest
+		void render(float* dest, int numSamples) noexcept
+		{
+			switch (type)
+			{
+				case OscillatorType::sine:
+					for (auto* oscillator : sineOscillators)
+						for (auto sample = 0; sample < numSamples; ++sample)
+							dest[sample] += oscillator->getNextSample();
+					break;
+
+				case OscillatorType::wavetable:
+					for (auto* oscillator : wavetableOscillators)
+						for (auto sample = 0; sample < numSamples; ++sample)
+							dest[sample] += oscillator->getNextSample();
+					break;
+
+				case OscillatorType::wavetableBlock:
+					for (auto* oscillator : wavetableOscillators)
+						oscillator->renderBlock(dest, numSamples, 1.0f);
+					break;
+
+				case OscillatorType::voiceBank:
+					voiceBank.renderBlock(dest, numSamples);
+					break;
+
+				case OscillatorType::voiceBankThreaded:
+					workerPool.renderBlock(voiceBank, dest, numSamples);
+					break;
+
+				case OscillatorType::sineQuadrature:
+				case OscillatorType::sinePolynomial:
+					for (auto* oscillator : sineOscillators)
+						oscillator->renderBlock(dest, numSamples, 1.0f);
+					break;
+
+				case OscillatorType::polyBlep:
+					for (auto* oscillator : blepOscillators)
+						oscillator->renderBlock<PolyBlepOscillator::Shape::saw>(dest, numSamples, 1.0f);
+					break;
+
+				case OscillatorType::naive:
+					for (auto* oscillator : blepOscillators)
+						oscillator->renderBlock<PolyBlepOscillator::Shape::saw, false>(dest, numSamples, 1.0f);
+					break;
+
+				case OscillatorType::oversampled2x:
+				case OscillatorType::oversampled4x:
+				case OscillatorType::oversampled8x:
+				{
+					auto numOversampled = numSamples * oversamplingFactor;
+					FloatVectorOperations::clear(oversampled, numOversampled);
+
+					for (auto* oscillator : blepOscillators)
+						oscillator->renderBlock<PolyBlepOscillator::Shape::saw, false>(oversampled, numOversampled, 1.0f);
+
+					decimator.process(oversampled, decimated, numSamples);
+					FloatVectorOperations::add(dest, decimated, numSamples);
+					break;
+				}
+
+				default:
+					break;
+			}
+		}
+
+		int getNumThreads() const noexcept	{ return workerPool.getNumWorkers() + 1; }
+
+	private:
+		const OscillatorType type;
+		const int oversamplingFactor;
+
+		OwnedArray<SineOscillator> sineOscillators;
+		OwnedArray<WavetableOscillator> wavetableOscillators;
+		OwnedArray<PolyBlepOscillator> blepOscillators;
+		VoiceBank voiceBank;
+		RenderWorkerPool workerPool;
+
+		HeapBlock<float> oversampled, decimated;
+		HalfbandDecimator decimator;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BenchmarkVoices)
+};
+
+//==============================================================================
+bool OscillatorBenchmark::isBenchmarkCommandLine(const String& commandLine)
+{
+	return StringArray::fromTokens(commandLine, true).contains("--benchmark");
+}
+
+bool OscillatorBenchmark::parseCommandLine(const String& commandLine, Options& options, String& errorMessage)
+{
+	auto args = StringArray::fromTokens(commandLine, true);
+
+	for (auto i = 0; i < args.size(); ++i)
+	{
+		auto arg = args[i];
+
+		if (arg == "--benchmark")
+			continue;
+
+		//every other option takes exactly one value
+		if (i + 1 >= args.size())
+		{
+			errorMessage = "Missing value for " + arg;
+			return false;
+		}
+
+		auto value = args[++i].unquoted();
+
+		if (arg == "--types")
+		{
+			options.types.clear();
+
+			for (auto& token : StringArray::fromTokens(value, ",", ""))
+			{
+				auto type = -1;
+
+				for (auto t = 0; t < numElementsInArray(typeNames); ++t)
+					if (token.trim().equalsIgnoreCase(typeNames[t]))
+						type = t;
+
+				if (type < 0)
+				{
+					errorMessage = "Unknown oscillator type " + token + " (use sine, wavetable, wavetableBlock, voiceBank, voiceBankThreaded, sineQuadrature, sinePolynomial, polyBlep, naive, oversampled2x, oversampled4x or oversampled8x)";
+					return false;
+				}
+
+				options.types.add((OscillatorType)type);
+			}
+		}
+		else if (arg == "--interpolation")
+		{
+			//stored under their canonical names, so "none" shows up as truncate in the results
+			options.interpolationModes.clear();
+
+			for (auto& token : StringArray::fromTokens(value, ",", ""))
+			{
+				TableInterpolation::Mode mode;
+
+				if (! TableInterpolation::parseModeName(token, mode))
+				{
+					errorMessage = "Unknown interpolation mode " + token + " (use truncate, linear, hermite or lagrange)";
+					return false;
+				}
+
+				options.interpolationModes.add(TableInterpolation::getModeName(mode));
+			}
+		}
+		else if (arg == "--tablesizes" || arg == "--blocksizes" || arg == "--voices")
+		{
+			auto& values = arg == "--tablesizes" ? options.tableSizes
+						 : arg == "--blocksizes" ? options.blockSizes
+						 : options.voiceCounts;
+
+			if (! BenchmarkReport::parseIntList(value, values))
+			{
+				errorMessage = arg + " needs a comma separated list of positive numbers";
+				return false;
+			}
+		}
+		else if (arg == "--seconds-per-run")
+			options.secondsPerRun = value.getDoubleValue();
+		else if (arg == "--samplerate")
+			options.sampleRate = value.getDoubleValue();
+		else if (arg == "--format")
+		{
+			if (value != "csv" && value != "json")
+			{
+				errorMessage = "Unknown format " + value + " (use csv or json)";
+				return false;
+			}
+
+			options.json = value == "json";
+		}
+		else if (arg == "--output")
+			options.outputFile = File::getCurrentWorkingDirectory().getChildFile(value);
+		else if (arg == "--label")
+			options.label = value;
+		else if (arg == "--kernels")
+		{
+			options.kernels.clear();
+
+			for (auto& token : StringArray::fromTokens(value, ",", ""))
+			{
+				KernelDispatch::Level level;
+
+				if (! KernelDispatch::parseLevelName(token.trim(), level))
+				{
+					errorMessage = "Unknown kernel " + token + " (use scalar, sse2, avx2 or avx512)";
+					return false;
+				}
+
+				if (! KernelDispatch::isSupported(level))
+				{
+					errorMessage = "This machine can't run the " + token.trim() + " kernels";
+					return false;
+				}
+
+				options.kernels.add(level);
+			}
+		}
+		else
+		{
+			errorMessage = "Unknown option " + arg;
+			return false;
+		}
+	}
+
+	//the inverse FFT behind WavetableSet only handles powers of two
+	for (auto tableSize : options.tableSizes)
+		if (! isPowerOfTwo(tableSize) || tableSize < 8)
+			errorMessage = "Table sizes have to be powers of two of at least 8";
+
+	if (options.secondsPerRun <= 0.0)
+		errorMessage = "--seconds-per-run has to be greater than zero";
+	else if (options.sampleRate < 8000.0)
+		errorMessage = "--samplerate has to be at least 8000";
+
+	return errorMessage.isEmpty();
+}
+
+String OscillatorBenchmark::getTypeName(OscillatorType type)
+{
+	return typeNames[(int)type];
+}
+
+//==============================================================================
+OscillatorBenchmark::OscillatorBenchmark(const Options& optionsToUse)
+	: options(optionsToUse)
+{
+}
+
+int OscillatorBenchmark::run()
+{
+	auto kernels = options.kernels;
+	auto initialKernel = KernelDispatch::getActiveLevel();
+
+	if (kernels.isEmpty())
+		kernels.add(initialKernel);
+
+	for (auto kernel : kernels)
+	{
+		KernelDispatch::setActiveLevel(kernel);
+
+		for (auto tableSize : options.tableSizes)
+		{
+			//a saw keeps every level of the set full of harmonics; the render cost doesn't depend on the shape anyway
+			WavetableSet wavetables(WavetableSet::Shape::saw, tableSize);
+
+			for (auto type : options.types)
+			{
+				//the sine and PolyBLEP oscillators have no table and no interpolation, so they only run for the first table size
+				if (isTablelessType(type) && tableSize != options.tableSizes.getFirst())
+					continue;
+
+				StringArray interpolationModes;
+
+				if (isTablelessType(type))
+					interpolationModes.add("none");
+				else
+					interpolationModes = options.interpolationModes;
+
+				for (auto& interpolation : interpolationModes)
+				{
+					//The aliasing only depends on the type, the table and the interpolation, not on the block size or
+					//the number of voices. For the table types it includes the interpolation noise, which is what
+					//the higher orders get rid of.
+					auto aliasingDb = measureAliasing(type, wavetables, interpolation);
+
+					for (auto blockSize : options.blockSizes)
+					{
+						for (auto numVoices : options.voiceCounts)
+						{
+							auto result = measure(type, wavetables, interpolation, blockSize, numVoices);
+							result.aliasingDb = aliasingDb;
+							results.add(result);
+
+							std::cerr << KernelDispatch::getLevelName(kernel) << " " << getTypeName(type) << " table " << result.tableSize << " " << interpolation
+									  << " block " << blockSize << " voices " << numVoices << ": "
+									  << result.nsPerSample << " ns/sample, " << result.voicesPerCore << " voices/core, aliasing " << aliasingDb << " dB" << std::endl;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	KernelDispatch::setActiveLevel(initialKernel);
+
+	auto text = options.json ? createJson() : createCsv();
+
+	if (options.outputFile.getFullPathName().isEmpty())
+	{
+		std::cout << text;
+	}
+	else if (! options.outputFile.replaceWithText(text))
+	{
+		std::cerr << "Couldn't write " << options.outputFile.getFullPathName() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
+
+OscillatorBenchmark::Result OscillatorBenchmark::measure(OscillatorType type, const WavetableSet& wavetables, const String& interpolation,
+														  int blockSize, int numVoices)
+{
+	//The same seed every run, so every type plays the same spread of notes (C3 to C6) and picks the same mipmap levels.
+	Random random(1);
+	Array<float> frequencies;
+
+	for (auto i = 0; i < numVoices; ++i)
+		frequencies.add((float)MidiMessage::getMidiNoteInHertz(48 + random.nextInt(37)));
+
+	//build whichever oscillators the type needs before the clock starts
+	BenchmarkVoices voices(type, wavetables, getInterpolationMode(interpolation), frequencies, options.sampleRate, blockSize);
+
+	HeapBlock<float> buffer((size_t)blockSize, true);
+
+	//one untimed block first, so the tables and voices are in the cache like they would be in a running synth
+	voices.render(buffer, blockSize);
+
+	auto budget = Time::secondsToHighResolutionTicks(options.secondsPerRun);
+	int64 totalTicks = 0, minTicks = std::numeric_limits<int64>::max();
+	int64 numBlocks = 0;
+	auto sink = 0.0f;
+
+	while (numBlocks < minBlocksPerRun || totalTicks < budget)
+	{
+		FloatVectorOperations::clear(buffer, blockSize);
+
+		auto start = Time::getHighResolutionTicks();
+		voices.render(buffer, blockSize);
+		auto ticks = Time::getHighResolutionTicks() - start;
+
+		totalTicks += ticks;
+		minTicks = jmin(minTicks, ticks);
+		++numBlocks;
+
+		//reading the output keeps the compiler from dropping the render as dead code
+		sink += buffer[blockSize - 1];
+	}
+
+	static volatile float resultSink;
+	resultSink = sink;
+
+	auto voiceSamplesPerBlock = (double)blockSize * numVoices;
+
+	Result result;
+	result.kernel = KernelDispatch::getActiveLevel();
+	result.type = type;
+	result.tableSize = isTablelessType(type) ? 0 : wavetables.getTableSize();
+	result.interpolation = interpolation;
+	result.blockSize = blockSize;
+	result.numVoices = numVoices;
+	result.numThreads = voices.getNumThreads();
+	result.voiceSamples = numBlocks * (int64)voiceSamplesPerBlock;
+	result.nsPerSample = Time::highResolutionTicksToSeconds(totalTicks) * 1.0e9 / (numBlocks * voiceSamplesPerBlock);
+	result.minNsPerSample = Time::highResolutionTicksToSeconds(minTicks) * 1.0e9 / voiceSamplesPerBlock;
+
+	//one core has 1e9 ns per second to spend, and every real-time voice needs sampleRate samples in that second
+	result.voicesPerCore = 1.0e9 / (jmax(result.nsPerSample, 1.0e-6) * options.sampleRate);
+	result.aliasingDb = 0.0;
+
+	return result;
+}
+
+double OscillatorBenchmark::measureAliasing(OscillatorType type, const WavetableSet& wavetables, const String& interpolation) const
+{
+	//213 cycles in 4096 samples: about 2.5 kHz at 48 kHz, with plenty of harmonics folding back over Nyquist
+	const int numSamples = 4096;
+	const int toneBin = 213;
+	const int blockSize = 256;
+
+	Array<float> frequency;
+	frequency.add((float)(options.sampleRate * toneBin / numSamples));
+	BenchmarkVoices voice(type, wavetables, getInterpolationMode(interpolation), frequency, options.sampleRate, blockSize);
+
+	//one pass to let the decimator's filters fill up, then the one that is analysed
+	HeapBlock<float> signal((size_t)numSamples, true);
+
+	for (auto pass = 0; pass < 2; ++pass)
+	{
+		FloatVectorOperations::clear(signal, numSamples);
+
+		for (auto start = 0; start < numSamples; start += blockSize)
+			voice.render(signal + start, blockSize);
+	}
+
+	//A plain DFT is fast enough for one measurement per type. Bins that are multiples of toneBin hold the harmonics;
+	//every other bin is energy that shouldn't be there, which for these oscillators is all aliasing.
+	HeapBlock<double> cosines((size_t)numSamples), sines((size_t)numSamples);
+
+	for (auto i = 0; i < numSamples; ++i)
+	{
+		cosines[i] = std::cos(MathConstants<double>::twoPi * i / numSamples);
+		sines[i] = std::sin(MathConstants<double>::twoPi * i / numSamples);
+	}
+
+	auto harmonicEnergy = 0.0, aliasEnergy = 0.0;
+
+	for (auto bin = 1; bin < numSamples / 2; ++bin)
+	{
+		auto re = 0.0, im = 0.0;
+
+		for (auto i = 0, phase = 0; i < numSamples; ++i, phase = (phase + bin) % numSamples)
+		{
+			re += signal[i] * cosines[phase];
+			im -= signal[i] * sines[phase];
+		}
+
+		(bin % toneBin == 0 ? harmonicEnergy : aliasEnergy) += re * re + im * im;
+	}
+
+	return 10.0 * std::log10(jmax(aliasEnergy, 1.0e-30) / jmax(harmonicEnergy, 1.0e-30));
+}
+
+//==============================================================================
+String OscillatorBenchmark::createCsv() const
+{
+	String csv = "label,kernel,type,table_size,interpolation,block_size,voices,threads,voice_samples,ns_per_sample,min_ns_per_sample,voices_per_core,aliasing_db\n";
+
+	for (auto& result : results)
+	{
+		csv << options.label.quoted() << "," << KernelDispatch::getLevelName(result.kernel) << "," << getTypeName(result.type) << ","
+			<< result.tableSize << "," << result.interpolation << "," << result.blockSize << "," << result.numVoices << "," << result.numThreads << ","
+			<< result.voiceSamples << "," << String(result.nsPerSample, 4) << "," << String(result.minNsPerSample, 4) << ","
+			<< String(result.voicesPerCore, 1) << "," << String(result.aliasingDb, 1) << "\n";
+	}
+
+	return csv;
+}
+
+String OscillatorBenchmark::createJson() const
+{
+	auto root = BenchmarkReport::createJsonRoot(options.label);
+	root->setProperty("sampleRate", options.sampleRate);
+
+	Array<var> rows;
+
+	for (auto& result : results)
+	{
+		DynamicObject::Ptr row = new DynamicObject();
+		row->setProperty("kernel", KernelDispatch::getLevelName(result.kernel));
+		row->setProperty("type", getTypeName(result.type));
+		row->setProperty("tableSize", result.tableSize);
+		row->setProperty("interpolation", result.interpolation);
+		row->setProperty("blockSize", result.blockSize);
+		row->setProperty("voices", result.numVoices);
+		row->setProperty("threads", result.numThreads);
+		row->setProperty("voiceSamples", result.voiceSamples);
+		row->setProperty("nsPerSample", result.nsPerSample);
+		row->setProperty("minNsPerSample", result.minNsPerSample);
+		row->setProperty("voicesPerCore", result.voicesPerCore);
+		row->setProperty("aliasingDb", result.aliasingDb);
+		rows.add(var(row.get()));
+	}
+
+	root->setProperty("results", rows);
+
+	return JSON::toString(var(root.get())) + "\n";
+}
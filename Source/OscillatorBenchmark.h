@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    OscillatorBenchmark.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "WavetableSet.h"
+#include "KernelDispatch.h"
+
+//Times the oscillator implementations against each other without an audio device, e.g.
+//
+//	AudioApp_juce --benchmark --format json --output results.json --label 1a2b3c4
+//
+//Every combination of kernel, oscillator type, table size, interpolation mode, block size and voice count is rendered
+//for a fixed amount of wall-clock time. Each row reports nanoseconds per voice-sample and how many voices a
+//single core could keep running in real time at the benchmark sample rate, next to how much aliasing the type lets
+//through, so the anti-aliasing strategies can be weighed against what they cost. The results are written as CSV or JSON,
+//so runs on different commits can be compared directly.
+class OscillatorBenchmark
+{
+	public:
+		enum class OscillatorType
+		{
+			sine = 0,		//SineOscillator, std::sin per sample
+			wavetable,		//WavetableOscillator::getNextSample() per sample
+			wavetableBlock,	//WavetableOscillator::renderBlock()
+			voiceBank,		//all voices in one VoiceBank
+			voiceBankThreaded,	//the same VoiceBank split across a RenderWorkerPool with the default worker count
+			sineQuadrature,	//SineOscillator::renderBlock() with the rotating phasor kernel
+			sinePolynomial,	//SineOscillator::renderBlock() with the minimax polynomial kernel
+			polyBlep,		//PolyBlepOscillator::renderBlock() drawing a saw, like the wavetable types
+			naive,			//the same saw without the corrections, aliases and all
+			oversampled2x,	//the naive saw at 2, 4 or 8 times the rate, mixed and taken back down by a HalfbandDecimator
+			oversampled4x,
+			oversampled8x
+		};
+
+		struct Options
+		{
+			Array<OscillatorType> types { OscillatorType::sine, OscillatorType::wavetable, OscillatorType::wavetableBlock,
+										  OscillatorType::voiceBank, OscillatorType::voiceBankThreaded,
+										  OscillatorType::sineQuadrature, OscillatorType::sinePolynomial, OscillatorType::polyBlep,
+										  OscillatorType::naive, OscillatorType::oversampled2x, OscillatorType::oversampled4x,
+										  OscillatorType::oversampled8x };
+			Array<int> tableSizes { 256, 512, 1024, 2048, 4096 };
+			StringArray interpolationModes { "truncate", "linear", "hermite", "lagrange" };	//TableInterpolation::getModeName() names
+			Array<int> blockSizes { 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+			Array<int> voiceCounts { 1, 10, 100, 1000, 10000 };
+			double secondsPerRun = 0.1;
+			double sampleRate = 48000.0;
+			bool json = false;
+			File outputFile;		//stdout if not set
+			String label;			//free text stored with every result, e.g. the commit hash
+			Array<KernelDispatch::Level> kernels;	//empty runs only the one KernelDispatch picked for this CPU
+		};
+
+		struct Result
+		{
+			KernelDispatch::Level kernel;
+			OscillatorType type;
+			int tableSize;			//0 for the sine oscillators, which have no table
+			String interpolation;
+			int blockSize;
+			int numVoices;
+			int64 voiceSamples;		//voices * samples rendered while timing
+			double nsPerSample;		//averaged over every block
+			double minNsPerSample;	//the fastest block
+			double voicesPerCore;	//real-time voices one core could run at the average speed (for voiceBankThreaded: the whole pool)
+			int numThreads;			//threads that rendered, including the calling one
+			double aliasingDb;		//energy between the harmonics of a single voice relative to the harmonics themselves
+		};
+
+		//true if the command line asks for the benchmark instead of the GUI
+		static bool isBenchmarkCommandLine(const String& commandLine);
+
+		//fills options from the command line; returns false and describes the problem in errorMessage if it can't
+		static bool parseCommandLine(const String& commandLine, Options& options, String& errorMessage);
+
+		static String getTypeName(OscillatorType type);
+
+		explicit OscillatorBenchmark(const Options& optionsToUse);
+
+		//runs the whole sweep and writes the results; returns the process exit code
+		int run();
+
+	private:
+		//wavetables is ignored by the sine oscillators
+		Result measure(OscillatorType type, const WavetableSet& wavetables, const String& interpolation, int blockSize, int numVoices);
+
+		//Renders one voice at about 2.5 kHz, tuned to sit exactly on a DFT bin so every harmonic does too, and returns
+		//how far below the harmonics everything else is. That is the aliasing, apart from the sines, which have none,
+		//plus for the table types the noise of the interpolation.
+		double measureAliasing(OscillatorType type, const WavetableSet& wavetables, const String& interpolation) const;
+
+		String createCsv() const;
+		String createJson() const;
+
+		Options options;
+		Array<Result> results;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OscillatorBenchmark)
+};
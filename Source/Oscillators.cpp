@@ -0,0 +1,487 @@
+/*
+  ==============================================================================
+
+    Oscillators.cpp
+
+  ==============================================================================
+*/
+
+//https://docs.juce.com/master/tutorial_wavetable_synth.html
+
+#include "Oscillators.h"
+#include "SimdConfig.h"
+#include "KernelDispatch.h"
+
+/*
+  ==============================================================================
+
+	WavetableOsc
+
+  ==============================================================================
+*/
+void WavetableOscillator::setFrequency(float frequency, float sampleRate)
+{
+	phaseDelta = FixedPointPhase::getIncrement(frequency, sampleRate);
+
+	//every level has the same length, so the current phase carries over unchanged
+	wavetable = wavetables.getTable(wavetables.getLevelForPhaseDelta(FixedPointPhase::getTableDelta((float)phaseDelta, subTableSize)));
+}
+
+//Same maths as getNextSample(): index from the top bits of the phase, fraction from the rest, then the neighbours
+//the interpolation mode needs straight from the table. The lanes are offsets from the phase modulo 2^32, so they wrap
+//exactly the way getNextSample() does. Each returns how many samples it rendered and leaves the tail to the caller.
+#if AUDIOAPP_HAS_AVX2
+template <TableInterpolation::Mode mode>
+AUDIOAPP_TARGET_AVX2 static int renderWavetableAVX2(float* dest, int numSamples, float gain, const float* table, uint32& currentPhase,
+													uint32 phaseDelta, int indexShift, uint32 fractionMask, float fractionScale) noexcept
+{
+	const auto shiftV = _mm_cvtsi32_si128(indexShift);
+	const auto fractionMaskV = _mm256_set1_epi32((int32)fractionMask);
+	const auto fractionScaleV = _mm256_set1_ps(fractionScale);
+	const auto gainV = _mm256_set1_ps(gain);
+
+	//offset of each of the 8 lanes from currentPhase, and how far the whole group moves per iteration
+	const auto laneDeltas = _mm256_setr_epi32(0, (int32)phaseDelta, (int32)(phaseDelta * 2), (int32)(phaseDelta * 3),
+											  (int32)(phaseDelta * 4), (int32)(phaseDelta * 5), (int32)(phaseDelta * 6), (int32)(phaseDelta * 7));
+	const auto groupDelta = phaseDelta * 8;
+	auto sample = 0;
+
+	for (; sample + 8 <= numSamples; sample += 8)
+	{
+		auto phase = _mm256_add_epi32(_mm256_set1_epi32((int32)currentPhase), laneDeltas);
+		auto index0 = _mm256_srl_epi32(phase, shiftV);
+		auto frac = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(phase, fractionMaskV)), fractionScaleV);
+		auto currentSamples = TableInterpolation::interpolateAVX2(table, index0, frac, TableInterpolation::Tag<mode>());
+
+		auto* out = dest + sample;
+		_mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(out), _mm256_mul_ps(currentSamples, gainV)));
+
+		currentPhase += groupDelta;
+	}
+
+	_mm256_zeroupper();
+	return sample;
+}
+#endif
+
+#if AUDIOAPP_HAS_SSE2
+template <TableInterpolation::Mode mode>
+static int renderWavetableSSE2(float* dest, int numSamples, float gain, const float* table, uint32& currentPhase,
+							   uint32 phaseDelta, int indexShift, uint32 fractionMask, float fractionScale) noexcept
+{
+	const auto shiftV = _mm_cvtsi32_si128(indexShift);
+	const auto fractionMaskV = _mm_set1_epi32((int32)fractionMask);
+	const auto fractionScaleV = _mm_set1_ps(fractionScale);
+	const auto gainV = _mm_set1_ps(gain);
+
+	//offset of each of the 4 lanes from currentPhase, and how far the whole group moves per iteration
+	const auto laneDeltas = _mm_setr_epi32(0, (int32)phaseDelta, (int32)(phaseDelta * 2), (int32)(phaseDelta * 3));
+	const auto groupDelta = phaseDelta * 4;
+
+	alignas(16) int32 indices[4];
+	auto sample = 0;
+
+	for (; sample + 4 <= numSamples; sample += 4)
+	{
+		auto phase = _mm_add_epi32(_mm_set1_epi32((int32)currentPhase), laneDeltas);
+		auto index0 = _mm_srl_epi32(phase, shiftV);
+		auto frac = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(phase, fractionMaskV)), fractionScaleV);
+
+		//SSE2 has no gather, so the indices go through memory once and the loads are done in scalar
+		_mm_store_si128((__m128i*)indices, index0);
+		auto currentSamples = TableInterpolation::interpolateSSE2(table, indices, frac, TableInterpolation::Tag<mode>());
+
+		auto* out = dest + sample;
+		_mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(currentSamples, gainV)));
+
+		currentPhase += groupDelta;
+	}
+
+	return sample;
+}
+#endif
+
+template <TableInterpolation::Mode mode>
+int WavetableOscillator::renderVectorised(float* dest, int numSamples, float gain) noexcept
+{
+	switch (KernelDispatch::getActiveLevel())
+	{
+	   #if AUDIOAPP_HAS_AVX2
+		case KernelDispatch::Level::avx512:
+		case KernelDispatch::Level::avx2:
+			return renderWavetableAVX2<mode>(dest, numSamples, gain, wavetable, currentPhase, phaseDelta, indexShift, fractionMask, fractionScale);
+	   #endif
+	   #if AUDIOAPP_HAS_SSE2
+		case KernelDispatch::Level::sse2:
+			return renderWavetableSSE2<mode>(dest, numSamples, gain, wavetable, currentPhase, phaseDelta, indexShift, fractionMask, fractionScale);
+	   #endif
+		default:
+			return 0;
+	}
+}
+
+void WavetableOscillator::renderBlock(float* dest, int numSamples, float gain) noexcept
+{
+	auto sample = 0;
+
+	switch (interpolation)
+	{
+		case TableInterpolation::Mode::truncate:	sample = renderVectorised<TableInterpolation::Mode::truncate>(dest, numSamples, gain); break;
+		case TableInterpolation::Mode::hermite:		sample = renderVectorised<TableInterpolation::Mode::hermite>(dest, numSamples, gain); break;
+		case TableInterpolation::Mode::lagrange:	sample = renderVectorised<TableInterpolation::Mode::lagrange>(dest, numSamples, gain); break;
+		default:									sample = renderVectorised<TableInterpolation::Mode::linear>(dest, numSamples, gain); break;
+	}
+
+	//whatever doesn't fill a whole vector (or everything, with the scalar kernels)
+	for (; sample < numSamples; ++sample)
+		dest[sample] += getNextSample() * gain;
+}
+
+
+/*
+  ==============================================================================
+
+	SineOsc
+
+  ==============================================================================
+*/
+
+//calculate the angle delta via 2pi * (frequency / samplerate)
+void SineOscillator::setFrequency(float frequency, float sampleRate)
+{
+	auto cyclesPerSample = frequency / sampleRate;
+	angleDelta = cyclesPerSample * MathConstants<float>::twoPi;
+
+	//the rotations for 1 to 8 samples, in double so the only rounding is the final one to float
+	for (auto k = 0; k <= numPhasors; ++k)
+	{
+		auto angle = (double)angleDelta * k;
+		stepCos[k] = (float)std::cos(angle);
+		stepSin[k] = (float)std::sin(angle);
+	}
+
+	spreadPhasors();
+}
+
+void SineOscillator::reset() noexcept
+{
+	currentAngle = 0.0f;
+	phasorCos[0] = 1.0f;
+	phasorSin[0] = 0.0f;
+	spreadPhasors();
+}
+
+void SineOscillator::setMode(Mode newMode) noexcept
+{
+	//the phasors only follow currentAngle while the quadrature kernel runs, so they pick it up again here
+	if (newMode == Mode::quadrature && mode != Mode::quadrature)
+	{
+		phasorCos[0] = std::cos(currentAngle);
+		phasorSin[0] = std::sin(currentAngle);
+		spreadPhasors();
+	}
+
+	mode = newMode;
+}
+
+void SineOscillator::spreadPhasors() noexcept
+{
+	for (auto k = 1; k < numPhasors; ++k)
+	{
+		phasorCos[k] = phasorCos[0] * stepCos[k] - phasorSin[0] * stepSin[k];
+		phasorSin[k] = phasorSin[0] * stepCos[k] + phasorCos[0] * stepSin[k];
+	}
+}
+
+void SineOscillator::renormalisePhasors() noexcept
+{
+	//One Newton step towards 1 / sqrt(c^2 + s^2). The length is never more than a few float ulps off 1 by the time
+	//this runs, where the first-order step is already exact to float precision.
+	for (auto k = 0; k < numPhasors; ++k)
+	{
+		auto correction = 1.5f - 0.5f * (phasorCos[k] * phasorCos[k] + phasorSin[k] * phasorSin[k]);
+		phasorCos[k] *= correction;
+		phasorSin[k] *= correction;
+	}
+}
+
+//wraps an angle that may have advanced several periods back into [0, 2pi)
+static forcedinline float wrapAngle(float angle) noexcept
+{
+	return angle - MathConstants<float>::twoPi * std::floor(angle / MathConstants<float>::twoPi);
+}
+
+void SineOscillator::renderBlock(float* dest, int numSamples, float gain) noexcept
+{
+	switch (mode)
+	{
+		case Mode::quadrature:	renderBlock<Mode::quadrature>(dest, numSamples, gain); break;
+		case Mode::polynomial:	renderBlock<Mode::polynomial>(dest, numSamples, gain); break;
+		case Mode::libm:
+		default:				renderBlock<Mode::libm>(dest, numSamples, gain); break;
+	}
+}
+
+void SineOscillator::renderKernel(float* dest, int numSamples, float gain, Kernel<Mode::libm>) noexcept
+{
+	for (auto sample = 0; sample < numSamples; ++sample)
+		dest[sample] += getNextSample() * gain;
+}
+
+void SineOscillator::renderKernel(float* dest, int numSamples, float gain, Kernel<Mode::quadrature>) noexcept
+{
+	//the renormalisation runs between chunks, so long blocks can't drift further than short ones
+	for (auto start = 0; start < numSamples; start += renormaliseSamples)
+	{
+		renderQuadratureChunk(dest + start, jmin(renormaliseSamples, numSamples - start), gain);
+		renormalisePhasors();
+	}
+
+	//keep the angle going as well, for getNextSample() and the other modes
+	currentAngle = wrapAngle(currentAngle + angleDelta * (float)numSamples);
+}
+
+//The sines of the eight phasors are the next eight samples, then every phasor turns eight samples further.
+//Each returns how many samples it rendered; the caller does the tail. The phasors are only loaded and stored once
+//per call, so they are read unaligned: the oscillators come from plain new, which only guarantees 16 bytes in C++14.
+#if AUDIOAPP_HAS_AVX2
+AUDIOAPP_TARGET_AVX2 static int renderQuadratureAVX2(float* dest, int numSamples, float gain, float* phasorCos, float* phasorSin,
+													 float stepCos, float stepSin) noexcept
+{
+	const auto gainV = _mm256_set1_ps(gain);
+	const auto turnCos = _mm256_set1_ps(stepCos);
+	const auto turnSin = _mm256_set1_ps(stepSin);
+	auto c = _mm256_loadu_ps(phasorCos);
+	auto s = _mm256_loadu_ps(phasorSin);
+	auto sample = 0;
+
+	for (; sample + 8 <= numSamples; sample += 8)
+	{
+		auto* out = dest + sample;
+		_mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(out), _mm256_mul_ps(s, gainV)));
+
+		auto nextCos = _mm256_sub_ps(_mm256_mul_ps(c, turnCos), _mm256_mul_ps(s, turnSin));
+		s = _mm256_add_ps(_mm256_mul_ps(s, turnCos), _mm256_mul_ps(c, turnSin));
+		c = nextCos;
+	}
+
+	_mm256_storeu_ps(phasorCos, c);
+	_mm256_storeu_ps(phasorSin, s);
+	_mm256_zeroupper();
+	return sample;
+}
+#endif
+
+#if AUDIOAPP_HAS_SSE2
+static int renderQuadratureSSE2(float* dest, int numSamples, float gain, float* phasorCos, float* phasorSin,
+								float stepCos, float stepSin) noexcept
+{
+	//the eight phasors are two vectors of four here
+	const auto gainV = _mm_set1_ps(gain);
+	const auto turnCos = _mm_set1_ps(stepCos);
+	const auto turnSin = _mm_set1_ps(stepSin);
+	auto c0 = _mm_loadu_ps(phasorCos), c1 = _mm_loadu_ps(phasorCos + 4);
+	auto s0 = _mm_loadu_ps(phasorSin), s1 = _mm_loadu_ps(phasorSin + 4);
+	auto sample = 0;
+
+	for (; sample + 8 <= numSamples; sample += 8)
+	{
+		auto* out = dest + sample;
+		_mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(s0, gainV)));
+		_mm_storeu_ps(out + 4, _mm_add_ps(_mm_loadu_ps(out + 4), _mm_mul_ps(s1, gainV)));
+
+		auto nextCos0 = _mm_sub_ps(_mm_mul_ps(c0, turnCos), _mm_mul_ps(s0, turnSin));
+		auto nextCos1 = _mm_sub_ps(_mm_mul_ps(c1, turnCos), _mm_mul_ps(s1, turnSin));
+		s0 = _mm_add_ps(_mm_mul_ps(s0, turnCos), _mm_mul_ps(c0, turnSin));
+		s1 = _mm_add_ps(_mm_mul_ps(s1, turnCos), _mm_mul_ps(c1, turnSin));
+		c0 = nextCos0;
+		c1 = nextCos1;
+	}
+
+	_mm_storeu_ps(phasorCos, c0);
+	_mm_storeu_ps(phasorCos + 4, c1);
+	_mm_storeu_ps(phasorSin, s0);
+	_mm_storeu_ps(phasorSin + 4, s1);
+	return sample;
+}
+#endif
+
+void SineOscillator::renderQuadratureChunk(float* dest, int numSamples, float gain) noexcept
+{
+	auto sample = 0;
+
+	switch (KernelDispatch::getActiveLevel())
+	{
+	   #if AUDIOAPP_HAS_AVX2
+		case KernelDispatch::Level::avx512:
+		case KernelDispatch::Level::avx2:
+			sample = renderQuadratureAVX2(dest, numSamples, gain, phasorCos, phasorSin, stepCos[numPhasors], stepSin[numPhasors]);
+			break;
+	   #endif
+	   #if AUDIOAPP_HAS_SSE2
+		case KernelDispatch::Level::sse2:
+			sample = renderQuadratureSSE2(dest, numSamples, gain, phasorCos, phasorSin, stepCos[numPhasors], stepSin[numPhasors]);
+			break;
+	   #endif
+		default:
+			for (; sample + numPhasors <= numSamples; sample += numPhasors)
+			{
+				for (auto k = 0; k < numPhasors; ++k)
+				{
+					dest[sample + k] += phasorSin[k] * gain;
+
+					auto nextCos = phasorCos[k] * stepCos[numPhasors] - phasorSin[k] * stepSin[numPhasors];
+					phasorSin[k] = phasorSin[k] * stepCos[numPhasors] + phasorCos[k] * stepSin[numPhasors];
+					phasorCos[k] = nextCos;
+				}
+			}
+			break;
+	}
+
+	//A tail shorter than eight samples uses the first few phasors, then all of them turn by just that many samples,
+	//so the next block carries on exactly where this one stopped.
+	auto remaining = numSamples - sample;
+
+	if (remaining > 0)
+	{
+		for (auto k = 0; k < remaining; ++k)
+			dest[sample + k] += phasorSin[k] * gain;
+
+		for (auto k = 0; k < numPhasors; ++k)
+		{
+			auto nextCos = phasorCos[k] * stepCos[remaining] - phasorSin[k] * stepSin[remaining];
+			phasorSin[k] = phasorSin[k] * stepCos[remaining] + phasorCos[k] * stepSin[remaining];
+			phasorCos[k] = nextCos;
+		}
+	}
+}
+
+//==============================================================================
+//Minimax coefficients of sin(2 pi x) ~ x * (c1 + c3 x^2 + c5 x^4 + c7 x^6 + c9 x^8) for x in [-1/4, 1/4],
+//found with the Remez exchange algorithm. The largest error of the polynomial itself is 3.34e-9.
+static const float sinC1 = 6.2831851600894835f;
+static const float sinC3 = -41.34165503141761f;
+static const float sinC5 = 81.60100407334106f;
+static const float sinC7 = -76.54978229534504f;
+static const float sinC9 = 39.53670607844828f;
+
+//sin(2 pi t) for t in [-1/2, 1/2]: the sine is odd and symmetric about a quarter period,
+//so |t| is folded into [0, 1/4] as min(|t|, 1/2 - |t|) and the sign put back afterwards
+static forcedinline float sinOfCycles(float t) noexcept
+{
+	auto x = std::copysign(jmin(std::abs(t), 0.5f - std::abs(t)), t);
+	auto x2 = x * x;
+	return x * (sinC1 + x2 * (sinC3 + x2 * (sinC5 + x2 * (sinC7 + x2 * sinC9))));
+}
+
+#if AUDIOAPP_HAS_AVX2
+AUDIOAPP_TARGET_AVX2 static forcedinline __m256 sinOfCycles(__m256 t) noexcept
+{
+	const auto signMask = _mm256_set1_ps(-0.0f);
+	auto sign = _mm256_and_ps(t, signMask);
+	auto magnitude = _mm256_andnot_ps(signMask, t);
+	auto x = _mm256_or_ps(_mm256_min_ps(magnitude, _mm256_sub_ps(_mm256_set1_ps(0.5f), magnitude)), sign);
+	auto x2 = _mm256_mul_ps(x, x);
+
+	auto p = _mm256_add_ps(_mm256_set1_ps(sinC7), _mm256_mul_ps(x2, _mm256_set1_ps(sinC9)));
+	p = _mm256_add_ps(_mm256_set1_ps(sinC5), _mm256_mul_ps(x2, p));
+	p = _mm256_add_ps(_mm256_set1_ps(sinC3), _mm256_mul_ps(x2, p));
+	p = _mm256_add_ps(_mm256_set1_ps(sinC1), _mm256_mul_ps(x2, p));
+	return _mm256_mul_ps(x, p);
+}
+#endif
+
+#if AUDIOAPP_HAS_SSE2
+static forcedinline __m128 sinOfCycles(__m128 t) noexcept
+{
+	const auto signMask = _mm_set1_ps(-0.0f);
+	auto sign = _mm_and_ps(t, signMask);
+	auto magnitude = _mm_andnot_ps(signMask, t);
+	auto x = _mm_or_ps(_mm_min_ps(magnitude, _mm_sub_ps(_mm_set1_ps(0.5f), magnitude)), sign);
+	auto x2 = _mm_mul_ps(x, x);
+
+	auto p = _mm_add_ps(_mm_set1_ps(sinC7), _mm_mul_ps(x2, _mm_set1_ps(sinC9)));
+	p = _mm_add_ps(_mm_set1_ps(sinC5), _mm_mul_ps(x2, p));
+	p = _mm_add_ps(_mm_set1_ps(sinC3), _mm_mul_ps(x2, p));
+	p = _mm_add_ps(_mm_set1_ps(sinC1), _mm_mul_ps(x2, p));
+	return _mm_mul_ps(x, p);
+}
+#endif
+
+//angle to cycles, then the nearest whole cycle taken off to land in [-1/2, 1/2], then the polynomial;
+//each returns how many samples it rendered and leaves the tail to the caller
+#if AUDIOAPP_HAS_AVX2
+AUDIOAPP_TARGET_AVX2 static int renderPolynomialAVX2(float* dest, int numSamples, float gain, float& currentAngle, float angleDelta) noexcept
+{
+	const auto gainV = _mm256_set1_ps(gain);
+	const auto cyclesPerRadianV = _mm256_set1_ps(1.0f / MathConstants<float>::twoPi);
+	const auto laneDeltas = _mm256_mul_ps(_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f), _mm256_set1_ps(angleDelta));
+	const auto groupDelta = angleDelta * 8.0f;
+	auto sample = 0;
+
+	for (; sample + 8 <= numSamples; sample += 8)
+	{
+		auto t = _mm256_mul_ps(_mm256_add_ps(_mm256_set1_ps(currentAngle), laneDeltas), cyclesPerRadianV);
+		t = _mm256_sub_ps(t, _mm256_round_ps(t, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+
+		auto* out = dest + sample;
+		_mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(out), _mm256_mul_ps(sinOfCycles(t), gainV)));
+
+		currentAngle = wrapAngle(currentAngle + groupDelta);
+	}
+
+	_mm256_zeroupper();
+	return sample;
+}
+#endif
+
+#if AUDIOAPP_HAS_SSE2
+static int renderPolynomialSSE2(float* dest, int numSamples, float gain, float& currentAngle, float angleDelta) noexcept
+{
+	const auto gainV = _mm_set1_ps(gain);
+	const auto cyclesPerRadianV = _mm_set1_ps(1.0f / MathConstants<float>::twoPi);
+	const auto laneDeltas = _mm_mul_ps(_mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), _mm_set1_ps(angleDelta));
+	const auto groupDelta = angleDelta * 4.0f;
+	auto sample = 0;
+
+	for (; sample + 4 <= numSamples; sample += 4)
+	{
+		//SSE2 has no round instruction, but converting to int rounds to nearest in the default rounding mode
+		auto t = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(currentAngle), laneDeltas), cyclesPerRadianV);
+		t = _mm_sub_ps(t, _mm_cvtepi32_ps(_mm_cvtps_epi32(t)));
+
+		auto* out = dest + sample;
+		_mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(sinOfCycles(t), gainV)));
+
+		currentAngle = wrapAngle(currentAngle + groupDelta);
+	}
+
+	return sample;
+}
+#endif
+
+void SineOscillator::renderKernel(float* dest, int numSamples, float gain, Kernel<Mode::polynomial>) noexcept
+{
+	const auto cyclesPerRadian = 1.0f / MathConstants<float>::twoPi;
+	auto sample = 0;
+
+	switch (KernelDispatch::getActiveLevel())
+	{
+	   #if AUDIOAPP_HAS_AVX2
+		case KernelDispatch::Level::avx512:
+		case KernelDispatch::Level::avx2:	sample = renderPolynomialAVX2(dest, numSamples, gain, currentAngle, angleDelta); break;
+	   #endif
+	   #if AUDIOAPP_HAS_SSE2
+		case KernelDispatch::Level::sse2:	sample = renderPolynomialSSE2(dest, numSamples, gain, currentAngle, angleDelta); break;
+	   #endif
+		default:							break;
+	}
+
+	//whatever doesn't fill a whole vector (or everything, with the scalar kernels)
+	for (; sample < numSamples; ++sample)
+	{
+		auto t = currentAngle * cyclesPerRadian;
+		dest[sample] += sinOfCycles(t - std::round(t)) * gain;
+		updateAngle();
+	}
+}
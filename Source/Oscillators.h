@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    Oscillators.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "WavetableSet.h"
+#include "FixedPointPhase.h"
+
+
+//https://docs.juce.com/master/tutorial_wavetable_synth.html
+
+//uses std::sin calcullations for 
+//
+//getNextSample() always calls std::sin and stays the reference. renderBlock() uses the kernel set with setMode():
+//	libm		std::sin per sample, the same as getNextSample()
+//	quadrature	a rotating phasor: eight (cos, sin) pairs a sample apart, each turned by eight samples' worth of angle
+//				per step with one complex multiply. The rounding in that multiply slowly changes their length, so they
+//				are pulled back onto the unit circle every renormaliseSamples samples.
+//	polynomial	an odd degree-9 minimax polynomial over a quarter period, folded out to the whole cycle.
+//				Its approximation error is below 3.4e-9, far under float rounding; evaluated in float the output stays
+//				within 2.1e-7 of the true sine.
+//Both fast kernels compute 8 (AVX2) or 4 (SSE2) samples at a time.
+class SineOscillator
+{
+	public:
+		enum class Mode
+		{
+			libm,
+			quadrature,
+			polynomial
+		};
+
+		SineOscillator() {}
+
+		//calculate the angle delta via 2pi * (frequency / samplerate)
+		void setFrequency(float frequency, float sampleRate);
+
+		//start the next sample from angle 0 again
+		void reset() noexcept;
+
+		//switching keeps the phase, so a running oscillator doesn't click
+		void setMode(Mode newMode) noexcept;
+		Mode getMode() const noexcept { return mode; }
+
+		//called by getNextAudioBlock() on every sample in the buffer to get sample value from oscillator.
+		//Here we calculate sample by using std::sin() by passing in currentAngle and then updating currentAngle
+		forcedinline float getNextSample() noexcept;
+
+		//adds numSamples of the oscillator, scaled by gain, on top of whatever is already in dest, using the current mode
+		void renderBlock(float* dest, int numSamples, float gain) noexcept;
+
+		//The same with the kernel picked at compile time, for render loops that choose it once for all their voices.
+		//The oscillator has to be in that mode already.
+		template <Mode kernel>
+		void renderBlock(float* dest, int numSamples, float gain) noexcept	{ renderKernel(dest, numSamples, gain, Kernel<kernel>()); }
+
+		//update the angle by incrementing with angle delta; wrap the value when exceeding 2PI
+		forcedinline void updateAngle() noexcept;
+
+	private:
+		static constexpr int numPhasors = 8;
+		static constexpr int renormaliseSamples = 512;
+
+		template <Mode kernel>
+		using Kernel = std::integral_constant<Mode, kernel>;
+
+		void renderKernel(float* dest, int numSamples, float gain, Kernel<Mode::libm>) noexcept;
+		void renderKernel(float* dest, int numSamples, float gain, Kernel<Mode::quadrature>) noexcept;
+		void renderKernel(float* dest, int numSamples, float gain, Kernel<Mode::polynomial>) noexcept;
+		void renderQuadratureChunk(float* dest, int numSamples, float gain) noexcept;
+
+		//sets phasors 1..7 from phasor 0 and the current angle delta
+		void spreadPhasors() noexcept;
+		void renormalisePhasors() noexcept;
+
+		Mode mode = Mode::libm;
+		float currentAngle = 0.0f, angleDelta = 0.0f;
+
+		//phasor k is (cos, sin) of the angle k samples ahead; step k turns a phasor k samples further
+		float phasorCos[numPhasors] = { 1.0f }, phasorSin[numPhasors] = {};
+		float stepCos[numPhasors + 1] = { 1.0f }, stepSin[numPhasors + 1] = {};
+};
+
+
+
+class WavetableOscillator
+{
+	public:
+		WavetableOscillator(const WavetableSet& wavetablesToUse)
+			: wavetables(wavetablesToUse),
+			wavetable(wavetables.getTable(0)),
+			subTableSize (wavetables.getTableSize()),
+			indexShift (FixedPointPhase::getIndexShift(subTableSize)),
+			fractionMask (FixedPointPhase::getFractionMask(indexShift)),
+			fractionScale (FixedPointPhase::getFractionScale(indexShift))
+		{
+		}
+		
+		//calculate the phase increment via 2^32 * (frequency / samplerate),
+		//and switch to the mipmap level whose harmonics all stay below Nyquist at that frequency
+		void setFrequency(float frequency, float sampleRate);
+		forcedinline float getNextSample() noexcept;
+
+		//how the samples between table entries are worked out; linear unless set otherwise
+		void setInterpolation(TableInterpolation::Mode newMode) noexcept	{ interpolation = newMode; }
+		TableInterpolation::Mode getInterpolation() const noexcept			{ return interpolation; }
+
+		//adds numSamples of the oscillator, scaled by gain, on top of whatever is already in dest.
+		//Phases, interpolation fractions and table gathers are computed 8 (AVX2) or 4 (SSE2) samples at a time,
+		//the remaining tail goes through getNextSample() so the phase carries over exactly between blocks.
+		void renderBlock(float* dest, int numSamples, float gain) noexcept;
+
+	private:
+		template <TableInterpolation::Mode mode>
+		int renderVectorised(float* dest, int numSamples, float gain) noexcept;
+
+		const WavetableSet& wavetables;
+		const float* wavetable;
+		uint32 currentPhase = 0, phaseDelta = 0;	//FixedPointPhase units: the top bits index the table
+		TableInterpolation::Mode interpolation = TableInterpolation::Mode::linear;
+		const int subTableSize, indexShift;
+		const uint32 fractionMask;
+		const float fractionScale;
+};
+
+
+
+//==============================================================================
+//the per-sample calls are defined here so they inline into the render loops of every file that uses them
+
+forcedinline float WavetableOscillator::getNextSample() noexcept
+{
+	//First, find the index of the wavetable sample just below the value that we are trying to retrieve.
+	//The top bits of the phase are that index; the guard samples around the table mean its neighbours never need wrapping.
+	auto index0 = currentPhase >> indexShift;
+
+	//Next, the interpolation value is the rest of the phase, scaled to a fraction between 0 .. 1.
+	auto frac = (float)(currentPhase & fractionMask) * fractionScale;  // [7]
+
+	//The interpolated sample value is then worked out from the samples around that index in the current mipmap level,
+	//two of them for linear interpolation and up to six for the higher orders.
+	auto currentSample = TableInterpolation::interpolate(interpolation, wavetable + index0, frac); // [8] [9]
+
+	//Finally, increment the phase; the unsigned overflow wraps it to the start of the table.
+	currentPhase += phaseDelta;           // [10]
+
+	return currentSample;
+}
+
+//called by getNextAudioBlock() on every sample in the buffer to get sample value from oscillator.
+//Here we calculate sample by using std::sin() by passing in currentAngle and then updating currentAngle
+forcedinline float SineOscillator::getNextSample() noexcept {
+	auto currentSample = std::sin(currentAngle);
+	updateAngle();
+	return currentSample;
+}
+
+//update the angle by incrementing with angle delta; wrap the value when exceeding 2PI
+forcedinline void SineOscillator::updateAngle() noexcept {
+	currentAngle += angleDelta;
+
+	if (currentAngle >= MathConstants<float>::twoPi)
+		currentAngle -= MathConstants<float>::twoPi;
+}
@@ -0,0 +1,33 @@
+/*
+  ==============================================================================
+
+    ParameterQueue.cpp
+
+  ==============================================================================
+*/
+
+#include "ParameterQueue.h"
+
+ParameterQueue::ParameterQueue(int capacity)
+	: events(capacity), reservedForNotes(capacity / 4)
+{
+}
+
+bool ParameterQueue::isNoteEvent(const ParameterEvent& event) noexcept
+{
+	return event.type == ParameterEvent::Type::noteOn || event.type == ParameterEvent::Type::noteOff;
+}
+
+bool ParameterQueue::push(const ParameterEvent& event) noexcept
+{
+	if (! isNoteEvent(event) && events.getFreeSpace() <= reservedForNotes)
+		return false;
+
+	//full, which only happens when the audio thread isn't running to drain it
+	return events.push(event);
+}
+
+bool ParameterQueue::pop(ParameterEvent& event) noexcept
+{
+	return events.pop(event);
+}
@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    ParameterQueue.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "SpscQueue.h"
+
+
+//a single parameter change sent from the message thread to the audio thread
+struct ParameterEvent
+{
+	enum class Type
+	{
+		frequency,	//value in Hz, applied to every voice
+		gain,		//linear gain, applied to every voice
+		noteOn,		//value in Hz, plus noteNumber and velocity
+		noteOff,	//noteNumber only
+		stealingPolicy,	//value is a VoicePool::StealingPolicy
+		sineMode,		//value is a SineOscillator::Mode
+		blepShape,		//value is a PolyBlepOscillator::Shape
+		pulseWidth,		//share of the cycle in (0, 1), for the PolyBLEP pulse and triangle
+		oversampling,	//value is the oversampling factor, 1, 2, 4 or 8
+		bankPosition,	//0 to 1 through the frames of the wavetable bank
+		interpolation,	//value is a TableInterpolation::Mode
+		subBlockSize	//value is the samples per sub-block, 16, 32 or 64, or 0 for the device's blocks
+	};
+
+	Type type;
+	float value;
+	int noteNumber = 0;
+	float velocity = 0.0f;
+};
+
+//Single-producer/single-consumer lock-free queue of parameter events.
+//The message thread pushes, the audio thread drains it at the start of each block, and neither side ever blocks.
+//All storage is allocated in the constructor.
+//
+//A quarter of the queue is kept for note-ons and note-offs: other events are dropped once only that much is left,
+//so a slider dragged while the audio thread is stalled can't crowd out the note-off that ends a note.
+class ParameterQueue
+{
+	public:
+		explicit ParameterQueue(int capacity = 256);
+
+		//producer side only; returns false and drops the event if the consumer has fallen that far behind
+		bool push(const ParameterEvent& event) noexcept;
+
+		static bool isNoteEvent(const ParameterEvent& event) noexcept;
+
+		//consumer side only; returns false once the queue is empty
+		bool pop(ParameterEvent& event) noexcept;
+
+	private:
+		SpscQueue<ParameterEvent> events;
+		const int reservedForNotes;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterQueue)
+};
@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    PluckedStringVoice.cpp
+
+  ==============================================================================
+*/
+
+#include "PluckedStringVoice.h"
+
+void DelayLineArena::allocate(int numLinesNeeded, int minLineLength)
+{
+	auto newLineLength = nextPowerOfTwo(jmax(2, minLineLength));
+
+	if (numLinesNeeded <= numLines && newLineLength <= lineLength)
+		return;
+
+	numLines = jmax(numLines, numLinesNeeded);
+	lineLength = jmax(lineLength, newLineLength);
+	storage.allocate((size_t)numLines * (size_t)lineLength, true);
+}
+
+//==============================================================================
+void PluckedStringVoice::setDelayLine(float* newLine, int length) noexcept
+{
+	jassert(isPowerOfTwo(length));
+
+	line = newLine;
+	mask = (uint32)length - 1;
+	reset();
+}
+
+void PluckedStringVoice::setFrequency(float newFrequency, float newSampleRate) noexcept
+{
+	frequency = newFrequency;
+	sampleRate = newSampleRate;
+
+	if (line == nullptr || sampleRate <= 0.0f)
+		return;
+
+	//The loop has to add up to one period: the whole samples of the line, half a sample for the average
+	//and a fraction between 0.1 and 1.1 for the allpass, which keeps its phase delay close to flat.
+	//The reads go back delaySamples + 1, which has to stay inside the line.
+	auto period = jlimit(2.0f, (float)(mask - 1), sampleRate / jmax(frequency, 1.0f));
+	delaySamples = (uint32)jmax(1, (int)(period - 0.6f));
+	auto fraction = period - 0.5f - (float)delaySamples;
+
+	//the coefficient that gives exactly that phase delay at the fundamental; (1 - d) / (1 + d) is only
+	//right at low frequencies and leaves the higher notes audibly flat
+	auto halfOmega = MathConstants<float>::pi / period;
+	allpassCoefficient = std::sin((1.0f - fraction) * halfOmega) / std::sin((1.0f + fraction) * halfOmega);
+
+	updateLoopGain();
+}
+
+void PluckedStringVoice::updateLoopGain() noexcept
+{
+	//the level has to fall by 60 dB over ringSeconds * frequency trips round the loop
+	auto tripsToSilence = jmax(1.0f, ringSeconds * frequency);
+	loopGain = std::pow(0.001f, 1.0f / tripsToSilence);
+}
+
+void PluckedStringVoice::pluck(float amplitude, Random& random) noexcept
+{
+	if (line == nullptr)
+		return;
+
+	reset();
+
+	//one period of noise behind the write position, which is as far back as the loop reads
+	for (uint32 i = 1; i <= delaySamples + 1; ++i)
+		line[(writeIndex - i) & mask] = amplitude * (2.0f * random.nextFloat() - 1.0f);
+
+	ringSeconds = decaySeconds;
+	updateLoopGain();
+	peakSinceTaken = amplitude;
+}
+
+void PluckedStringVoice::release() noexcept
+{
+	ringSeconds = releaseSeconds;
+	updateLoopGain();
+}
+
+void PluckedStringVoice::reset() noexcept
+{
+	if (line != nullptr)
+		zeromem(line, (mask + 1) * sizeof(float));
+
+	allpassInput = allpassOutput = 0.0f;
+	peakSinceTaken = 0.0f;
+}
+
+void PluckedStringVoice::renderBlock(float* dest, int numSamples, float gain) noexcept
+{
+	if (line == nullptr)
+		return;
+
+	//The loop state is copied into locals for the block, so it stays in registers instead of going
+	//back through the object on every sample.
+	auto* delayLine = line;
+	auto lineMask = mask;
+	auto index = writeIndex;
+	auto readOffset = delaySamples;
+	auto averageGain = loopGain * 0.5f;
+	auto coefficient = allpassCoefficient;
+	auto x1 = allpassInput, y1 = allpassOutput;
+	auto peak = peakSinceTaken;
+
+	for (auto sample = 0; sample < numSamples; ++sample)
+	{
+		//average of the two samples one period back, damped by the loop gain
+		auto damped = averageGain * (delayLine[(index - readOffset) & lineMask] + delayLine[(index - readOffset - 1) & lineMask]);
+
+		//first-order allpass for the fractional part of the period: y = a x + x1 - a y1
+		auto output = coefficient * (damped - y1) + x1;
+		x1 = damped;
+		y1 = output;
+
+		delayLine[index] = output;
+		index = (index + 1) & lineMask;
+
+		dest[sample] += output * gain;
+		peak = jmax(peak, std::abs(output));
+	}
+
+	writeIndex = index;
+	allpassInput = x1;
+	allpassOutput = y1;
+	peakSinceTaken = peak;
+}
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    PluckedStringVoice.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+
+//The delay lines of a whole bank of strings in one contiguous block, so a few hundred of them stay together
+//in the cache instead of being scattered over the heap. Every line has the same power-of-two length.
+class DelayLineArena
+{
+	public:
+		DelayLineArena() {}
+
+		//Makes room for numLines lines of at least minLineLength samples each, rounded up to a power of two.
+		//Keeps the existing block when it's already big enough; otherwise allocates, so never call it from the audio thread.
+		void allocate(int numLines, int minLineLength);
+
+		float* getLine(int index) const noexcept	{ return storage + (size_t)index * (size_t)lineLength; }
+		int getLineLength() const noexcept			{ return lineLength; }
+
+	private:
+		HeapBlock<float> storage;
+		int numLines = 0, lineLength = 0;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DelayLineArena)
+};
+
+//==============================================================================
+//Karplus-Strong plucked string: a burst of noise circulates in a delay line one period long, and every trip round
+//the loop it goes through a two-point average, which damps the high harmonics first like a real string does.
+//
+//The line is a power-of-two ring buffer, so wrapping an index is a mask instead of a branch. The average adds half
+//a sample to the loop, and a first-order allpass adds the rest of the fractional period, which keeps the pitch
+//in tune instead of rounding it to a whole number of samples.
+class PluckedStringVoice
+{
+	public:
+		PluckedStringVoice() {}
+
+		//the line comes from a DelayLineArena; length has to be a power of two
+		void setDelayLine(float* newLine, int length) noexcept;
+
+		//works out the delay, the allpass coefficient and the loop gain for the current decay time
+		void setFrequency(float frequency, float sampleRate) noexcept;
+
+		//fills the loop with noise of the given amplitude and lets the string ring for decaySeconds
+		void pluck(float amplitude, Random& random) noexcept;
+
+		//damps the string so it dies away within releaseSeconds, like lifting the finger off it
+		void release() noexcept;
+
+		//silences the string straight away
+		void reset() noexcept;
+
+		//adds numSamples of the string, scaled by gain, on top of whatever is already in dest
+		void renderBlock(float* dest, int numSamples, float gain) noexcept;
+
+		//the loudest sample since the last call, to tell when the string has died away however short the blocks are
+		float takePeak() noexcept { auto peak = peakSinceTaken; peakSinceTaken = 0.0f; return peak; }
+
+		//how long the loop gain takes to bring a plucked string down by 60 dB, and how long after release();
+		//the averaging takes the higher harmonics (and so the higher notes) down faster than that
+		static constexpr float decaySeconds = 4.0f;
+		static constexpr float releaseSeconds = 0.15f;
+
+		//the longest period the arena lines have to hold; lower notes are played at this pitch
+		static constexpr float lowestFrequency = 27.5f;
+
+	private:
+		void updateLoopGain() noexcept;
+
+		float* line = nullptr;
+		uint32 mask = 0, writeIndex = 0, delaySamples = 1;
+
+		float frequency = 0.0f, sampleRate = 0.0f, ringSeconds = decaySeconds;
+		float loopGain = 0.0f, allpassCoefficient = 0.0f;
+		float allpassInput = 0.0f, allpassOutput = 0.0f;
+		float peakSinceTaken = 0.0f;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PluckedStringVoice)
+};
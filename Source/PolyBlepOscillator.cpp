@@ -0,0 +1,344 @@
+/*
+  ==============================================================================
+
+    PolyBlepOscillator.cpp
+
+  ==============================================================================
+*/
+
+#include "PolyBlepOscillator.h"
+#include "SimdConfig.h"
+#include "KernelDispatch.h"
+
+//The residuals below are the two-sample polynomials of Valimaki and Huovilainen. With d the distance from the
+//discontinuity in cycles, wrapped into [-1/2, 1/2], and a = max(0, 1 - |d| / phaseDelta), which is 1 on the
+//discontinuity and 0 from a sample away:
+//
+//	BLEP  = -a^2 after the jump, +a^2 before it, for an upward step of 2
+//	BLAMP = a^3 / 3, for a change of slope of 2 / phaseDelta per cycle
+//
+//Written that way there is no branch on which side of the jump a sample is, only a sign taken from d,
+//so every lane of a vector runs the same instructions. a is 0 almost everywhere, where both residuals vanish.
+
+//the shortest phase increment the corrections are sized for; below it they are narrower than any sample
+static const float minPhaseDelta = 1.0e-6f;
+
+static forcedinline float wrapDistance(float distance) noexcept
+{
+	return distance - std::round(distance);
+}
+
+static forcedinline float getCloseness(float distance, float inverseDelta) noexcept
+{
+	return jmax(0.0f, 1.0f - std::abs(distance) * inverseDelta);
+}
+
+static forcedinline float blepResidual(float distance, float inverseDelta) noexcept
+{
+	auto a = getCloseness(distance, inverseDelta);
+	return -std::copysign(a * a, distance);
+}
+
+static forcedinline float blampResidual(float distance, float inverseDelta) noexcept
+{
+	auto a = getCloseness(distance, inverseDelta);
+	return a * a * a * (1.0f / 3.0f);
+}
+
+//t is the phase in [0, 1), width the share of the cycle before the second discontinuity
+template <PolyBlepOscillator::Shape shape, bool bandLimited>
+static forcedinline float getSample(float t, float width, float phaseDelta, float inverseDelta) noexcept
+{
+	using Shape = PolyBlepOscillator::Shape;
+
+	if (shape == Shape::saw)
+	{
+		//falls by 2 at the start of every cycle
+		auto naive = 2.0f * t - 1.0f;
+		return bandLimited ? naive - blepResidual(wrapDistance(t), inverseDelta) : naive;
+	}
+
+	if (shape == Shape::pulse)
+	{
+		//rises by 2 at the start of the cycle and falls by 2 at the width; the DC of an uneven pulse is taken off
+		auto naive = (t < width ? 1.0f : -1.0f) - (2.0f * width - 1.0f);
+		return bandLimited ? naive + blepResidual(wrapDistance(t), inverseDelta) - blepResidual(wrapDistance(t - width), inverseDelta) : naive;
+	}
+
+	//rises from -1 to 1 until the width, then falls back; the slope changes by 4 / (width (1 - width)) at both corners
+	auto naive = t < width ? 2.0f * t / width - 1.0f : 1.0f - 2.0f * (t - width) / (1.0f - width);
+
+	if (! bandLimited)
+		return naive;
+
+	auto cornerScale = phaseDelta / (width * (1.0f - width));
+	return naive + cornerScale * (blampResidual(wrapDistance(t), inverseDelta) - blampResidual(wrapDistance(t - width), inverseDelta));
+}
+
+//The same maths several samples at a time: lane k is k samples ahead of the phase, with the width ramped to match.
+//Each returns how many samples it rendered and leaves the tail to the caller.
+#if AUDIOAPP_HAS_AVX2
+AUDIOAPP_TARGET_AVX2 static forcedinline __m256 wrapDistance(__m256 distance) noexcept
+{
+	return _mm256_sub_ps(distance, _mm256_round_ps(distance, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+
+AUDIOAPP_TARGET_AVX2 static forcedinline __m256 getCloseness(__m256 distance, __m256 inverseDelta) noexcept
+{
+	auto magnitude = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), distance);
+	return _mm256_max_ps(_mm256_setzero_ps(), _mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(magnitude, inverseDelta)));
+}
+
+AUDIOAPP_TARGET_AVX2 static forcedinline __m256 blepResidual(__m256 distance, __m256 inverseDelta) noexcept
+{
+	//a^2 with the sign bit set wherever the distance is positive
+	auto a = getCloseness(distance, inverseDelta);
+	return _mm256_or_ps(_mm256_mul_ps(a, a), _mm256_andnot_ps(distance, _mm256_set1_ps(-0.0f)));
+}
+
+AUDIOAPP_TARGET_AVX2 static forcedinline __m256 blampResidual(__m256 distance, __m256 inverseDelta) noexcept
+{
+	auto a = getCloseness(distance, inverseDelta);
+	return _mm256_mul_ps(_mm256_mul_ps(a, _mm256_mul_ps(a, a)), _mm256_set1_ps(1.0f / 3.0f));
+}
+
+template <PolyBlepOscillator::Shape shape, bool bandLimited>
+AUDIOAPP_TARGET_AVX2 static int renderPolyBlepAVX2(float* dest, int numSamples, float gain, float& phase, float phaseDelta,
+												   float inverseDelta, float startWidth, float widthStep) noexcept
+{
+	using Shape = PolyBlepOscillator::Shape;
+
+	const auto one = _mm256_set1_ps(1.0f);
+	const auto two = _mm256_set1_ps(2.0f);
+	const auto gainV = _mm256_set1_ps(gain);
+	const auto phaseDeltaV = _mm256_set1_ps(phaseDelta);
+	const auto inverseDeltaV = _mm256_set1_ps(inverseDelta);
+	const auto laneIndices = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+	const auto laneDeltas = _mm256_mul_ps(laneIndices, phaseDeltaV);
+	const auto laneWidthSteps = _mm256_mul_ps(laneIndices, _mm256_set1_ps(widthStep));
+	const auto groupDelta = phaseDelta * 8.0f;
+	auto sample = 0;
+
+	for (; sample + 8 <= numSamples; sample += 8)
+	{
+		auto t = _mm256_add_ps(_mm256_set1_ps(phase), laneDeltas);
+		t = _mm256_sub_ps(t, _mm256_floor_ps(t));
+		auto width = _mm256_add_ps(_mm256_set1_ps(startWidth + widthStep * (float)sample), laneWidthSteps);
+		__m256 value;
+
+		if (shape == Shape::saw)
+		{
+			value = _mm256_sub_ps(_mm256_mul_ps(two, t), one);
+
+			if (bandLimited)
+				value = _mm256_sub_ps(value, blepResidual(wrapDistance(t), inverseDeltaV));
+		}
+		else if (shape == Shape::pulse)
+		{
+			//+1 or -1 by setting the sign bit of 1 where the phase is past the width
+			auto naive = _mm256_or_ps(one, _mm256_andnot_ps(_mm256_cmp_ps(t, width, _CMP_LT_OQ), _mm256_set1_ps(-0.0f)));
+			value = _mm256_sub_ps(naive, _mm256_sub_ps(_mm256_mul_ps(two, width), one));
+
+			if (bandLimited)
+				value = _mm256_add_ps(value, _mm256_sub_ps(blepResidual(wrapDistance(t), inverseDeltaV),
+														   blepResidual(wrapDistance(_mm256_sub_ps(t, width)), inverseDeltaV)));
+		}
+		else
+		{
+			auto fallWidth = _mm256_sub_ps(one, width);
+			auto rising = _mm256_sub_ps(_mm256_div_ps(_mm256_mul_ps(two, t), width), one);
+			auto falling = _mm256_sub_ps(one, _mm256_div_ps(_mm256_mul_ps(two, _mm256_sub_ps(t, width)), fallWidth));
+			value = _mm256_blendv_ps(falling, rising, _mm256_cmp_ps(t, width, _CMP_LT_OQ));
+
+			if (bandLimited)
+			{
+				auto cornerScale = _mm256_div_ps(phaseDeltaV, _mm256_mul_ps(width, fallWidth));
+				auto residuals = _mm256_sub_ps(blampResidual(wrapDistance(t), inverseDeltaV), blampResidual(wrapDistance(_mm256_sub_ps(t, width)), inverseDeltaV));
+				value = _mm256_add_ps(value, _mm256_mul_ps(cornerScale, residuals));
+			}
+		}
+
+		auto* out = dest + sample;
+		_mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(out), _mm256_mul_ps(value, gainV)));
+
+		phase += groupDelta;
+		phase -= std::floor(phase);
+	}
+
+	_mm256_zeroupper();
+	return sample;
+}
+#endif
+
+#if AUDIOAPP_HAS_SSE2
+//SSE2 has no round instruction, but converting to int rounds to nearest in the default rounding mode
+static forcedinline __m128 wrapDistance(__m128 distance) noexcept
+{
+	return _mm_sub_ps(distance, _mm_cvtepi32_ps(_mm_cvtps_epi32(distance)));
+}
+
+static forcedinline __m128 getCloseness(__m128 distance, __m128 inverseDelta) noexcept
+{
+	auto magnitude = _mm_andnot_ps(_mm_set1_ps(-0.0f), distance);
+	return _mm_max_ps(_mm_setzero_ps(), _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(magnitude, inverseDelta)));
+}
+
+static forcedinline __m128 blepResidual(__m128 distance, __m128 inverseDelta) noexcept
+{
+	auto a = getCloseness(distance, inverseDelta);
+	return _mm_or_ps(_mm_mul_ps(a, a), _mm_andnot_ps(distance, _mm_set1_ps(-0.0f)));
+}
+
+static forcedinline __m128 blampResidual(__m128 distance, __m128 inverseDelta) noexcept
+{
+	auto a = getCloseness(distance, inverseDelta);
+	return _mm_mul_ps(_mm_mul_ps(a, _mm_mul_ps(a, a)), _mm_set1_ps(1.0f / 3.0f));
+}
+
+template <PolyBlepOscillator::Shape shape, bool bandLimited>
+static int renderPolyBlepSSE2(float* dest, int numSamples, float gain, float& phase, float phaseDelta,
+							  float inverseDelta, float startWidth, float widthStep) noexcept
+{
+	using Shape = PolyBlepOscillator::Shape;
+
+	const auto one = _mm_set1_ps(1.0f);
+	const auto two = _mm_set1_ps(2.0f);
+	const auto gainV = _mm_set1_ps(gain);
+	const auto phaseDeltaV = _mm_set1_ps(phaseDelta);
+	const auto inverseDeltaV = _mm_set1_ps(inverseDelta);
+	const auto laneIndices = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+	const auto laneDeltas = _mm_mul_ps(laneIndices, phaseDeltaV);
+	const auto laneWidthSteps = _mm_mul_ps(laneIndices, _mm_set1_ps(widthStep));
+	const auto groupDelta = phaseDelta * 4.0f;
+	auto sample = 0;
+
+	for (; sample + 4 <= numSamples; sample += 4)
+	{
+		//the phases are never negative, so truncating is the floor
+		auto t = _mm_add_ps(_mm_set1_ps(phase), laneDeltas);
+		t = _mm_sub_ps(t, _mm_cvtepi32_ps(_mm_cvttps_epi32(t)));
+		auto width = _mm_add_ps(_mm_set1_ps(startWidth + widthStep * (float)sample), laneWidthSteps);
+		__m128 value;
+
+		if (shape == Shape::saw)
+		{
+			value = _mm_sub_ps(_mm_mul_ps(two, t), one);
+
+			if (bandLimited)
+				value = _mm_sub_ps(value, blepResidual(wrapDistance(t), inverseDeltaV));
+		}
+		else if (shape == Shape::pulse)
+		{
+			auto naive = _mm_or_ps(one, _mm_andnot_ps(_mm_cmplt_ps(t, width), _mm_set1_ps(-0.0f)));
+			value = _mm_sub_ps(naive, _mm_sub_ps(_mm_mul_ps(two, width), one));
+
+			if (bandLimited)
+				value = _mm_add_ps(value, _mm_sub_ps(blepResidual(wrapDistance(t), inverseDeltaV),
+													 blepResidual(wrapDistance(_mm_sub_ps(t, width)), inverseDeltaV)));
+		}
+		else
+		{
+			//no blend in SSE2, so the two slopes are merged through the comparison mask
+			auto fallWidth = _mm_sub_ps(one, width);
+			auto rising = _mm_sub_ps(_mm_div_ps(_mm_mul_ps(two, t), width), one);
+			auto falling = _mm_sub_ps(one, _mm_div_ps(_mm_mul_ps(two, _mm_sub_ps(t, width)), fallWidth));
+			auto isRising = _mm_cmplt_ps(t, width);
+			value = _mm_or_ps(_mm_and_ps(isRising, rising), _mm_andnot_ps(isRising, falling));
+
+			if (bandLimited)
+			{
+				auto cornerScale = _mm_div_ps(phaseDeltaV, _mm_mul_ps(width, fallWidth));
+				auto residuals = _mm_sub_ps(blampResidual(wrapDistance(t), inverseDeltaV), blampResidual(wrapDistance(_mm_sub_ps(t, width)), inverseDeltaV));
+				value = _mm_add_ps(value, _mm_mul_ps(cornerScale, residuals));
+			}
+		}
+
+		auto* out = dest + sample;
+		_mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(value, gainV)));
+
+		phase += groupDelta;
+		phase -= std::floor(phase);
+	}
+
+	return sample;
+}
+#endif
+
+//==============================================================================
+void PolyBlepOscillator::setFrequency(float frequency, float sampleRate) noexcept
+{
+	//at most half a cycle per sample, so the corrections either side of a discontinuity never overlap
+	phaseDelta = jlimit(0.0f, 0.5f, frequency / sampleRate);
+	inverseDelta = 1.0f / jmax(minPhaseDelta, phaseDelta);
+}
+
+void PolyBlepOscillator::setPulseWidth(float newPulseWidth) noexcept
+{
+	targetPulseWidth = jlimit(minPulseWidth, 1.0f - minPulseWidth, newPulseWidth);
+}
+
+void PolyBlepOscillator::reset() noexcept
+{
+	phase = 0.0f;
+	pulseWidth = targetPulseWidth;
+}
+
+template <PolyBlepOscillator::Shape kernelShape, bool bandLimited>
+void PolyBlepOscillator::renderBlock(float* dest, int numSamples, float gain) noexcept
+{
+	if (numSamples <= 0)
+		return;
+
+	//the width glides from where the last block left it to the target, and lands on it with the last sample
+	auto widthStep = (targetPulseWidth - pulseWidth) / (float)numSamples;
+	auto sample = 0;
+
+	switch (KernelDispatch::getActiveLevel())
+	{
+	   #if AUDIOAPP_HAS_AVX2
+		case KernelDispatch::Level::avx512:
+		case KernelDispatch::Level::avx2:
+			sample = renderPolyBlepAVX2<kernelShape, bandLimited>(dest, numSamples, gain, phase, phaseDelta, inverseDelta, pulseWidth, widthStep);
+			break;
+	   #endif
+	   #if AUDIOAPP_HAS_SSE2
+		case KernelDispatch::Level::sse2:
+			sample = renderPolyBlepSSE2<kernelShape, bandLimited>(dest, numSamples, gain, phase, phaseDelta, inverseDelta, pulseWidth, widthStep);
+			break;
+	   #endif
+		default:
+			break;
+	}
+
+	//whatever doesn't fill a whole vector (or everything, with the scalar kernels)
+	for (; sample < numSamples; ++sample)
+	{
+		dest[sample] += getSample<kernelShape, bandLimited>(phase, pulseWidth + widthStep * (float)sample, phaseDelta, inverseDelta) * gain;
+
+		phase += phaseDelta;
+
+		if (phase >= 1.0f)
+			phase -= 1.0f;
+	}
+
+	pulseWidth = targetPulseWidth;
+}
+
+void PolyBlepOscillator::renderBlock(float* dest, int numSamples, float gain) noexcept
+{
+	switch (shape)
+	{
+		case Shape::pulse:		renderBlock<Shape::pulse>(dest, numSamples, gain); break;
+		case Shape::triangle:	renderBlock<Shape::triangle>(dest, numSamples, gain); break;
+		case Shape::saw:
+		default:				renderBlock<Shape::saw>(dest, numSamples, gain); break;
+	}
+}
+
+//the engine picks the shape once per block and calls these directly
+template void PolyBlepOscillator::renderBlock<PolyBlepOscillator::Shape::saw, true>(float*, int, float) noexcept;
+template void PolyBlepOscillator::renderBlock<PolyBlepOscillator::Shape::pulse, true>(float*, int, float) noexcept;
+template void PolyBlepOscillator::renderBlock<PolyBlepOscillator::Shape::triangle, true>(float*, int, float) noexcept;
+template void PolyBlepOscillator::renderBlock<PolyBlepOscillator::Shape::saw, false>(float*, int, float) noexcept;
+template void PolyBlepOscillator::renderBlock<PolyBlepOscillator::Shape::pulse, false>(float*, int, float) noexcept;
+template void PolyBlepOscillator::renderBlock<PolyBlepOscillator::Shape::triangle, false>(float*, int, float) noexcept;
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    PolyBlepOscillator.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+
+//Saw, pulse and triangle computed directly at the note's frequency, with the aliasing taken out by polynomial
+//corrections instead of wavetables or oversampling.
+//
+//A naive saw or pulse jumps in a single sample, which spreads harmonics far above Nyquist that fold back down.
+//PolyBLEP adds a two-sample polynomial residual around every jump that turns it into a (roughly) band-limited step.
+//The triangle has no jumps but corners, and PolyBLAMP, the integral of the same residual, rounds those off.
+//The residuals are sized from the voice's own phase increment, so they are right at every pitch.
+//
+//The pulse width (and the symmetry of the triangle) can move while the note plays: setPulseWidth() glides to the
+//new width over the next block, so modulating it from block to block doesn't click.
+class PolyBlepOscillator
+{
+	public:
+		enum class Shape
+		{
+			saw,
+			pulse,
+			triangle
+		};
+
+		PolyBlepOscillator() {}
+
+		void setShape(Shape newShape) noexcept		{ shape = newShape; }
+		Shape getShape() const noexcept				{ return shape; }
+
+		//the phase increment in cycles per sample, which also sizes the corrections
+		void setFrequency(float frequency, float sampleRate) noexcept;
+
+		//Share of the cycle the pulse is high, or the triangle is rising; 0.5 is a square or a symmetric triangle.
+		//Kept between minPulseWidth and 1 - minPulseWidth, and reached by the end of the next rendered block.
+		void setPulseWidth(float newPulseWidth) noexcept;
+
+		//back to the start of the cycle, with the width jumping straight to its target
+		void reset() noexcept;
+
+		//adds numSamples of the oscillator, scaled by gain, on top of whatever is already in dest
+		void renderBlock(float* dest, int numSamples, float gain) noexcept;
+
+		//The same with the shape fixed at compile time, for callers that pick it once for many voices.
+		//Without bandLimited the corrections are left out and it draws the naive shape, which aliases badly at the
+		//device rate but is what an oversampled voice renders before a HalfbandDecimator takes it back down.
+		template <Shape kernelShape, bool bandLimited = true>
+		void renderBlock(float* dest, int numSamples, float gain) noexcept;
+
+		//narrower than this and the pulse is mostly DC, and the triangle's slopes get steeper than the correction can follow
+		static constexpr float minPulseWidth = 0.02f;
+
+	private:
+		Shape shape = Shape::saw;
+		float phase = 0.0f, phaseDelta = 0.0f;	//in cycles
+		float inverseDelta = 1.0e6f;			//1 / phaseDelta, which scales the distance to a discontinuity into samples
+		float pulseWidth = 0.5f, targetPulseWidth = 0.5f;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PolyBlepOscillator)
+};
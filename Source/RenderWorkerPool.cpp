@@ -0,0 +1,202 @@
+/*
+  ==============================================================================
+
+    RenderWorkerPool.cpp
+
+  ==============================================================================
+*/
+
+#include "RenderWorkerPool.h"
+#include "SimdConfig.h"
+
+//tells the core we are busy-waiting, so it can save power and give a hyperthreaded sibling the pipeline
+static forcedinline void spinPause() noexcept
+{
+   #if JUCE_INTEL
+	_mm_pause();
+   #else
+	std::this_thread::yield();
+   #endif
+}
+
+//==============================================================================
+class RenderWorkerPool::Worker   : public Thread
+{
+	public:
+		Worker(RenderWorkerPool& ownerPool, int index)
+			: Thread("Render worker " + String(index)),
+			pool(ownerPool)
+		{
+		}
+
+		void run() override
+		{
+			auto seenGeneration = pool.generation.load(std::memory_order_acquire);
+
+			while (! threadShouldExit())
+			{
+				//spin first: while the device is running the next block arrives well within the spin time
+				auto spinEnd = Time::getHighResolutionTicks() + pool.spinTicks.load(std::memory_order_relaxed);
+
+				while (pool.generation.load(std::memory_order_acquire) == seenGeneration
+						&& Time::getHighResolutionTicks() < spinEnd && ! threadShouldExit())
+					spinPause();
+
+				auto generation = pool.generation.load(std::memory_order_acquire);
+
+				if (generation == seenGeneration)
+				{
+					//Nothing came, so park. The flag is raised before the generation is checked once more,
+					//and the audio thread bumps the generation before it reads the flag, so one of the two always sees the other.
+					isParked.store(true);
+
+					if (pool.generation.load() == seenGeneration)
+						wakeUp.wait(100);
+
+					isParked.store(false);
+					continue;
+				}
+
+				seenGeneration = generation;
+				pool.renderAvailableChunks();
+			}
+		}
+
+		//called by the audio thread after publishing a block; only costs a system call if the worker is actually asleep
+		void wakeIfParked() noexcept
+		{
+			if (isParked.load())
+				wakeUp.signal();
+		}
+
+		void stop()
+		{
+			signalThreadShouldExit();
+			wakeUp.signal();
+			stopThread(1000);
+		}
+
+	private:
+		RenderWorkerPool& pool;
+		WaitableEvent wakeUp;
+		std::atomic<bool> isParked { false };
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Worker)
+};
+
+//==============================================================================
+RenderWorkerPool::RenderWorkerPool(int numWorkers)
+	: numChunks(jmax(0, numWorkers) + 1),
+	chunkStarts((size_t)(numChunks + 1), true)
+{
+	for (auto i = 0; i < numChunks - 1; ++i)
+	{
+		auto* worker = workers.add(new Worker(*this, i + 1));
+		worker->startThread(Thread::realtimeAudioPriority);
+	}
+}
+
+RenderWorkerPool::~RenderWorkerPool()
+{
+	for (auto* worker : workers)
+		worker->stop();
+}
+
+int RenderWorkerPool::getDefaultNumWorkers(int numVoices)
+{
+	return jlimit(0, jmax(0, SystemStats::getNumPhysicalCpus() - 1), numVoices / minVoicesPerChunk - 1);
+}
+
+void RenderWorkerPool::prepare(int newMaxBlockSize, double sampleRate)
+{
+	//each chunk buffer starts on its own cache line, so two threads never write to the same one
+	maxBlockSize = jmax(1, newMaxBlockSize);
+	chunkBufferStride = (maxBlockSize + 15) & ~15;
+	chunkBuffers.allocate((size_t)(chunkBufferStride * jmax(1, numChunks - 1)), true);
+
+	spinTicks.store(Time::secondsToHighResolutionTicks(maxBlockSize / jmax(1.0, sampleRate)));
+}
+
+void RenderWorkerPool::renderBlock(VoiceBank& voiceBank, float* dest, int numSamples) noexcept
+{
+	auto numVoices = voiceBank.getNumVoices();
+
+	//as many chunks as the voices fill, up to one per thread; this only depends on the voice count, so it is deterministic too
+	auto numChunksToUse = jmin(numChunks, numVoices / minVoicesPerChunk);
+
+	if (numChunksToUse <= 1 || maxBlockSize == 0 || voiceBank.getWavetableSet() == nullptr)
+	{
+		voiceBank.renderBlock(dest, numSamples);
+		return;
+	}
+
+	for (auto i = 0; i <= numChunksToUse; ++i)
+	{
+		auto start = (int)((int64)numVoices * i / numChunksToUse);
+		chunkStarts[i] = jmin(numVoices, (start + VoiceBank::voiceAlignment - 1) / VoiceBank::voiceAlignment * VoiceBank::voiceAlignment);
+	}
+
+	//a device block longer than prepare() allowed for is rendered in several passes
+	for (auto position = 0; position < numSamples; position += maxBlockSize)
+	{
+		auto numThisTime = jmin(maxBlockSize, numSamples - position);
+		voiceBank.beginBlock(numThisTime);
+
+		//everything the chunks read is written before the counter is reset, which is what publishes it
+		currentBank = &voiceBank;
+		currentDest = dest + position;
+		currentNumSamples = numThisTime;
+		chunksDone.store(0, std::memory_order_relaxed);
+		chunksToClaim.store(numChunksToUse, std::memory_order_release);
+		generation.fetch_add(1);
+
+		for (auto* worker : workers)
+			worker->wakeIfParked();
+
+		//the audio thread works through the chunks as well, then only waits for the ones already being rendered
+		renderAvailableChunks();
+
+		while (chunksDone.load(std::memory_order_acquire) < numChunksToUse)
+			spinPause();
+
+		//sum in chunk order, so the output doesn't depend on which thread rendered what
+		for (auto chunk = 1; chunk < numChunksToUse; ++chunk)
+			FloatVectorOperations::add(currentDest, getChunkBuffer(chunk), numThisTime);
+
+		voiceBank.endBlock(numThisTime);
+	}
+}
+
+void RenderWorkerPool::renderAvailableChunks() noexcept
+{
+	//Counting down means a claim never has to know how many chunks this block has. A thread arriving after the last
+	//claim only takes the counter below zero, which the next block overwrites anyway.
+	for (;;)
+	{
+		auto remaining = chunksToClaim.fetch_sub(1, std::memory_order_acq_rel);
+
+		if (remaining <= 0)
+			return;
+
+		renderChunk(remaining - 1);
+		chunksDone.fetch_add(1, std::memory_order_release);
+	}
+}
+
+void RenderWorkerPool::renderChunk(int chunk) noexcept
+{
+	auto firstVoice = chunkStarts[chunk];
+	auto endVoice = chunkStarts[chunk + 1];
+
+	//chunk 0 adds straight onto the output, which is the same as adding its buffer first
+	auto* chunkDest = currentDest;
+
+	if (chunk > 0)
+	{
+		chunkDest = getChunkBuffer(chunk);
+		FloatVectorOperations::clear(chunkDest, currentNumSamples);
+	}
+
+	if (firstVoice < endVoice)
+		currentBank->renderVoices(chunkDest, currentNumSamples, firstVoice, endVoice);
+}
@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    RenderWorkerPool.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "VoiceBank.h"
+
+//Spreads the voices of a VoiceBank over a fixed set of real-time priority threads.
+//
+//Every block, the voices are cut into one chunk per thread (the audio thread counts as one). Each chunk
+//renders into its own preallocated buffer, and the buffers are summed into the output in chunk order afterwards,
+//so the result is the same bit for bit however the chunks end up distributed between the threads.
+//
+//Chunks are claimed from a shared counter, and the audio thread claims them too. So a worker that is late
+//or asleep only means the audio thread renders more chunks itself. The block never waits for a thread to wake up,
+//only for chunks that another thread is already rendering. After each block the workers spin for about
+//one block period, so while the device is running they are awake for the next one. Once the blocks stop coming
+//they park on an event instead of burning the core.
+class RenderWorkerPool
+{
+	public:
+		//starts numWorkers threads on top of the audio thread; 0 renders everything on the calling thread
+		explicit RenderWorkerPool(int numWorkers);
+		~RenderWorkerPool();
+
+		//allocates the chunk buffers and sets the spin time; not real-time safe, call from prepareToPlay()
+		void prepare(int maxBlockSize, double sampleRate);
+
+		//adds numSamples of every voice in the bank on top of dest, using all workers; call from the audio thread
+		void renderBlock(VoiceBank& voiceBank, float* dest, int numSamples) noexcept;
+
+		int getNumWorkers() const noexcept { return workers.size(); }
+
+		//a reasonable worker count for numVoices voices on this machine: one per physical core besides the audio thread,
+		//but never so many that a chunk ends up with fewer than minVoicesPerChunk voices
+		static int getDefaultNumWorkers(int numVoices);
+
+		//below this many voices per chunk, waking the workers costs more than it saves
+		static constexpr int minVoicesPerChunk = 64;
+
+	private:
+		class Worker;
+
+		//renders every chunk it can still claim from the current block
+		void renderAvailableChunks() noexcept;
+		void renderChunk(int chunk) noexcept;
+		float* getChunkBuffer(int chunk) const noexcept { return chunkBuffers.get() + (chunk - 1) * chunkBufferStride; }
+
+		OwnedArray<Worker> workers;
+		int numChunks;
+
+		//chunk 0 is rendered straight into the output, the others each get chunkBufferStride floats here
+		HeapBlock<float> chunkBuffers;
+		int maxBlockSize = 0, chunkBufferStride = 0;
+
+		//the current block; written by the audio thread before chunksToClaim is set, read by whoever claims a chunk
+		VoiceBank* currentBank = nullptr;
+		float* currentDest = nullptr;
+		int currentNumSamples = 0;
+		HeapBlock<int> chunkStarts;
+
+		std::atomic<int> chunksToClaim { 0 }, chunksDone { 0 };
+		std::atomic<uint32> generation { 0 };
+		std::atomic<int64> spinTicks { 0 };
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderWorkerPool)
+};
@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    SimdConfig.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+//Which SIMD kernels are compiled in. Every kernel also has a scalar version, and KernelDispatch picks one at runtime.
+//SSE2 needs to be part of the baseline the project is compiled for, which it always is on x64.
+//The AVX2 kernels are compiled for AVX2 whatever the baseline is, so the same binary uses them on the machines
+//that have it and still runs on the ones that don't.
+#if JUCE_INTEL && (defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2))
+ #define AUDIOAPP_HAS_SSE2 1
+ #define AUDIOAPP_HAS_AVX2 1
+
+ //Only the wavetable voice kernel has an AVX-512 version, where 16 lanes are a whole voiceAlignment group and one
+ //gather fetches 16 voices. The other kernels run their AVX2 version at this level. MSVC has the intrinsics from 15.3.
+ #if ! JUCE_MSVC || _MSC_VER >= 1911
+  #define AUDIOAPP_HAS_AVX512 1
+ #endif
+#endif
+
+//Put in front of every function that uses AVX2 intrinsics, including the inline helpers they call.
+//MSVC compiles the intrinsics in any function; GCC and clang have to be told the function may use them.
+//FMA is left out on purpose: GCC and clang contract a multiply and an add into one FMA by default once they may,
+//which rounds once instead of twice and would make the AVX2 kernels sound different from the SSE2 and scalar ones.
+#if JUCE_MSVC
+ #define AUDIOAPP_TARGET_AVX2
+#else
+ #define AUDIOAPP_TARGET_AVX2 __attribute__ ((target ("avx2")))
+#endif
+
+//The same for AVX-512F. GCC can't enable it without FMA, so contraction is switched off for those functions instead;
+//clang only contracts within one expression, which intrinsics never are.
+#if JUCE_MSVC
+ #define AUDIOAPP_TARGET_AVX512
+#elif JUCE_CLANG
+ #define AUDIOAPP_TARGET_AVX512 __attribute__ ((target ("avx512f")))
+#else
+ #define AUDIOAPP_TARGET_AVX512 __attribute__ ((target ("avx512f"), optimize ("fp-contract=off")))
+#endif
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    SpectralWavetableBuilder.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectralWavetableBuilder.h"
+
+SpectralWavetableBuilder::SpectralWavetableBuilder(int size)
+	: tableSize(size)
+{
+	jassert(isPowerOfTwo(tableSize) && tableSize >= 2);
+
+	while ((1 << order) < tableSize)
+		++order;
+
+	bins.allocate((size_t)tableSize, true);
+
+	//e^(+j 2pi k / N) for the first half of the circle, which is all the butterflies of an inverse transform need
+	twiddles.allocate((size_t)(tableSize / 2), true);
+	for (auto k = 0; k < tableSize / 2; ++k)
+		twiddles[k] = std::polar(1.0, MathConstants<double>::twoPi * k / (double)tableSize);
+
+	bitReversed.allocate((size_t)tableSize, true);
+	for (auto i = 0; i < tableSize; ++i)
+	{
+		auto reversed = 0;
+		for (auto bit = 0; bit < order; ++bit)
+			reversed |= ((i >> bit) & 1) << (order - 1 - bit);
+
+		bitReversed[i] = reversed;
+	}
+}
+
+void SpectralWavetableBuilder::buildTable(float* dest, const float* magnitudes, const float* phases, int numHarmonics) noexcept
+{
+	jassert(isPositiveAndBelow(numHarmonics, tableSize / 2 + 1));
+	numHarmonics = jmin(numHarmonics, tableSize / 2);
+
+	//Put every harmonic straight into its bin in bit-reversed order, so the transform can run in place.
+	//sin(x + phase) is the real part of e^(j (x + phase - pi/2)), hence the quarter-turn on every bin.
+	std::fill(bins.get(), bins.get() + tableSize, std::complex<double>());
+
+	for (auto harmonic = 1; harmonic <= numHarmonics; ++harmonic)
+	{
+		auto phase = phases != nullptr ? (double)phases[harmonic] : 0.0;
+		bins[bitReversed[harmonic]] = std::polar((double)magnitudes[harmonic], phase - MathConstants<double>::halfPi);
+	}
+
+	performInverseFFT();
+
+	//only positive frequencies were filled in, so the real part of the result is the waveform itself
+	for (auto i = 0; i < tableSize; ++i)
+		dest[i] = (float)bins[i].real();
+
+	dest[tableSize] = dest[0]; //the last sample is the same as the first
+}
+
+void SpectralWavetableBuilder::performInverseFFT() noexcept
+{
+	//iterative radix-2 decimation in time over bins that are already in bit-reversed order, left unscaled
+	for (auto halfSize = 1; halfSize < tableSize; halfSize <<= 1)
+	{
+		auto twiddleStride = tableSize / (halfSize * 2);
+
+		for (auto start = 0; start < tableSize; start += halfSize * 2)
+		{
+			for (auto k = 0; k < halfSize; ++k)
+			{
+				auto& even = bins[start + k];
+				auto& odd = bins[start + k + halfSize];
+				auto rotated = odd * twiddles[k * twiddleStride];
+
+				odd = even - rotated;
+				even += rotated;
+			}
+		}
+	}
+}
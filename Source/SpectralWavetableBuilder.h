@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    SpectralWavetableBuilder.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include <complex>
+
+
+//Turns a harmonic spectrum into one cycle of a wavetable with a single inverse FFT,
+//instead of summing a std::sin loop per harmonic (O(tableSize log tableSize) rather than O(harmonics * tableSize)).
+//The project doesn't pull in juce_dsp, so this carries its own radix-2 FFT. Everything is allocated in the
+//constructor, so buildTable() can be called as often as needed from any thread that isn't the audio thread.
+class SpectralWavetableBuilder
+{
+	public:
+		//tableSize has to be a power of two
+		explicit SpectralWavetableBuilder(int tableSize);
+
+		int getTableSize() const noexcept { return tableSize; }
+
+		//Writes tableSize samples plus the guard sample into dest, where
+		//    dest[i] = sum over n of magnitudes[n] * sin(2pi * n * i / tableSize + phases[n])
+		//Both arrays are indexed by harmonic number, so they need numHarmonics + 1 entries and index 0 (DC) is ignored.
+		//numHarmonics can go up to tableSize / 2; phases can be nullptr for all sines starting at zero.
+		void buildTable(float* dest, const float* magnitudes, const float* phases, int numHarmonics) noexcept;
+
+	private:
+		void performInverseFFT() noexcept;
+
+		int tableSize, order = 0;
+		HeapBlock<std::complex<double>> bins, twiddles;
+		HeapBlock<int> bitReversed;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectralWavetableBuilder)
+};
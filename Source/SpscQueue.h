@@ -0,0 +1,62 @@
+/*
+  ==============================================================================
+
+    SpscQueue.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+
+//Single-producer/single-consumer lock-free queue of ItemType, one item at a time, on top of an AbstractFifo.
+//One thread pushes and one other thread pops, and neither ever blocks or allocates: all storage is allocated in
+//the constructor. ParameterQueue, BlockTimingMonitor and EventRecorder each keep one of these.
+template <typename ItemType>
+class SpscQueue
+{
+	public:
+		explicit SpscQueue(int capacity)
+			: fifo(capacity), items((size_t)capacity)
+		{
+		}
+
+		//producer side only; returns false and drops the item if the queue is full
+		bool push(const ItemType& item) noexcept
+		{
+			int start1, size1, start2, size2;
+			fifo.prepareToWrite(1, start1, size1, start2, size2);
+
+			if (size1 + size2 == 0)
+				return false;
+
+			items[size1 > 0 ? start1 : start2] = item;
+			fifo.finishedWrite(1);
+			return true;
+		}
+
+		//consumer side only; returns false once the queue is empty
+		bool pop(ItemType& item) noexcept
+		{
+			int start1, size1, start2, size2;
+			fifo.prepareToRead(1, start1, size1, start2, size2);
+
+			if (size1 + size2 == 0)
+				return false;
+
+			item = items[size1 > 0 ? start1 : start2];
+			fifo.finishedRead(1);
+			return true;
+		}
+
+		//how many more items fit; exact on the producer side, a lower bound anywhere else
+		int getFreeSpace() const noexcept		{ return fifo.getFreeSpace(); }
+
+	private:
+		AbstractFifo fifo;
+		HeapBlock<ItemType> items;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpscQueue)
+};
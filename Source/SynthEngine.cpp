@@ -0,0 +1,1106 @@
+/*
+  ==============================================================================
+
+    SynthEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "SynthEngine.h"
+
+//how long frequency and gain changes from the GUI take to glide to their new value
+static const double parameterRampSeconds = 0.02;
+
+//fade in and out of every note, short enough to feel immediate but long enough not to click
+static const double attackSeconds = 0.005;
+static const double releaseSeconds = 0.05;
+
+//below this a plucked string counts as finished (-80 dB)
+static const float silenceThreshold = 1.0e-4f;
+
+//how often, in rendered samples, voices that have died away go back to the pool; a string has to stay quiet this long
+static const int freeVoicesInterval = 256;
+
+//where the oversampled voices start, which puts the aliases of a saw's harmonics well below its own
+static const int defaultOversamplingFactor = 4;
+
+//slides a buffer allocated with 16 floats to spare onto a 64-byte boundary, for the widest vector loads and the cache
+static float* alignToCacheLine(float* storage) noexcept
+{
+	return (float*)(((pointer_sized_uint)storage + 63) & ~(pointer_sized_uint)63);
+}
+
+//==============================================================================
+SynthEngine::SynthEngine(int numVoicesToUse, VoiceType voiceTypeToUse, int numWorkerThreads)
+	: numVoices(jmax(1, numVoicesToUse)),
+	voiceType(voiceTypeToUse),
+	parameterQueue(jmax(256, 2 * numVoices)),
+	voicePool(numVoices),
+	workerPool(voiceType != VoiceType::wavetable ? 0 : numWorkerThreads >= 0 ? numWorkerThreads : RenderWorkerPool::getDefaultNumWorkers(numVoices)),
+	randomSeed(Random::getSystemRandom().nextInt64())
+{
+	//the first call detects the CPU, which has to happen here rather than in the first audio block
+	KernelDispatch::getActiveLevel();
+
+	//every voice starts out at the full level of its release ramp
+	releaseGains.allocate((size_t)numVoices, false);
+	FloatVectorOperations::fill(releaseGains, 1.0f, numVoices);
+	glideFrequencies.allocate((size_t)numVoices, true);
+	glideTargets.allocate((size_t)numVoices, true);
+	glideSamplesRemaining.allocate((size_t)numVoices, true);
+
+	//Start with the sine, and have the cache build the other shapes in the background so switching to them is instant.
+	//Only the first engine in the process pays for that, the others find everything already there.
+	wavetablePublisher.publish(wavetableCache->getSet(shape, tableSize));
+	wavetableCache->prefetch(tableSize);
+
+	//Every voice is allocated here, once, rather than on the audio thread: wavetable voices are slots in the bank's arrays,
+	//sine, PolyBLEP, wavetable bank and string voices are objects that the pool hands out by index. The strings get their delay lines in
+	//prepareToPlay(), since how long those have to be depends on the sample rate.
+	if (voiceType == VoiceType::wavetable)
+	{
+		voiceBank.setCapacity(numVoices);
+	}
+	else if (voiceType == VoiceType::pluckedString)
+	{
+		for (auto i = 0; i < numVoices; ++i)
+			strings.add(new PluckedStringVoice());
+	}
+	else if (usesBlepOscillators())
+	{
+		for (auto i = 0; i < numVoices; ++i)
+			blepOscillators.add(new PolyBlepOscillator())->setShape(blepShape);
+
+		//the audio thread isn't running yet, so this can be set directly instead of through the queue
+		if (voiceType == VoiceType::oversampled)
+			oversamplingFactor = defaultOversamplingFactor;
+	}
+	else if (voiceType == VoiceType::wavetableBank)
+	{
+		//they stay silent until loadWavetableBank() hands them something to play
+		for (auto i = 0; i < numVoices; ++i)
+			bankOscillators.add(new WavetableBankOscillator());
+	}
+	else
+	{
+		for (auto i = 0; i < numVoices; ++i)
+			oscillators.add(new SineOscillator())->setMode(sineMode);
+	}
+}
+
+SynthEngine::~SynthEngine()
+{
+}
+
+//==============================================================================
+void SynthEngine::setFrequency(float frequency)
+{
+	//The audio thread owns the voices and the sample rate, so this only queues the new value for it.
+	parameterQueue.push({ ParameterEvent::Type::frequency, frequency });
+}
+
+void SynthEngine::setGain(float gain)
+{
+	parameterQueue.push({ ParameterEvent::Type::gain, gain });
+}
+
+bool SynthEngine::startNote(int noteNumber, float frequency, float velocity)
+{
+	ParameterEvent event { ParameterEvent::Type::noteOn, frequency };
+	event.noteNumber = noteNumber;
+	event.velocity = velocity;
+	return parameterQueue.push(event);
+}
+
+bool SynthEngine::stopNote(int noteNumber)
+{
+	ParameterEvent event { ParameterEvent::Type::noteOff, 0.0f };
+	event.noteNumber = noteNumber;
+	return parameterQueue.push(event);
+}
+
+void SynthEngine::setStealingPolicy(VoicePool::StealingPolicy policy)
+{
+	parameterQueue.push({ ParameterEvent::Type::stealingPolicy, (float)policy });
+}
+
+void SynthEngine::setSineMode(SineOscillator::Mode mode)
+{
+	parameterQueue.push({ ParameterEvent::Type::sineMode, (float)mode });
+}
+
+void SynthEngine::setWaveform(WavetableSet::Shape newShape)
+{
+	//The set is published for the audio thread to pick up at the start of its next block.
+	shape = newShape;
+	wavetablePublisher.publish(wavetableCache->getSet(shape, tableSize));
+
+	//the shapes the PolyBLEP voices can draw without a table
+	if (shape == WavetableSet::Shape::saw)
+		parameterQueue.push({ ParameterEvent::Type::blepShape, (float)PolyBlepOscillator::Shape::saw });
+	else if (shape == WavetableSet::Shape::square)
+		parameterQueue.push({ ParameterEvent::Type::blepShape, (float)PolyBlepOscillator::Shape::pulse });
+	else if (shape == WavetableSet::Shape::triangle)
+		parameterQueue.push({ ParameterEvent::Type::blepShape, (float)PolyBlepOscillator::Shape::triangle });
+}
+
+void SynthEngine::setPulseWidth(float width)
+{
+	parameterQueue.push({ ParameterEvent::Type::pulseWidth, width });
+}
+
+void SynthEngine::setOversamplingFactor(int factor)
+{
+	jassert(factor == 1 || factor == 2 || factor == 4 || factor == HalfbandDecimator::maxFactor);
+	parameterQueue.push({ ParameterEvent::Type::oversampling, (float)factor });
+}
+
+void SynthEngine::setSubBlockSize(int numSamples)
+{
+	jassert(isValidSubBlockSize(numSamples));
+	parameterQueue.push({ ParameterEvent::Type::subBlockSize, (float)numSamples });
+}
+
+bool SynthEngine::loadWavetableBank(const File& file, String& errorMessage, int defaultFrameSize)
+{
+	auto newBank = wavetableCache->getBank(file, errorMessage, defaultFrameSize);
+
+	if (newBank == nullptr)
+		return false;
+
+	//the voices pick it up at the start of the next block and start reading straight away at the current position
+	bank = newBank;
+	bank->touchFrames(requestedBankPosition);
+	bankPublisher.publish(bank);
+	return true;
+}
+
+void SynthEngine::setBankPosition(float position)
+{
+	requestedBankPosition = jlimit(0.0f, 1.0f, position);
+
+	if (bank != nullptr)
+		bank->touchFrames(requestedBankPosition);
+
+	parameterQueue.push({ ParameterEvent::Type::bankPosition, requestedBankPosition });
+}
+
+void SynthEngine::setTableSize(int newTableSize)
+{
+	//the voices keep their phases as fractions of a cycle, so the bank can switch resolution mid-note
+	jassert(isPowerOfTwo(newTableSize) && newTableSize >= 16);
+	tableSize = jmax(16, nextPowerOfTwo(newTableSize));
+	wavetablePublisher.publish(wavetableCache->getSet(shape, tableSize));
+	wavetableCache->prefetch(tableSize);
+}
+
+void SynthEngine::setInterpolation(TableInterpolation::Mode mode)
+{
+	parameterQueue.push({ ParameterEvent::Type::interpolation, (float)mode });
+}
+
+EventLogHeader SynthEngine::createEventLogHeader() const
+{
+	EventLogHeader header;
+	header.voiceType = (int)voiceType;
+	header.numVoices = numVoices;
+	header.numWorkerThreads = workerPool.getNumWorkers();
+	header.randomSeed = randomSeed;
+	return header;
+}
+
+bool SynthEngine::replayRecord(const EventLogRecord& record)
+{
+	if (record.kind == EventLogRecord::Kind::parameter)
+		return parameterQueue.push(record.event);
+
+	//the set goes out the same way setWaveform() and setTableSize() publish it, without the events they queue on the side
+	if (record.kind == EventLogRecord::Kind::wavetable)
+	{
+		shape = (WavetableSet::Shape)record.shape;
+		tableSize = record.tableSize;
+		wavetablePublisher.publish(wavetableCache->getSet(shape, tableSize));
+	}
+
+	return true;
+}
+
+void SynthEngine::collectGarbage()
+{
+	wavetablePublisher.collectGarbage();
+	bankPublisher.collectGarbage();
+	wavetableCache->collectGarbage();
+}
+
+//==============================================================================
+void SynthEngine::prepareToPlay (int samplesPerBlockExpected, double sampleRate)
+{
+	//The voices are never allocated here, only reset to suit the new device settings. The only buffers sized here
+	//are the ones that depend on the block size, and those only grow.
+	currentSampleRate = sampleRate;
+	workerPool.prepare(samplesPerBlockExpected, sampleRate);
+	random.setSeed(randomSeed);
+
+	if (runKernelSelfBenchmark)
+		selectFastestKernel(samplesPerBlockExpected, sampleRate);
+
+	//room for a whole sub-block of the largest size, even if the device's blocks are shorter
+	if (jmax(samplesPerBlockExpected, maxSubBlockSize) > mixBufferSize)
+	{
+		mixBufferSize = jmax(samplesPerBlockExpected, maxSubBlockSize);
+		mixStorage.allocate((size_t)mixBufferSize + 16, true);
+		mixBuffer = alignToCacheLine(mixStorage);
+
+		//long enough for an oversampled voice at the highest factor
+		voiceStorage.allocate((size_t)(mixBufferSize * HalfbandDecimator::maxFactor) + 16, true);
+		voiceBuffer = alignToCacheLine(voiceStorage);
+	}
+
+	//the voices without a gain of their own fade out along this, from 1 to 0 over releaseSeconds
+	releaseStep = (float)(1.0 / (releaseSeconds * sampleRate));
+
+	//the samples the last device left over belong to the old settings
+	carriedStart = carriedSamples = 0;
+	samplesSinceFreed = 0;
+
+	if (voiceType == VoiceType::wavetable)
+	{
+		voiceBank.removeAllVoices();
+		voiceBank.setWavetableSet(wavetablePublisher.acquire());
+		recordWavetableSet(voiceBank.getWavetableSet());
+	}
+	else if (voiceType == VoiceType::pluckedString)
+	{
+		//one period of the lowest note, plus the extra sample the loop reads behind it
+		delayLines.allocate(numVoices, (int)std::ceil(sampleRate / PluckedStringVoice::lowestFrequency) + 2);
+
+		for (auto i = 0; i < numVoices; ++i)
+			strings.getUnchecked(i)->setDelayLine(delayLines.getLine(i), delayLines.getLineLength());
+	}
+	else if (voiceType == VoiceType::oversampled)
+	{
+		//room for the highest factor, whatever the current one is
+		oversampledStorage.allocate((size_t)(mixBufferSize * HalfbandDecimator::maxFactor) + 16, true);
+		oversampledBuffer = alignToCacheLine(oversampledStorage);
+		decimator.prepare(mixBufferSize);
+		decimator.setFactor(oversamplingFactor);
+	}
+	else if (voiceType == VoiceType::wavetableBank)
+	{
+		auto* currentBank = bankPublisher.acquire();
+
+		for (auto* oscillator : bankOscillators)
+			oscillator->setBank(currentBank);
+	}
+
+	//Notes that were held before the restart start again from the top at the new sample rate.
+	//Releases that were still fading out are dropped, and so are plucked strings, which were silenced above.
+	auto endVoice = voicePool.getEndVoice();
+
+	for (auto voice = 0; voice < endVoice; ++voice)
+	{
+		auto state = voicePool.getState(voice);
+
+		if (state == VoicePool::State::releasing || voiceType == VoiceType::pluckedString)
+		{
+			voicePool.free(voice);
+		}
+		else if (state == VoicePool::State::playing)
+		{
+			auto frequency = voicePool.getFrequency(voice);
+
+			if (voiceType == VoiceType::wavetable)
+			{
+				voiceBank.startVoice(voice, frequency, (float)sampleRate, voicePool.getVelocity(voice) * currentGain);
+			}
+			else if (usesBlepOscillators())
+			{
+				blepOscillators.getUnchecked(voice)->reset();
+				blepOscillators.getUnchecked(voice)->setFrequency(frequency, getVoiceSampleRate());
+			}
+			else if (voiceType == VoiceType::wavetableBank)
+			{
+				bankOscillators.getUnchecked(voice)->reset();
+				bankOscillators.getUnchecked(voice)->setFrequency(frequency, (float)sampleRate);
+			}
+			else
+			{
+				oscillators.getUnchecked(voice)->reset();
+				oscillators.getUnchecked(voice)->setFrequency(frequency, (float)sampleRate);
+			}
+		}
+	}
+
+	//the held notes have started again at the frequency they were heading for, so any glide is over
+	zeromem(glideSamplesRemaining, sizeof(int) * (size_t)numVoices);
+	hasActiveGlides = false;
+
+	//notes queued before the device started come in here
+	processParameterEvents();
+
+	if (voiceType == VoiceType::wavetable)
+		voiceBank.setNumVoices(voicePool.getEndVoice());
+
+	//Finally, we define the output level by dividing a quiet gain level by the number of oscillators to prevent clipping
+	//of the signal by summing such a large number of oscillator samples.
+	level = 0.25f / numVoices;
+
+	//The kernels are logged after the self-benchmark picked them; they round differently, so a replay has to use the same.
+	if (eventRecorder.isEnabled())
+	{
+		EventLogRecord record;
+		record.kind = EventLogRecord::Kind::prepare;
+		record.numSamples = samplesPerBlockExpected;
+		record.sampleRate = sampleRate;
+		record.kernelLevel = (int)KernelDispatch::getActiveLevel();
+		eventRecorder.add(record);
+	}
+}
+
+void SynthEngine::getNextAudioBlock(const AudioSourceChannelInfo& bufferToFill)
+{
+	//Each block is timed on its own and handed to the message thread, so a single slow one shows up
+	//instead of disappearing into an average.
+	auto startTicks = Time::getHighResolutionTicks();
+	renderNextBlock(bufferToFill);
+	auto endTicks = Time::getHighResolutionTicks();
+
+	timingMonitor.addBlock(startTicks, endTicks, bufferToFill.numSamples, currentSampleRate, voicePool.getNumActive());
+
+	if (eventRecorder.isEnabled())
+	{
+		EventLogRecord record;
+		record.kind = EventLogRecord::Kind::block;
+		record.numSamples = bufferToFill.numSamples;
+		eventRecorder.add(record);
+	}
+}
+
+void SynthEngine::processBlock(AudioBuffer<float>& buffer, const MidiBuffer& midiMessages)
+{
+	//The block is cut at every MIDI event, so each note starts at the first sub-block boundary on or after its own sample
+	//rather than at the top of the block. Following the device's blocks, that is the note's own sample.
+	auto numSamples = buffer.getNumSamples();
+	auto position = 0;
+	MidiMessage message;
+	int eventPosition;
+
+	for (MidiBuffer::Iterator iterator(midiMessages); iterator.getNextEvent(message, eventPosition);)
+	{
+		eventPosition = jlimit(position, numSamples, eventPosition);
+
+		if (eventPosition > position)
+		{
+			getNextAudioBlock(AudioSourceChannelInfo(&buffer, position, eventPosition - position));
+			position = eventPosition;
+		}
+
+		handleMidiMessage(message);
+	}
+
+	if (position < numSamples)
+		getNextAudioBlock(AudioSourceChannelInfo(&buffer, position, numSamples - position));
+}
+
+void SynthEngine::renderNextBlock(const AudioSourceChannelInfo& bufferToFill)
+{
+	if (mixBufferSize == 0 || bufferToFill.buffer->getNumChannels() == 0)
+	{
+		//not prepared yet, or nowhere to play; whatever the GUI has changed is still applied
+		processParameterEvents();
+		bufferToFill.clearActiveBufferRegion();
+		return;
+	}
+
+	//only the first two channels carry the synth, anything beyond them stays silent
+	for (auto channel = 2; channel < bufferToFill.buffer->getNumChannels(); ++channel)
+		bufferToFill.buffer->clear(channel, bufferToFill.startSample, bufferToFill.numSamples);
+
+	//What the last callback left of its final sub-block goes out first, so the sound never shows where the
+	//device's blocks begin and end. Only once that is used up are new sub-blocks rendered.
+	auto position = jmin(carriedSamples, bufferToFill.numSamples);
+	copyToOutput(mixBuffer + carriedStart, bufferToFill, 0, position);
+	carriedStart += position;
+	carriedSamples -= position;
+	while (position < bufferToFill.numSamples)
+	{
+		subBlockOffset = position;
+		auto numRendered = renderSubBlock(bufferToFill.numSamples - position);
+		auto numToCopy = jmin(numRendered, bufferToFill.numSamples - position);
+		copyToOutput(mixBuffer, bufferToFill, position, numToCopy);
+
+		carriedStart = numToCopy;
+		carriedSamples = numRendered - numToCopy;
+		position += numToCopy;
+	}
+
+	//MIDI notes and prepareToPlay() apply events between callbacks, at the start of the next one
+	subBlockOffset = 0;
+}
+
+int SynthEngine::renderSubBlock(int numSamplesWanted)
+{
+	//apply whatever the GUI has changed since the last sub-block before rendering anything
+	auto previousGain = currentGain;
+	processParameterEvents();
+
+	auto numSamples = subBlockSize > 0 ? subBlockSize : jmin(mixBufferSize, numSamplesWanted);
+
+	//The kind of voice is picked once here for the whole sub-block.
+	if (voiceType == VoiceType::wavetable)
+	{
+		//Switch to a newly published wavetable set, if there is one, before any voice reads from it.
+		auto* wavetableSet = wavetablePublisher.acquire();
+		if (wavetableSet != voiceBank.getWavetableSet())
+		{
+			voiceBank.setWavetableSet(wavetableSet);
+			recordWavetableSet(wavetableSet);
+		}
+
+		//the wavetable voices carry the gain themselves, so the mix only needs trimming by the level
+		renderVoices(mixBuffer, numSamples, WavetableVoices());
+		applyGain(mixBuffer, numSamples, level, level);
+		freeFinishedVoices(numSamples);
+		return numSamples;
+	}
+
+	if (hasActiveGlides)
+		advanceGlides(numSamples);
+
+	if (voiceType == VoiceType::pluckedString)
+	{
+		renderVoices(mixBuffer, numSamples, PluckedStringVoices());
+	}
+	else if (voiceType == VoiceType::wavetableBank)
+	{
+		//a newly loaded bank takes over from the first sample of this sub-block, at the same phase and position
+		auto* currentBank = bankPublisher.acquire();
+
+		if (currentBank != bankOscillators.getUnchecked(0)->getBank())
+			for (auto* oscillator : bankOscillators)
+				oscillator->setBank(currentBank);
+
+		renderVoices(mixBuffer, numSamples, BankVoices());
+	}
+	else if (voiceType == VoiceType::polyBlep)
+	{
+		switch (blepShape)
+		{
+			case PolyBlepOscillator::Shape::pulse:		renderVoices(mixBuffer, numSamples, PolyBlepVoices<PolyBlepOscillator::Shape::pulse>()); break;
+			case PolyBlepOscillator::Shape::triangle:	renderVoices(mixBuffer, numSamples, PolyBlepVoices<PolyBlepOscillator::Shape::triangle>()); break;
+			case PolyBlepOscillator::Shape::saw:
+			default:									renderVoices(mixBuffer, numSamples, PolyBlepVoices<PolyBlepOscillator::Shape::saw>()); break;
+		}
+	}
+	else if (voiceType == VoiceType::oversampled)
+	{
+		switch (blepShape)
+		{
+			case PolyBlepOscillator::Shape::pulse:		renderVoices(mixBuffer, numSamples, OversampledVoices<PolyBlepOscillator::Shape::pulse>()); break;
+			case PolyBlepOscillator::Shape::triangle:	renderVoices(mixBuffer, numSamples, OversampledVoices<PolyBlepOscillator::Shape::triangle>()); break;
+			case PolyBlepOscillator::Shape::saw:
+			default:									renderVoices(mixBuffer, numSamples, OversampledVoices<PolyBlepOscillator::Shape::saw>()); break;
+		}
+	}
+	else
+	{
+		switch (sineMode)
+		{
+			case SineOscillator::Mode::quadrature:	renderVoices(mixBuffer, numSamples, SineVoices<SineOscillator::Mode::quadrature>()); break;
+			case SineOscillator::Mode::polynomial:	renderVoices(mixBuffer, numSamples, SineVoices<SineOscillator::Mode::polynomial>()); break;
+			case SineOscillator::Mode::libm:
+			default:								renderVoices(mixBuffer, numSamples, SineVoices<SineOscillator::Mode::libm>()); break;
+		}
+	}
+
+	freeFinishedVoices(numSamples);
+
+	//The other voices have no gain of their own, so a gain change ramps across this sub-block of the mix instead.
+	applyGain(mixBuffer, numSamples, level * previousGain, level * currentGain);
+	return numSamples;
+}
+
+void SynthEngine::renderVoices(float* mix, int numSamples, WavetableVoices) noexcept
+{
+	//The voice bank renders every wavetable voice, split across the worker threads when there are enough of them.
+	FloatVectorOperations::clear(mix, numSamples);
+	workerPool.renderBlock(voiceBank, mix, numSamples);
+}
+
+void SynthEngine::renderVoices(float* mix, int numSamples, PluckedStringVoices) noexcept
+{
+	//the strings decay towards zero through their feedback loops, which would otherwise end up in denormals
+	ScopedNoDenormals noDenormals;
+	FloatVectorOperations::clear(mix, numSamples);
+
+	for (auto voice = 0; voice < voicePool.getEndVoice(); ++voice)
+		if (voicePool.getState(voice) != VoicePool::State::free)
+			strings.getUnchecked(voice)->renderBlock(mix, numSamples, 1.0f);
+}
+
+void SynthEngine::renderVoices(float* mix, int numSamples, BankVoices) noexcept
+{
+	FloatVectorOperations::clear(mix, numSamples);
+
+	for (auto voice = 0; voice < voicePool.getEndVoice(); ++voice)
+	{
+		auto state = voicePool.getState(voice);
+		auto* oscillator = bankOscillators.getUnchecked(voice);
+
+		if (state == VoicePool::State::playing)
+			oscillator->renderBlock(mix, numSamples, 1.0f);
+		else if (state == VoicePool::State::releasing)
+			addReleasingVoice(voice, mix, numSamples, releaseStep, [oscillator, numSamples] (float* dest) { oscillator->renderBlock(dest, numSamples, 1.0f); });
+	}
+}
+
+template <PolyBlepOscillator::Shape kernel>
+void SynthEngine::renderVoices(float* mix, int numSamples, PolyBlepVoices<kernel>) noexcept
+{
+	FloatVectorOperations::clear(mix, numSamples);
+
+	for (auto voice = 0; voice < voicePool.getEndVoice(); ++voice)
+	{
+		auto state = voicePool.getState(voice);
+		auto* oscillator = blepOscillators.getUnchecked(voice);
+
+		if (state == VoicePool::State::playing)
+			oscillator->template renderBlock<kernel>(mix, numSamples, 1.0f);
+		else if (state == VoicePool::State::releasing)
+			addReleasingVoice(voice, mix, numSamples, releaseStep, [oscillator, numSamples] (float* dest) { oscillator->template renderBlock<kernel>(dest, numSamples, 1.0f); });
+	}
+}
+
+template <PolyBlepOscillator::Shape kernel>
+void SynthEngine::renderVoices(float* mix, int numSamples, OversampledVoices<kernel>) noexcept
+{
+	//Every voice draws the naive shape at the higher rate and adds into one buffer, so the decimator only runs
+	//once per block however many voices there are. At a factor of 1 they go straight into the mix, aliases and all.
+	auto numOversampled = numSamples * oversamplingFactor;
+	auto* dest = oversamplingFactor > 1 ? oversampledBuffer : mix;
+	FloatVectorOperations::clear(dest, numOversampled);
+
+	//the release ramp runs at the higher rate too, so it takes as long as at any other factor
+	for (auto voice = 0; voice < voicePool.getEndVoice(); ++voice)
+	{
+		auto state = voicePool.getState(voice);
+		auto* oscillator = blepOscillators.getUnchecked(voice);
+
+		if (state == VoicePool::State::playing)
+			oscillator->template renderBlock<kernel, false>(dest, numOversampled, 1.0f);
+		else if (state == VoicePool::State::releasing)
+			addReleasingVoice(voice, dest, numOversampled, releaseStep / (float)oversamplingFactor,
+							  [oscillator, numOversampled] (float* voiceDest) { oscillator->template renderBlock<kernel, false>(voiceDest, numOversampled, 1.0f); });
+	}
+
+	if (oversamplingFactor > 1)
+		decimator.process(dest, mix, numSamples);
+}
+
+template <SineOscillator::Mode kernel>
+void SynthEngine::renderVoices(float* mix, int numSamples, SineVoices<kernel>) noexcept
+{
+	FloatVectorOperations::clear(mix, numSamples);
+
+	//each voice that is playing adds its whole block, with the kernel fixed for all of them
+	for (auto voice = 0; voice < voicePool.getEndVoice(); ++voice)
+	{
+		auto state = voicePool.getState(voice);
+		auto* oscillator = oscillators.getUnchecked(voice);
+
+		if (state == VoicePool::State::playing)
+			oscillator->template renderBlock<kernel>(mix, numSamples, 1.0f);
+		else if (state == VoicePool::State::releasing)
+			addReleasingVoice(voice, mix, numSamples, releaseStep, [oscillator, numSamples] (float* dest) { oscillator->template renderBlock<kernel>(dest, numSamples, 1.0f); });
+	}
+}
+
+template <typename RenderFunction>
+void SynthEngine::addReleasingVoice(int voice, float* dest, int numSamples, float gainStep, RenderFunction&& render) noexcept
+{
+	//A released voice is rendered on its own, then added along its ramp. Only a handful are ever fading out
+	//at once, so the voices that are playing keep adding straight into the mix.
+	FloatVectorOperations::clear(voiceBuffer, numSamples);
+	render(voiceBuffer);
+
+	auto gain = releaseGains[voice];
+
+	for (auto sample = 0; sample < numSamples; ++sample)
+	{
+		dest[sample] += voiceBuffer[sample] * gain;
+		gain = jmax(0.0f, gain - gainStep);
+	}
+
+	releaseGains[voice] = gain;
+}
+
+void SynthEngine::setOscillatorFrequency(int voice, float frequency) noexcept
+{
+	if (usesBlepOscillators())
+		blepOscillators.getUnchecked(voice)->setFrequency(frequency, getVoiceSampleRate());
+	else if (voiceType == VoiceType::wavetableBank)
+		bankOscillators.getUnchecked(voice)->setFrequency(frequency, (float)currentSampleRate);
+	else
+		oscillators.getUnchecked(voice)->setFrequency(frequency, (float)currentSampleRate);
+}
+
+void SynthEngine::advanceGlides(int numSamples) noexcept
+{
+	//Exponential like the wavetable voices' ramps, so the pitch moves evenly. Each sub-block covers numSamples / remaining
+	//of what is left, and plays at the frequency it ends on; the last one lands on the target exactly.
+	hasActiveGlides = false;
+
+	for (auto voice = 0; voice < voicePool.getEndVoice(); ++voice)
+	{
+		auto remaining = glideSamplesRemaining[voice];
+
+		if (remaining <= 0)
+			continue;
+
+		auto frequency = glideTargets[voice];
+
+		if (remaining > numSamples)
+		{
+			frequency = glideFrequencies[voice] * std::pow(glideTargets[voice] / glideFrequencies[voice], (float)numSamples / (float)remaining);
+			hasActiveGlides = true;
+		}
+
+		glideFrequencies[voice] = frequency;
+		glideSamplesRemaining[voice] = remaining - numSamples;
+		setOscillatorFrequency(voice, frequency);
+	}
+}
+
+void SynthEngine::applyGain(float* mix, int numSamples, float startGain, float endGain) noexcept
+{
+	if (startGain == endGain)
+	{
+		FloatVectorOperations::multiply(mix, startGain, numSamples);
+		return;
+	}
+
+	auto gainStep = (endGain - startGain) / numSamples;
+
+	for (auto sample = 0; sample < numSamples; ++sample)
+		mix[sample] *= startGain + gainStep * sample;
+}
+
+void SynthEngine::copyToOutput(const float* mix, const AudioSourceChannelInfo& bufferToFill, int offset, int numSamples) noexcept
+{
+	//the gain is already in the mix, so every output channel is a plain copy of it
+	for (auto channel = 0; channel < jmin(2, bufferToFill.buffer->getNumChannels()); ++channel)
+		FloatVectorOperations::copy(bufferToFill.buffer->getWritePointer(channel, bufferToFill.startSample + offset), mix, numSamples);
+}
+
+void SynthEngine::processParameterEvents()
+{
+	//Runs on the audio thread at the start of every sub-block. The queue never blocks, and the voice bank glides
+	//to the new values instead of jumping, which would be audible as zipper noise.
+	ParameterEvent event;
+
+	while (parameterQueue.pop(event))
+		applyParameterEvent(event);
+}
+
+void SynthEngine::applyParameterEvent(const ParameterEvent& event)
+{
+	auto rampLengthSamples = roundToInt(parameterRampSeconds * currentSampleRate);
+
+	if (eventRecorder.isEnabled())
+	{
+		EventLogRecord record;
+		record.kind = EventLogRecord::Kind::parameter;
+		record.event = event;
+		record.sampleOffset = subBlockOffset;
+		eventRecorder.add(record);
+	}
+
+	switch (event.type)
+	{
+		case ParameterEvent::Type::frequency:
+			//every sounding voice glides to the new frequency, and keeps it if the device restarts
+			for (auto voice = 0; voice < voicePool.getEndVoice(); ++voice)
+			{
+				if (voicePool.getState(voice) == VoicePool::State::free)
+					continue;
+
+				//a glide already under way carries on from wherever it has got to
+				auto glideStart = glideSamplesRemaining[voice] > 0 ? glideFrequencies[voice] : voicePool.getFrequency(voice);
+				voicePool.setFrequency(voice, event.value);
+
+				//a string has no glide, its loop just changes length
+				if (voiceType == VoiceType::wavetable)
+				{
+					voiceBank.rampFrequency(voice, event.value, (float)currentSampleRate, rampLengthSamples);
+				}
+				else if (voiceType == VoiceType::pluckedString)
+				{
+					strings.getUnchecked(voice)->setFrequency(event.value, (float)currentSampleRate);
+				}
+				else if (rampLengthSamples > 0 && glideStart > 0.0f)
+				{
+					glideFrequencies[voice] = glideStart;
+					glideTargets[voice] = event.value;
+					glideSamplesRemaining[voice] = rampLengthSamples;
+					hasActiveGlides = true;
+				}
+				else
+				{
+					setOscillatorFrequency(voice, event.value);
+				}
+			}
+			break;
+
+		case ParameterEvent::Type::gain:
+			currentGain = event.value;
+
+			//voices in their release keep fading to zero
+			if (voiceType == VoiceType::wavetable)
+				for (auto voice = 0; voice < voicePool.getEndVoice(); ++voice)
+					if (voicePool.getState(voice) == VoicePool::State::playing)
+						voiceBank.rampGain(voice, voicePool.getVelocity(voice) * currentGain, rampLengthSamples);
+			break;
+
+		case ParameterEvent::Type::noteOn:
+			handleNoteOn(event.noteNumber, event.value, event.velocity);
+			break;
+
+		case ParameterEvent::Type::noteOff:
+			handleNoteOff(event.noteNumber);
+			break;
+
+		case ParameterEvent::Type::stealingPolicy:
+			voicePool.setStealingPolicy((VoicePool::StealingPolicy)(int)event.value);
+			break;
+
+		case ParameterEvent::Type::sineMode:
+			sineMode = (SineOscillator::Mode)(int)event.value;
+
+			for (auto* oscillator : oscillators)
+				oscillator->setMode(sineMode);
+			break;
+
+		case ParameterEvent::Type::blepShape:
+			//the voices carry on at the same phase, only the waveform they draw changes
+			blepShape = (PolyBlepOscillator::Shape)(int)event.value;
+
+			for (auto* oscillator : blepOscillators)
+				oscillator->setShape(blepShape);
+			break;
+
+		case ParameterEvent::Type::pulseWidth:
+			//notes started later begin at this width straight away
+			pulseWidth = event.value;
+
+			for (auto* oscillator : blepOscillators)
+				oscillator->setPulseWidth(pulseWidth);
+			break;
+
+		case ParameterEvent::Type::oversampling:
+			if (voiceType != VoiceType::oversampled)
+				break;
+
+			//the phases are in cycles, so the voices only need their increments scaled to the new rate
+			oversamplingFactor = (int)event.value;
+			decimator.setFactor(oversamplingFactor);
+
+			for (auto voice = 0; voice < voicePool.getEndVoice(); ++voice)
+				if (voicePool.getState(voice) != VoicePool::State::free)
+					setOscillatorFrequency(voice, glideSamplesRemaining[voice] > 0 ? glideFrequencies[voice] : voicePool.getFrequency(voice));
+			break;
+
+		case ParameterEvent::Type::bankPosition:
+			//notes started later begin at this position straight away
+			bankPosition = event.value;
+
+			for (auto* oscillator : bankOscillators)
+				oscillator->setPosition(bankPosition);
+			break;
+
+		case ParameterEvent::Type::interpolation:
+			//only how the tables are read changes, so the voices carry on without a click
+			interpolation = (TableInterpolation::Mode)(int)event.value;
+			voiceBank.setInterpolation(interpolation);
+			break;
+
+		case ParameterEvent::Type::subBlockSize:
+			//the sub-block being started already has the new size; what was carried over still goes out as it was
+			if (isValidSubBlockSize((int)event.value))
+				subBlockSize = (int)event.value;
+			break;
+
+		default:
+			break;
+	}
+}
+
+void SynthEngine::handleNoteOn(int noteNumber, float frequency, float velocity)
+{
+	//for the quietest policy, the bank's current gains say how loud each wavetable voice is right now
+	auto isWavetable = voiceType == VoiceType::wavetable;
+	auto voice = voicePool.startNote(noteNumber, frequency, velocity, isWavetable ? voiceBank.getGains() : nullptr);
+
+	//a stolen voice doesn't finish the glide it was on
+	glideSamplesRemaining[voice] = 0;
+
+	if (isWavetable)
+	{
+		//A stolen voice is cut and restarted at zero gain, then faded in like any other note.
+		voiceBank.startVoice(voice, frequency, (float)currentSampleRate, 0.0f);
+		voiceBank.rampGain(voice, velocity * currentGain, roundToInt(attackSeconds * currentSampleRate));
+	}
+	else if (voiceType == VoiceType::pluckedString)
+	{
+		//the velocity sets how hard the string is plucked
+		auto* string = strings.getUnchecked(voice);
+		string->setFrequency(frequency, (float)currentSampleRate);
+		string->pluck(velocity, random);
+	}
+	else if (usesBlepOscillators())
+	{
+		//like the sines, they have no gain of their own; the width is already where the other voices are heading
+		releaseGains[voice] = 1.0f;
+		auto* oscillator = blepOscillators.getUnchecked(voice);
+		oscillator->setPulseWidth(pulseWidth);
+		oscillator->reset();
+		oscillator->setFrequency(frequency, getVoiceSampleRate());
+	}
+	else if (voiceType == VoiceType::wavetableBank)
+	{
+		//no gain of their own either; the position is already where the other voices are heading
+		releaseGains[voice] = 1.0f;
+		auto* oscillator = bankOscillators.getUnchecked(voice);
+		oscillator->setPosition(bankPosition);
+		oscillator->reset();
+		oscillator->setFrequency(frequency, (float)currentSampleRate);
+	}
+	else
+	{
+		//the sine voices have no gain of their own, so they simply start
+		releaseGains[voice] = 1.0f;
+		oscillators.getUnchecked(voice)->reset();
+		oscillators.getUnchecked(voice)->setFrequency(frequency, (float)currentSampleRate);
+	}
+}
+
+void SynthEngine::handleNoteOff(int noteNumber)
+{
+	auto releaseSamples = roundToInt(releaseSeconds * currentSampleRate);
+
+	for (auto voice = 0; voice < voicePool.getEndVoice(); ++voice)
+	{
+		if (voicePool.getState(voice) != VoicePool::State::playing || voicePool.getNoteNumber(voice) != noteNumber)
+			continue;
+
+		//the voice stays in the pool until freeFinishedVoices() sees it die away
+		if (voiceType == VoiceType::wavetable)
+		{
+			voicePool.releaseVoice(voice);
+			voiceBank.rampGain(voice, 0.0f, releaseSamples);
+		}
+		else if (voiceType == VoiceType::pluckedString)
+		{
+			voicePool.releaseVoice(voice);
+			strings.getUnchecked(voice)->release();
+		}
+		else
+		{
+			//the others have no gain of their own, so the engine fades them out along releaseGains
+			voicePool.releaseVoice(voice);
+		}
+	}
+}
+
+void SynthEngine::handleMidiMessage(const MidiMessage& message)
+{
+	//the notes go the same way as the queued ones, so they end up in the event log too
+	if (message.isNoteOn())
+	{
+		ParameterEvent event { ParameterEvent::Type::noteOn, (float)MidiMessage::getMidiNoteInHertz(message.getNoteNumber()) };
+		event.noteNumber = message.getNoteNumber();
+		event.velocity = message.getFloatVelocity();
+		applyParameterEvent(event);
+	}
+	else if (message.isNoteOff())
+	{
+		ParameterEvent event { ParameterEvent::Type::noteOff, 0.0f };
+		event.noteNumber = message.getNoteNumber();
+		applyParameterEvent(event);
+	}
+	else if (message.isAllNotesOff() || message.isAllSoundOff())
+	{
+		for (auto noteNumber = 0; noteNumber < 128; ++noteNumber)
+		{
+			ParameterEvent event { ParameterEvent::Type::noteOff, 0.0f };
+			event.noteNumber = noteNumber;
+			applyParameterEvent(event);
+		}
+	}
+}
+
+void SynthEngine::recordWavetableSet(const WavetableSet* set) noexcept
+{
+	if (set == nullptr || ! eventRecorder.isEnabled())
+		return;
+
+	EventLogRecord record;
+	record.kind = EventLogRecord::Kind::wavetable;
+	record.shape = (int)set->getShape();
+	record.tableSize = set->getTableSize();
+	record.sampleOffset = subBlockOffset;
+	eventRecorder.add(record);
+}
+
+void SynthEngine::freeFinishedVoices(int numSamplesRendered)
+{
+	//Counted in rendered samples rather than callbacks, so the voices are freed at the same points of the sound
+	//however the device cuts it up, and the strings' peaks always cover the whole interval.
+	samplesSinceFreed += numSamplesRendered;
+
+	if (samplesSinceFreed < freeVoicesInterval)
+		return;
+
+	samplesSinceFreed = 0;
+
+	if (voiceType == VoiceType::pluckedString)
+	{
+		//A string dies away on its own, so it goes back to the pool once it's inaudible, whether the note is still held or not.
+		for (auto voice = 0; voice < voicePool.getEndVoice(); ++voice)
+			if (voicePool.getState(voice) != VoicePool::State::free && strings.getUnchecked(voice)->takePeak() < silenceThreshold)
+				voicePool.free(voice);
+
+		return;
+	}
+
+	if (voiceType != VoiceType::wavetable)
+	{
+		//the release ramps are clamped at zero, so a voice that got there is silent for good
+		if (voicePool.getNumReleasing() > 0)
+			for (auto voice = 0; voice < voicePool.getEndVoice(); ++voice)
+				if (voicePool.getState(voice) == VoicePool::State::releasing && releaseGains[voice] == 0.0f)
+					voicePool.free(voice);
+
+		return;
+	}
+
+	if (voicePool.getNumReleasing() > 0)
+	{
+		for (auto voice = 0; voice < voicePool.getEndVoice(); ++voice)
+		{
+			//a finished ramp lands exactly on its target, so zero here means fully faded out
+			if (voicePool.getState(voice) == VoicePool::State::releasing
+				&& ! voiceBank.isRamping(voice) && voiceBank.getGain(voice) == 0.0f)
+				voicePool.free(voice);
+		}
+	}
+
+	//freed voices sit at zero gain, so the bank can stop rendering everything above the highest one still in use
+	voiceBank.setNumVoices(voicePool.getEndVoice());
+}
+
+void SynthEngine::releaseResources()
+{
+}
+
+void SynthEngine::selectFastestKernel(int blockSize, double sampleRate)
+{
+	//enough voices to fill every vector lane several times over, rendered for one block of the device
+	const int numScratchVoices = 64;
+	auto numSamples = jmax(32, blockSize);
+	HeapBlock<float> scratch((size_t)numSamples, true);
+
+	if (voiceType == VoiceType::wavetable)
+	{
+		auto set = wavetableCache->getSet(shape, tableSize);
+		VoiceBank bank;
+		bank.setCapacity(numScratchVoices);
+		bank.setWavetableSet(set.get());
+		bank.setInterpolation(interpolation);
+
+		for (auto i = 0; i < numScratchVoices; ++i)
+			bank.addVoice(110.0f * (1.0f + (float)i / 8.0f), (float)sampleRate, 0.0f);
+
+		KernelDispatch::selectFastestLevel([&] { bank.renderBlock(scratch, numSamples); });
+	}
+	else if (voiceType == VoiceType::sine && sineMode != SineOscillator::Mode::libm)
+	{
+		OwnedArray<SineOscillator> scratchOscillators;
+
+		for (auto i = 0; i < numScratchVoices; ++i)
+		{
+			auto* oscillator = scratchOscillators.add(new SineOscillator());
+			oscillator->setMode(sineMode);
+			oscillator->setFrequency(110.0f * (1.0f + (float)i / 8.0f), (float)sampleRate);
+		}
+
+		KernelDispatch::selectFastestLevel([&]
+		{
+			for (auto* oscillator : scratchOscillators)
+				oscillator->renderBlock(scratch, numSamples, 0.0f);
+		});
+	}
+	else if (voiceType == VoiceType::polyBlep)
+	{
+		OwnedArray<PolyBlepOscillator> scratchOscillators;
+
+		for (auto i = 0; i < numScratchVoices; ++i)
+		{
+			auto* oscillator = scratchOscillators.add(new PolyBlepOscillator());
+			oscillator->setShape(blepShape);
+			oscillator->setFrequency(110.0f * (1.0f + (float)i / 8.0f), (float)sampleRate);
+		}
+
+		KernelDispatch::selectFastestLevel([&]
+		{
+			for (auto* oscillator : scratchOscillators)
+				oscillator->renderBlock(scratch, numSamples, 0.0f);
+		});
+	}
+	else if (voiceType == VoiceType::oversampled && oversamplingFactor > 1)
+	{
+		//naive saws at the current factor, then the decimator, which is where most of the time goes at the higher factors
+		auto numOversampled = numSamples * oversamplingFactor;
+		HeapBlock<float> oversampled((size_t)numOversampled, true);
+		HalfbandDecimator scratchDecimator;
+		scratchDecimator.prepare(numSamples);
+		scratchDecimator.setFactor(oversamplingFactor);
+		OwnedArray<PolyBlepOscillator> scratchOscillators;
+
+		for (auto i = 0; i < numScratchVoices; ++i)
+			scratchOscillators.add(new PolyBlepOscillator())->setFrequency(110.0f * (1.0f + (float)i / 8.0f), (float)sampleRate * oversamplingFactor);
+
+		KernelDispatch::selectFastestLevel([&]
+		{
+			for (auto* oscillator : scratchOscillators)
+				oscillator->renderBlock<PolyBlepOscillator::Shape::saw, false>(oversampled, numOversampled, 0.0f);
+
+			scratchDecimator.process(oversampled, scratch, numSamples);
+		});
+	}
+
+	else if (voiceType == VoiceType::wavetableBank)
+	{
+		//only once a bank is loaded; scratch voices spread over the frames, so the gathers hit more than one pair
+		if (auto* currentBank = bankPublisher.acquire())
+		{
+			OwnedArray<WavetableBankOscillator> scratchOscillators;
+
+			for (auto i = 0; i < numScratchVoices; ++i)
+			{
+				auto* oscillator = scratchOscillators.add(new WavetableBankOscillator());
+				oscillator->setBank(currentBank);
+				oscillator->setPosition((float)i / (float)(numScratchVoices - 1));
+				oscillator->reset();
+				oscillator->setFrequency(110.0f * (1.0f + (float)i / 8.0f), (float)sampleRate);
+			}
+
+			KernelDispatch::selectFastestLevel([&]
+			{
+				for (auto* oscillator : scratchOscillators)
+					oscillator->renderBlock(scratch, numSamples, 0.0f);
+			});
+		}
+	}
+
+	//the plucked strings and the libm sines have no SIMD kernel, so there is nothing to choose between for them
+}
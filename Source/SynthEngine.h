@@ -0,0 +1,300 @@
+/*
+  ==============================================================================
+
+    SynthEngine.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "Oscillators.h"
+#include "VoiceBank.h"
+#include "WavetableSet.h"
+#include "WavetablePublisher.h"
+#include "WavetableCache.h"
+#include "WavetableBank.h"
+#include "ParameterQueue.h"
+#include "RenderWorkerPool.h"
+#include "VoicePool.h"
+#include "BlockTimingMonitor.h"
+#include "PluckedStringVoice.h"
+#include "PolyBlepOscillator.h"
+#include "HalfbandDecimator.h"
+#include "KernelDispatch.h"
+#include "EventLog.h"
+
+//The oscillators, their wavetables and the parameter plumbing, without any GUI or audio device attached.
+//MainComponent plays it through the sound card, the offline renderer pulls blocks from it as fast as it can.
+//
+//All voices are allocated once in the constructor: numVoices is the polyphony, and notes beyond it steal a voice.
+//prepareToPlay() only resets their state, so a device restart never allocates on the audio thread.
+//
+//setFrequency(), setGain(), startNote(), stopNote(), setStealingPolicy(), setSineMode(), setWaveform(), setPulseWidth(),
+//setOversamplingFactor(), setTableSize(), setInterpolation(), setSubBlockSize(), loadWavetableBank(), setBankPosition(),
+//replayRecord() and collectGarbage() are called from the message thread, the AudioSource callbacks and processBlock() from
+//the audio thread.
+//
+//Whatever length and offset the device's blocks have, the voices render in sub-blocks of a fixed size into an aligned
+//mix buffer. A callback that ends inside a sub-block leaves the rest of it for the next callback, so every sub-block
+//costs the same, the vector loops never see a tail, and parameter changes land on a sub-block boundary at a steady rate.
+class SynthEngine   : public AudioSource
+{
+	public:
+		enum class VoiceType
+		{
+			sine,
+			wavetable,
+			pluckedString,
+			polyBlep,
+			oversampled,	//the PolyBLEP shapes drawn naively at a multiple of the device rate, then decimated
+			wavetableBank	//the frames of a memory-mapped WavetableBank, morphed with setBankPosition()
+		};
+
+		//numWorkerThreads helps the audio thread render the wavetable voices; -1 picks a count to suit the voices and cores
+		SynthEngine(int numVoices, VoiceType voiceType, int numWorkerThreads = -1);
+		~SynthEngine();
+
+		//==============================================================================
+		void prepareToPlay (int samplesPerBlockExpected, double sampleRate) override;
+		void getNextAudioBlock (const AudioSourceChannelInfo& bufferToFill) override;
+		void releaseResources() override;
+
+		//Renders the block like getNextAudioBlock(), starting and stopping the notes in midiMessages at their sample
+		//positions along the way. For hosts that deliver the notes with the audio, like the plugin's processBlock();
+		//these notes are handled on the audio thread directly, so don't also start notes with startNote() then.
+		void processBlock(AudioBuffer<float>& buffer, const MidiBuffer& midiMessages);
+
+		//==============================================================================
+		//queue a new frequency (in Hz) or gain for every voice; applied with a short ramp at the start of the next block
+		void setFrequency(float frequency);
+		void setGain(float gain);
+
+		//Starts one voice for the note; starting the same note number again stacks another voice on it.
+		//stopNote() releases every voice playing that note number. Notes still held when the device restarts keep playing.
+		//The queue keeps space for notes that other parameter changes can't take, but a stalled audio thread can still
+		//fill it with notes; both return false then and the note is dropped, so call them again later.
+		bool startNote(int noteNumber, float frequency, float velocity);
+		bool stopNote(int noteNumber);
+		void setStealingPolicy(VoicePool::StealingPolicy policy);
+
+		//which kernel the sine voices use when the engine isn't using wavetables; polynomial by default
+		void setSineMode(SineOscillator::Mode mode);
+
+		//Hands the set for the shape to the audio thread; it comes from the WavetableCache, so this is normally just a lookup.
+		//The PolyBLEP voices play the saw, square and triangle directly, and keep their shape for the others.
+		void setWaveform(WavetableSet::Shape shape);
+
+		//width of the PolyBLEP pulse, or the rising share of its triangle; glides there over the next block
+		void setPulseWidth(float width);
+
+		//How many times the device rate the oversampled voices render at: 1, 2, 4 or 8, 4 by default.
+		//Switching doesn't allocate; the voices carry on at the same phase, but the decimator starts again from silence.
+		void setOversamplingFactor(int factor);
+
+		//Maps the bank in the file, or finds it already mapped in the WavetableCache, and hands it to the wavetable bank
+		//voices, which carry on at the same phase and position. Only the header is read here, and the frames around the
+		//current position; the rest is paged in as it's played. Returns false with errorMessage set if it can't be played.
+		bool loadWavetableBank(const File& file, String& errorMessage, int defaultFrameSize = 2048);
+		WavetableBank::Ptr getWavetableBank() const noexcept	{ return bank; }
+
+		//Where the wavetable bank voices play, from 0 (the first frame) to 1 (the last); they glide there over the
+		//next block. The frames around it are paged in here, so the audio thread doesn't have to wait for the disk.
+		void setBankPosition(float position);
+
+		//Switches the current waveform to another resolution, any power of two from 16 up; notes carry on at the same phase.
+		//The first switch to a new size builds that set here and starts building the other shapes in the background.
+		//Smaller tables trade a little interpolation noise for less cache, larger ones the other way round.
+		void setTableSize(int newTableSize);
+		int getTableSize() const noexcept			{ return tableSize; }
+
+		//How many samples the voices render at a time: 16, 32 (the default) or 64, or 0 to render whatever the device asks for
+		//in one go, as the engine used to. Smaller sub-blocks apply parameter changes and notes closer to when they came in,
+		//larger ones spend less per sample on the work around the voices. Switching takes effect at the next sub-block.
+		void setSubBlockSize(int numSamples);
+		static bool isValidSubBlockSize(int numSamples) noexcept	{ return numSamples == 0 || numSamples == 16 || numSamples == 32 || numSamples == maxSubBlockSize; }
+		static constexpr int maxSubBlockSize = 64;
+
+		//How the wavetable voices read between table samples, linear by default. Hermite or Lagrange let a small
+		//table sound like a large one, so together with setTableSize() this trades arithmetic for cache.
+		void setInterpolation(TableInterpolation::Mode mode);
+
+		//releases the wavetable sets the audio thread has stopped using; call regularly from the message thread
+		void collectGarbage();
+
+		int getNumVoices() const noexcept			{ return numVoices; }
+		VoiceType getVoiceType() const noexcept		{ return voiceType; }
+		int getNumWorkerThreads() const noexcept	{ return workerPool.getNumWorkers(); }
+
+		//every getNextAudioBlock() call leaves a timing record here; drain it regularly from the message thread
+		BlockTimingMonitor& getTimingMonitor() noexcept	{ return timingMonitor; }
+
+		//The seed of the noise that plucks the strings. prepareToPlay() starts the noise again from it, so the same notes
+		//pluck the same strings every time. Each engine picks its own seed unless told otherwise; call before the device starts.
+		void setRandomSeed(int64 seed) noexcept		{ randomSeed = seed; }
+		int64 getRandomSeed() const noexcept		{ return randomSeed; }
+
+		//While enabled, the audio thread logs every block, parameter change, note and wavetable switch it applies here;
+		//drain it into an EventLogWriter from the message thread. The header describes this engine for the log.
+		EventRecorder& getEventRecorder() noexcept	{ return eventRecorder; }
+		EventLogHeader createEventLogHeader() const;
+
+		//Queues a parameter or wavetable record read back from an event log, so the next block or prepareToPlay() applies
+		//it just as the recording engine did. Returns false if the parameter queue is full.
+		bool replayRecord(const EventLogRecord& record);
+
+		//When enabled, prepareToPlay() times the kernels of this engine's voices at every level the CPU supports and
+		//switches KernelDispatch to the fastest. It costs a few milliseconds and a scratch allocation per device start.
+		//Off by default, which keeps the level picked from cpuid; call before the device starts.
+		void setKernelSelfBenchmark(bool shouldRun) noexcept	{ runKernelSelfBenchmark = shouldRun; }
+
+	private:
+		//the body of getNextAudioBlock(), which times it: hands out what is left of the last sub-block, then renders new ones
+		void renderNextBlock(const AudioSourceChannelInfo& bufferToFill);
+
+		//Applies the queued parameter changes, then renders the next sub-block into mixBuffer with the gain applied.
+		//Returns its length: subBlockSize, or up to numSamplesWanted when the engine follows the device's blocks.
+		int renderSubBlock(int numSamplesWanted);
+
+		//Tags for the kinds of voice. renderSubBlock() picks one per sub-block, and renderVoices() is compiled separately
+		//for each, so nothing inside the voice and sample loops has to test which kind it is rendering.
+		struct WavetableVoices {};
+		struct PluckedStringVoices {};
+		struct BankVoices {};
+		template <PolyBlepOscillator::Shape kernel> struct PolyBlepVoices {};
+		template <PolyBlepOscillator::Shape kernel> struct OversampledVoices {};
+		template <SineOscillator::Mode kernel> struct SineVoices {};
+
+		//each overwrites mix with the sum of the voices
+		void renderVoices(float* mix, int numSamples, WavetableVoices) noexcept;
+		void renderVoices(float* mix, int numSamples, PluckedStringVoices) noexcept;
+		void renderVoices(float* mix, int numSamples, BankVoices) noexcept;
+		template <PolyBlepOscillator::Shape kernel>
+		void renderVoices(float* mix, int numSamples, PolyBlepVoices<kernel>) noexcept;
+		template <PolyBlepOscillator::Shape kernel>
+		void renderVoices(float* mix, int numSamples, OversampledVoices<kernel>) noexcept;
+		template <SineOscillator::Mode kernel>
+		void renderVoices(float* mix, int numSamples, SineVoices<kernel>) noexcept;
+
+		//render() adds the released voice to the buffer it is given; this adds that to dest along the voice's release ramp
+		template <typename RenderFunction>
+		void addReleasingVoice(int voice, float* dest, int numSamples, float gainStep, RenderFunction&& render) noexcept;
+
+		//scales mix in place, ramping from startGain to endGain across it
+		static void applyGain(float* mix, int numSamples, float startGain, float endGain) noexcept;
+
+		//copies mixed samples to the first two channels of the output, or to the only one
+		static void copyToOutput(const float* mix, const AudioSourceChannelInfo& bufferToFill, int offset, int numSamples) noexcept;
+
+		//drains parameterQueue on the audio thread, at the start of every sub-block
+		void processParameterEvents();
+
+		//applies one event, from the queue or from the MIDI in processBlock(), and logs it if the recorder is enabled
+		void applyParameterEvent(const ParameterEvent& event);
+
+		//logs the set the wavetable voices switched to, if the recorder is enabled
+		void recordWavetableSet(const WavetableSet* set) noexcept;
+
+		//audio thread side of startNote() and stopNote(), and of the notes that come in through processBlock()
+		void handleNoteOn(int noteNumber, float frequency, float velocity);
+		void handleNoteOff(int noteNumber);
+		void handleMidiMessage(const MidiMessage& message);
+
+		//hands voices that have died away back to the pool, and trims the range the bank renders, every few hundred rendered samples
+		void freeFinishedVoices(int numSamplesRendered);
+
+		//the self-benchmark behind setKernelSelfBenchmark(), rendering scratch voices of the engine's kind
+		void selectFastestKernel(int blockSize, double sampleRate);
+
+		//points the oscillator of a sine, PolyBLEP, oversampled or bank voice at a frequency, keeping its phase
+		void setOscillatorFrequency(int voice, float frequency) noexcept;
+
+		//moves the gliding voices among those one sub-block of numSamples closer to their new frequency
+		void advanceGlides(int numSamples) noexcept;
+
+		//the PolyBLEP and the oversampled voices are both PolyBlepOscillators, the latter running at a higher rate
+		bool usesBlepOscillators() const noexcept	{ return voiceType == VoiceType::polyBlep || voiceType == VoiceType::oversampled; }
+		float getVoiceSampleRate() const noexcept	{ return (float)(currentSampleRate * oversamplingFactor); }
+
+		//==============================================================================
+		const int numVoices;
+		const VoiceType voiceType;
+
+		//SinOsc std::sin variables
+		double currentSampleRate = 0.0;
+		float level = 0.0f;
+
+		//parameter changes travel from the GUI to the audio thread through the queue;
+		//the current values below are only ever touched by the audio thread once it is running
+		ParameterQueue parameterQueue;
+		float currentGain = 1.0f;
+		SineOscillator::Mode sineMode = SineOscillator::Mode::polynomial;
+		PolyBlepOscillator::Shape blepShape = PolyBlepOscillator::Shape::saw;
+		float pulseWidth = 0.5f;
+		int oversamplingFactor = 1;
+		float bankPosition = 0.0f;
+		TableInterpolation::Mode interpolation = TableInterpolation::Mode::linear;
+		bool runKernelSelfBenchmark = false;
+
+		//Every voice adds into this mono buffer, which starts on a cache line so each sub-block does. Between callbacks it
+		//holds the end of the last sub-block, carriedSamples from carriedStart, which the device hasn't had yet.
+		HeapBlock<float> mixStorage;
+		float* mixBuffer = nullptr;
+		int mixBufferSize = 0;
+		int subBlockSize = 32;
+		int carriedStart = 0, carriedSamples = 0;
+		int samplesSinceFreed = 0;
+
+		//Where in the device's block the sub-block being rendered starts. The events and wavetable switches it picks up
+		//are logged at this offset, so a replay hands them over at the same sub-block; outside a callback it is 0.
+		int subBlockOffset = 0;
+
+		//the oversampled voices add into this one instead, at oversamplingFactor times the length, and the decimator
+		//takes it down into mixBuffer; it is sized for the highest factor, so switching never allocates
+		HeapBlock<float> oversampledStorage;
+		float* oversampledBuffer = nullptr;
+
+		//The sine, PolyBLEP, oversampled and wavetable bank voices have no gain of their own, so a released one fades
+		//out along its releaseGains entry, stepping down by releaseStep per sample, rendered on its own into voiceBuffer.
+		HeapBlock<float> releaseGains;
+		float releaseStep = 0.0f;
+
+		//Nor do they have a frequency ramp, so they glide in steps, one per sub-block like the gain: the frequency
+		//each is at and heading for, and the samples of the glide it has left.
+		HeapBlock<float> glideFrequencies, glideTargets;
+		HeapBlock<int> glideSamplesRemaining;
+		bool hasActiveGlides = false;
+		HeapBlock<float> voiceStorage;
+		float* voiceBuffer = nullptr;
+		HalfbandDecimator decimator;
+
+		//the slot indices of voicePool are the indices into oscillators, blepOscillators, bankOscillators, strings and voiceBank
+		VoicePool voicePool;
+		OwnedArray<SineOscillator> oscillators;
+		OwnedArray<PolyBlepOscillator> blepOscillators;
+		OwnedArray<WavetableBankOscillator> bankOscillators;
+		OwnedArray<PluckedStringVoice> strings;
+		DelayLineArena delayLines;
+		Random random;	//the noise that plucks the strings, only used on the audio thread
+		int64 randomSeed;
+		VoiceBank voiceBank;
+		RenderWorkerPool workerPool;
+
+		//wavetable variables
+		//sets are built on the message thread and swapped in by the audio thread at the start of a block
+		WavetablePublisher<WavetableSet> wavetablePublisher;
+		SharedResourcePointer<WavetableCache> wavetableCache;	//every engine in the process shares the same sets
+		WavetableSet::Shape shape = WavetableSet::Shape::sine;	//message thread only, like tableSize
+		int tableSize = 1 << 11; //resolution of 2048 for the fullest level, enough for the lowest notes
+
+		//the wavetable bank travels to the audio thread the same way; bank and requestedBankPosition are message thread only
+		WavetablePublisher<WavetableBank> bankPublisher;
+		WavetableBank::Ptr bank;
+		float requestedBankPosition = 0.0f;
+
+		BlockTimingMonitor timingMonitor;
+		EventRecorder eventRecorder;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SynthEngine)
+};
@@ -0,0 +1,152 @@
+/*
+  ==============================================================================
+
+    SynthProcessor.cpp
+
+  ==============================================================================
+*/
+
+#include "SynthProcessor.h"
+
+//the choices of the parameters, in the order of WavetableSet::Shape and TableInterpolation::Mode
+static const char* const waveformNames[] = { "Sine", "Triangle", "Harmonics", "Saw", "Square", "Noise" };
+static const char* const interpolationNames[] = { "Truncate", "Linear", "Hermite", "Lagrange" };
+static const int tableSizes[] = { 128, 256, 512, 1024, 2048, 4096 };
+
+//how often the message thread looks for parameter changes; automation reaches the engine within about this long
+static const int parameterPollHz = 50;
+
+static StringArray toStringArray(const char* const* names, int numNames)
+{
+	StringArray array;
+
+	for (auto i = 0; i < numNames; ++i)
+		array.add(names[i]);
+
+	return array;
+}
+
+//==============================================================================
+//The instances of a plugin all run on the host's audio threads, which the host already spreads across the cores,
+//so the engine renders on the calling thread instead of starting worker threads of its own in every instance.
+SynthProcessor::SynthProcessor()
+	: AudioProcessor(BusesProperties().withOutput("Output", AudioChannelSet::stereo(), true)),
+	engine(numVoices, SynthEngine::VoiceType::wavetable, 0)
+{
+	StringArray sizeNames;
+
+	for (auto size : tableSizes)
+		sizeNames.add(String(size));
+
+	addParameter(waveform = new AudioParameterChoice("waveform", "Waveform", toStringArray(waveformNames, numElementsInArray(waveformNames)),
+													 (int)WavetableSet::Shape::saw));
+	addParameter(tableSize = new AudioParameterChoice("tableSize", "Table size", sizeNames, 4));
+	addParameter(interpolation = new AudioParameterChoice("interpolation", "Interpolation", toStringArray(interpolationNames, numElementsInArray(interpolationNames)),
+														  (int)TableInterpolation::Mode::linear));
+	addParameter(gain = new AudioParameterFloat("gain", "Gain", 0.0f, 1.0f, 1.0f));
+
+	//the sets come out of the process-wide cache, so for every instance after the first this is only a lookup
+	applyParameters();
+	startTimerHz(parameterPollHz);
+}
+
+SynthProcessor::~SynthProcessor()
+{
+	stopTimer();
+}
+
+//==============================================================================
+void SynthProcessor::prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock)
+{
+	engine.prepareToPlay(maximumExpectedSamplesPerBlock, sampleRate);
+}
+
+void SynthProcessor::releaseResources()
+{
+	engine.releaseResources();
+}
+
+bool SynthProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
+{
+	//an instrument: no input, and the engine fills one or two output channels
+	auto output = layouts.getMainOutputChannelSet();
+	return layouts.getMainInputChannelSet().isDisabled() && (output == AudioChannelSet::mono() || output == AudioChannelSet::stereo());
+}
+
+void SynthProcessor::processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiMessages)
+{
+	ScopedNoDenormals noDenormals;
+	engine.processBlock(buffer, midiMessages);
+}
+
+//==============================================================================
+AudioProcessorEditor* SynthProcessor::createEditor()
+{
+	return new GenericAudioProcessorEditor(this);
+}
+
+void SynthProcessor::getStateInformation(MemoryBlock& destData)
+{
+	XmlElement state("AudioAppState");
+	state.setAttribute("waveform", waveform->getIndex());
+	state.setAttribute("tableSize", tableSize->getIndex());
+	state.setAttribute("interpolation", interpolation->getIndex());
+	state.setAttribute("gain", (double)gain->get());
+	copyXmlToBinary(state, destData);
+}
+
+void SynthProcessor::setStateInformation(const void* data, int sizeInBytes)
+{
+	std::unique_ptr<XmlElement> state(getXmlFromBinary(data, sizeInBytes));
+
+	if (state == nullptr || ! state->hasTagName("AudioAppState"))
+		return;
+
+	//the timer passes the new values on to the engine
+	*waveform = state->getIntAttribute("waveform", waveform->getIndex());
+	*tableSize = state->getIntAttribute("tableSize", tableSize->getIndex());
+	*interpolation = state->getIntAttribute("interpolation", interpolation->getIndex());
+	*gain = (float)state->getDoubleAttribute("gain", gain->get());
+}
+
+//==============================================================================
+void SynthProcessor::timerCallback()
+{
+	applyParameters();
+	engine.collectGarbage();
+}
+
+void SynthProcessor::applyParameters()
+{
+	//the table size goes first, so a new waveform is looked up at the new size straight away
+	if (tableSize->getIndex() != appliedTableSize)
+	{
+		appliedTableSize = tableSize->getIndex();
+		engine.setTableSize(tableSizes[jlimit(0, numElementsInArray(tableSizes) - 1, appliedTableSize)]);
+	}
+
+	if (waveform->getIndex() != appliedWaveform)
+	{
+		appliedWaveform = waveform->getIndex();
+		engine.setWaveform((WavetableSet::Shape)appliedWaveform);
+	}
+
+	if (interpolation->getIndex() != appliedInterpolation)
+	{
+		appliedInterpolation = interpolation->getIndex();
+		engine.setInterpolation((TableInterpolation::Mode)appliedInterpolation);
+	}
+
+	if (gain->get() != appliedGain)
+	{
+		appliedGain = gain->get();
+		engine.setGain(appliedGain);
+	}
+}
+
+//==============================================================================
+//the plugin wrappers call this to create every new instance
+AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+	return new SynthProcessor();
+}
@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    SynthProcessor.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "SynthEngine.h"
+
+
+//The SynthEngine as an AudioProcessor, for the plugin build in Plugin/AudioApp_juce_Plugin.jucer.
+//It plays the wavetable voices from the host's MIDI, with the waveform, table size, interpolation and gain
+//as automatable parameters and the host's generic editor as its GUI.
+//
+//Hosts typically load dozens of instances into one process. They all take their wavetable sets from the same
+//process-wide WavetableCache (through the SharedResourcePointer in SynthEngine), so every instance playing a saw
+//at 2048 samples reads the very same read-only memory: only the first instance builds it, and the tables stay
+//warm in the cache for all of them. The last instance to go away frees the store.
+//
+//The engine's setters belong on the message thread, while hosts change parameters from whatever thread they like,
+//so a timer on the message thread picks up the parameter values and hands the changes to the engine.
+class SynthProcessor  : public AudioProcessor,
+						private Timer
+{
+	public:
+		SynthProcessor();
+		~SynthProcessor();
+
+		//==============================================================================
+		void prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock) override;
+		void releaseResources() override;
+		bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
+		void processBlock(AudioBuffer<float>& buffer, MidiBuffer& midiMessages) override;
+
+		//==============================================================================
+		AudioProcessorEditor* createEditor() override;
+		bool hasEditor() const override					{ return true; }
+
+		const String getName() const override			{ return "AudioApp_juce"; }
+		bool acceptsMidi() const override				{ return true; }
+		bool producesMidi() const override				{ return false; }
+		double getTailLengthSeconds() const override	{ return 0.0; }
+
+		//no programs, only the parameters
+		int getNumPrograms() override								{ return 1; }
+		int getCurrentProgram() override							{ return 0; }
+		void setCurrentProgram(int) override						{}
+		const String getProgramName(int) override					{ return {}; }
+		void changeProgramName(int, const String&) override		{}
+
+		void getStateInformation(MemoryBlock& destData) override;
+		void setStateInformation(const void* data, int sizeInBytes) override;
+
+		//polyphony of every instance
+		static constexpr int numVoices = 16;
+
+	private:
+		//forwards whatever parameters have changed to the engine, and releases the sets the audio thread is done with
+		void timerCallback() override;
+		void applyParameters();
+
+		SynthEngine engine;
+
+		//owned by the AudioProcessor once added
+		AudioParameterChoice* waveform;
+		AudioParameterChoice* tableSize;
+		AudioParameterChoice* interpolation;
+		AudioParameterFloat* gain;
+
+		//what the engine was last given, so the timer only passes on changes
+		int appliedWaveform = -1, appliedTableSize = -1, appliedInterpolation = -1;
+		float appliedGain = -1.0f;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SynthProcessor)
+};
@@ -0,0 +1,299 @@
+/*
+  ==============================================================================
+
+    TableInterpolation.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "SimdConfig.h"
+
+
+//How a wavetable voice reads the value between two samples of its table.
+//	truncate	the sample below, no interpolation at all
+//	linear		a straight line between the two neighbours
+//	hermite		a cubic through the 4 nearest samples (Catmull-Rom), matching the slope at both neighbours
+//	lagrange	the 5th order polynomial through the 6 nearest samples
+//The higher orders cost a few more loads and multiplies per sample, but they keep the interpolation noise
+//low enough that a table of 256 or even 128 samples sounds like a 2048 one read linearly. Small tables are what
+//let many different waveforms stay in L1 at once, which matters more than the arithmetic once there are many voices.
+//
+//Every table has guard samples around it, copies of the samples from the other end of the cycle, so the widest
+//mode can read index - 2 .. index + 3 straight from memory without any wrapping in the inner loop.
+//
+//The scalar, SSE2, AVX2 and AVX-512 versions below do the same operations in the same order, so every kernel level
+//produces the same output. That relies on the wide ones being compiled without FMA contraction, see SimdConfig.h.
+struct TableInterpolation
+{
+	//same order as the selector in MainComponent
+	enum class Mode
+	{
+		truncate = 0,
+		linear,
+		hermite,
+		lagrange
+	};
+
+	static constexpr int numModes = 4;
+
+	//samples every table needs in front of index 0 and behind its last sample for the widest mode
+	static constexpr int guardSamplesBefore = 2;
+	static constexpr int guardSamplesAfter = 3;
+	static constexpr int numGuardSamples = guardSamplesBefore + guardSamplesAfter;
+
+	static const char* getModeName(Mode mode) noexcept
+	{
+		static const char* const names[] = { "truncate", "linear", "hermite", "lagrange" };
+		return names[jlimit(0, numModes - 1, (int)mode)];
+	}
+
+	//"none" is taken as truncate too; false if the name isn't a mode
+	static bool parseModeName(const String& name, Mode& mode) noexcept
+	{
+		for (auto index = 0; index < numModes; ++index)
+		{
+			if (name.trim().equalsIgnoreCase(getModeName((Mode)index)))
+			{
+				mode = (Mode)index;
+				return true;
+			}
+		}
+
+		if (name.trim().equalsIgnoreCase("none"))
+		{
+			mode = Mode::truncate;
+			return true;
+		}
+
+		return false;
+	}
+
+	//a mode as a type, so the kernels can be instantiated once per mode without a branch per sample
+	template <Mode mode>
+	using Tag = std::integral_constant<Mode, mode>;
+
+	//the value frac (0..1) of the way from table[0] to table[1]; the table pointer already points at the lower index
+	static forcedinline float interpolate(const float* x, float, Tag<Mode::truncate>) noexcept
+	{
+		return x[0];
+	}
+
+	static forcedinline float interpolate(const float* x, float frac, Tag<Mode::linear>) noexcept
+	{
+		return x[0] + frac * (x[1] - x[0]);
+	}
+
+	static forcedinline float interpolate(const float* x, float frac, Tag<Mode::hermite>) noexcept
+	{
+		auto c1 = 0.5f * (x[1] - x[-1]);
+		auto c2 = (x[-1] + 2.0f * x[1]) - (2.5f * x[0] + 0.5f * x[2]);
+		auto c3 = 0.5f * (x[2] - x[-1]) + 1.5f * (x[0] - x[1]);
+		return ((c3 * frac + c2) * frac + c1) * frac + x[0];
+	}
+
+	//Each sample k in -2 .. 3 is weighted by the product of (frac - j) over the other five j, divided by the product
+	//of (k - j). The products are built up once from each end and shared between the weights.
+	static forcedinline float interpolate(const float* x, float frac, Tag<Mode::lagrange>) noexcept
+	{
+		auto a = frac + 2.0f, b = frac + 1.0f, d = frac - 1.0f, e = frac - 2.0f, g = frac - 3.0f;
+		auto ab = a * b, abc = ab * frac, abcd = abc * d;
+		auto eg = e * g, deg = d * eg, cdeg = frac * deg;
+
+		auto sum = x[-2] * (b * cdeg) * (-1.0f / 120.0f);
+		sum += x[-1] * (a * cdeg) * (1.0f / 24.0f);
+		sum += x[0] * (ab * deg) * (-1.0f / 12.0f);
+		sum += x[1] * (abc * eg) * (1.0f / 12.0f);
+		sum += x[2] * (abcd * g) * (-1.0f / 24.0f);
+		sum += x[3] * (abcd * e) * (1.0f / 120.0f);
+		return sum;
+	}
+
+	//the same with the mode picked at runtime, for callers that only read a sample now and then
+	static forcedinline float interpolate(Mode mode, const float* x, float frac) noexcept
+	{
+		switch (mode)
+		{
+			case Mode::truncate:	return interpolate(x, frac, Tag<Mode::truncate>());
+			case Mode::hermite:		return interpolate(x, frac, Tag<Mode::hermite>());
+			case Mode::lagrange:	return interpolate(x, frac, Tag<Mode::lagrange>());
+			default:				return interpolate(x, frac, Tag<Mode::linear>());
+		}
+	}
+
+   #if AUDIOAPP_HAS_AVX2
+	//8 lanes at once: offset holds each lane's lower index from table, and only the samples a mode needs are gathered
+	AUDIOAPP_TARGET_AVX2 static forcedinline __m256 interpolateAVX2(const float* table, __m256i offset, __m256, Tag<Mode::truncate>) noexcept
+	{
+		return _mm256_i32gather_ps(table, offset, 4);
+	}
+
+	AUDIOAPP_TARGET_AVX2 static forcedinline __m256 interpolateAVX2(const float* table, __m256i offset, __m256 frac, Tag<Mode::linear>) noexcept
+	{
+		auto x0 = _mm256_i32gather_ps(table, offset, 4);
+		auto x1 = _mm256_i32gather_ps(table + 1, offset, 4);
+		return _mm256_add_ps(x0, _mm256_mul_ps(frac, _mm256_sub_ps(x1, x0)));
+	}
+
+	AUDIOAPP_TARGET_AVX2 static forcedinline __m256 interpolateAVX2(const float* table, __m256i offset, __m256 frac, Tag<Mode::hermite>) noexcept
+	{
+		auto xm1 = _mm256_i32gather_ps(table - 1, offset, 4);
+		auto x0 = _mm256_i32gather_ps(table, offset, 4);
+		auto x1 = _mm256_i32gather_ps(table + 1, offset, 4);
+		auto x2 = _mm256_i32gather_ps(table + 2, offset, 4);
+		const auto half = _mm256_set1_ps(0.5f);
+
+		auto c1 = _mm256_mul_ps(half, _mm256_sub_ps(x1, xm1));
+		auto c2 = _mm256_sub_ps(_mm256_add_ps(xm1, _mm256_mul_ps(_mm256_set1_ps(2.0f), x1)),
+								_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(2.5f), x0), _mm256_mul_ps(half, x2)));
+		auto c3 = _mm256_add_ps(_mm256_mul_ps(half, _mm256_sub_ps(x2, xm1)), _mm256_mul_ps(_mm256_set1_ps(1.5f), _mm256_sub_ps(x0, x1)));
+
+		auto y = _mm256_add_ps(_mm256_mul_ps(c3, frac), c2);
+		y = _mm256_add_ps(_mm256_mul_ps(y, frac), c1);
+		return _mm256_add_ps(_mm256_mul_ps(y, frac), x0);
+	}
+
+	AUDIOAPP_TARGET_AVX2 static forcedinline __m256 interpolateAVX2(const float* table, __m256i offset, __m256 frac, Tag<Mode::lagrange>) noexcept
+	{
+		auto a = _mm256_add_ps(frac, _mm256_set1_ps(2.0f));
+		auto b = _mm256_add_ps(frac, _mm256_set1_ps(1.0f));
+		auto d = _mm256_sub_ps(frac, _mm256_set1_ps(1.0f));
+		auto e = _mm256_sub_ps(frac, _mm256_set1_ps(2.0f));
+		auto g = _mm256_sub_ps(frac, _mm256_set1_ps(3.0f));
+		auto ab = _mm256_mul_ps(a, b), abc = _mm256_mul_ps(ab, frac), abcd = _mm256_mul_ps(abc, d);
+		auto eg = _mm256_mul_ps(e, g), deg = _mm256_mul_ps(d, eg), cdeg = _mm256_mul_ps(frac, deg);
+
+		auto sum = lagrangeTermAVX2(table - 2, offset, _mm256_mul_ps(b, cdeg), -1.0f / 120.0f);
+		sum = _mm256_add_ps(sum, lagrangeTermAVX2(table - 1, offset, _mm256_mul_ps(a, cdeg), 1.0f / 24.0f));
+		sum = _mm256_add_ps(sum, lagrangeTermAVX2(table, offset, _mm256_mul_ps(ab, deg), -1.0f / 12.0f));
+		sum = _mm256_add_ps(sum, lagrangeTermAVX2(table + 1, offset, _mm256_mul_ps(abc, eg), 1.0f / 12.0f));
+		sum = _mm256_add_ps(sum, lagrangeTermAVX2(table + 2, offset, _mm256_mul_ps(abcd, g), -1.0f / 24.0f));
+		return _mm256_add_ps(sum, lagrangeTermAVX2(table + 3, offset, _mm256_mul_ps(abcd, e), 1.0f / 120.0f));
+	}
+
+	AUDIOAPP_TARGET_AVX2 static forcedinline __m256 lagrangeTermAVX2(const float* table, __m256i offset, __m256 weight, float scale) noexcept
+	{
+		return _mm256_mul_ps(_mm256_mul_ps(_mm256_i32gather_ps(table, offset, 4), weight), _mm256_set1_ps(scale));
+	}
+   #endif
+
+   #if AUDIOAPP_HAS_AVX512
+	//16 lanes at once, the same as the AVX2 versions otherwise
+	AUDIOAPP_TARGET_AVX512 static forcedinline __m512 interpolateAVX512(const float* table, __m512i offset, __m512, Tag<Mode::truncate>) noexcept
+	{
+		return _mm512_i32gather_ps(offset, table, 4);
+	}
+
+	AUDIOAPP_TARGET_AVX512 static forcedinline __m512 interpolateAVX512(const float* table, __m512i offset, __m512 frac, Tag<Mode::linear>) noexcept
+	{
+		auto x0 = _mm512_i32gather_ps(offset, table, 4);
+		auto x1 = _mm512_i32gather_ps(offset, table + 1, 4);
+		return _mm512_add_ps(x0, _mm512_mul_ps(frac, _mm512_sub_ps(x1, x0)));
+	}
+
+	AUDIOAPP_TARGET_AVX512 static forcedinline __m512 interpolateAVX512(const float* table, __m512i offset, __m512 frac, Tag<Mode::hermite>) noexcept
+	{
+		auto xm1 = _mm512_i32gather_ps(offset, table - 1, 4);
+		auto x0 = _mm512_i32gather_ps(offset, table, 4);
+		auto x1 = _mm512_i32gather_ps(offset, table + 1, 4);
+		auto x2 = _mm512_i32gather_ps(offset, table + 2, 4);
+		const auto half = _mm512_set1_ps(0.5f);
+
+		auto c1 = _mm512_mul_ps(half, _mm512_sub_ps(x1, xm1));
+		auto c2 = _mm512_sub_ps(_mm512_add_ps(xm1, _mm512_mul_ps(_mm512_set1_ps(2.0f), x1)),
+								_mm512_add_ps(_mm512_mul_ps(_mm512_set1_ps(2.5f), x0), _mm512_mul_ps(half, x2)));
+		auto c3 = _mm512_add_ps(_mm512_mul_ps(half, _mm512_sub_ps(x2, xm1)), _mm512_mul_ps(_mm512_set1_ps(1.5f), _mm512_sub_ps(x0, x1)));
+
+		auto y = _mm512_add_ps(_mm512_mul_ps(c3, frac), c2);
+		y = _mm512_add_ps(_mm512_mul_ps(y, frac), c1);
+		return _mm512_add_ps(_mm512_mul_ps(y, frac), x0);
+	}
+
+	AUDIOAPP_TARGET_AVX512 static forcedinline __m512 interpolateAVX512(const float* table, __m512i offset, __m512 frac, Tag<Mode::lagrange>) noexcept
+	{
+		auto a = _mm512_add_ps(frac, _mm512_set1_ps(2.0f));
+		auto b = _mm512_add_ps(frac, _mm512_set1_ps(1.0f));
+		auto d = _mm512_sub_ps(frac, _mm512_set1_ps(1.0f));
+		auto e = _mm512_sub_ps(frac, _mm512_set1_ps(2.0f));
+		auto g = _mm512_sub_ps(frac, _mm512_set1_ps(3.0f));
+		auto ab = _mm512_mul_ps(a, b), abc = _mm512_mul_ps(ab, frac), abcd = _mm512_mul_ps(abc, d);
+		auto eg = _mm512_mul_ps(e, g), deg = _mm512_mul_ps(d, eg), cdeg = _mm512_mul_ps(frac, deg);
+
+		auto sum = lagrangeTermAVX512(table - 2, offset, _mm512_mul_ps(b, cdeg), -1.0f / 120.0f);
+		sum = _mm512_add_ps(sum, lagrangeTermAVX512(table - 1, offset, _mm512_mul_ps(a, cdeg), 1.0f / 24.0f));
+		sum = _mm512_add_ps(sum, lagrangeTermAVX512(table, offset, _mm512_mul_ps(ab, deg), -1.0f / 12.0f));
+		sum = _mm512_add_ps(sum, lagrangeTermAVX512(table + 1, offset, _mm512_mul_ps(abc, eg), 1.0f / 12.0f));
+		sum = _mm512_add_ps(sum, lagrangeTermAVX512(table + 2, offset, _mm512_mul_ps(abcd, g), -1.0f / 24.0f));
+		return _mm512_add_ps(sum, lagrangeTermAVX512(table + 3, offset, _mm512_mul_ps(abcd, e), 1.0f / 120.0f));
+	}
+
+	AUDIOAPP_TARGET_AVX512 static forcedinline __m512 lagrangeTermAVX512(const float* table, __m512i offset, __m512 weight, float scale) noexcept
+	{
+		return _mm512_mul_ps(_mm512_mul_ps(_mm512_i32gather_ps(offset, table, 4), weight), _mm512_set1_ps(scale));
+	}
+   #endif
+
+   #if AUDIOAPP_HAS_SSE2
+	//4 lanes at once: SSE2 has no gather, so the lower index of each lane comes in through memory and every sample
+	//a mode needs is loaded in scalar
+	static forcedinline __m128 loadSSE2(const float* table, const int32* indices, int k) noexcept
+	{
+		return _mm_setr_ps(table[indices[0] + k], table[indices[1] + k], table[indices[2] + k], table[indices[3] + k]);
+	}
+
+	static forcedinline __m128 interpolateSSE2(const float* table, const int32* indices, __m128, Tag<Mode::truncate>) noexcept
+	{
+		return loadSSE2(table, indices, 0);
+	}
+
+	static forcedinline __m128 interpolateSSE2(const float* table, const int32* indices, __m128 frac, Tag<Mode::linear>) noexcept
+	{
+		auto x0 = loadSSE2(table, indices, 0);
+		auto x1 = loadSSE2(table, indices, 1);
+		return _mm_add_ps(x0, _mm_mul_ps(frac, _mm_sub_ps(x1, x0)));
+	}
+
+	static forcedinline __m128 interpolateSSE2(const float* table, const int32* indices, __m128 frac, Tag<Mode::hermite>) noexcept
+	{
+		auto xm1 = loadSSE2(table, indices, -1);
+		auto x0 = loadSSE2(table, indices, 0);
+		auto x1 = loadSSE2(table, indices, 1);
+		auto x2 = loadSSE2(table, indices, 2);
+		const auto half = _mm_set1_ps(0.5f);
+
+		auto c1 = _mm_mul_ps(half, _mm_sub_ps(x1, xm1));
+		auto c2 = _mm_sub_ps(_mm_add_ps(xm1, _mm_mul_ps(_mm_set1_ps(2.0f), x1)),
+							 _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.5f), x0), _mm_mul_ps(half, x2)));
+		auto c3 = _mm_add_ps(_mm_mul_ps(half, _mm_sub_ps(x2, xm1)), _mm_mul_ps(_mm_set1_ps(1.5f), _mm_sub_ps(x0, x1)));
+
+		auto y = _mm_add_ps(_mm_mul_ps(c3, frac), c2);
+		y = _mm_add_ps(_mm_mul_ps(y, frac), c1);
+		return _mm_add_ps(_mm_mul_ps(y, frac), x0);
+	}
+
+	static forcedinline __m128 interpolateSSE2(const float* table, const int32* indices, __m128 frac, Tag<Mode::lagrange>) noexcept
+	{
+		auto a = _mm_add_ps(frac, _mm_set1_ps(2.0f));
+		auto b = _mm_add_ps(frac, _mm_set1_ps(1.0f));
+		auto d = _mm_sub_ps(frac, _mm_set1_ps(1.0f));
+		auto e = _mm_sub_ps(frac, _mm_set1_ps(2.0f));
+		auto g = _mm_sub_ps(frac, _mm_set1_ps(3.0f));
+		auto ab = _mm_mul_ps(a, b), abc = _mm_mul_ps(ab, frac), abcd = _mm_mul_ps(abc, d);
+		auto eg = _mm_mul_ps(e, g), deg = _mm_mul_ps(d, eg), cdeg = _mm_mul_ps(frac, deg);
+
+		auto sum = lagrangeTermSSE2(table, indices, -2, _mm_mul_ps(b, cdeg), -1.0f / 120.0f);
+		sum = _mm_add_ps(sum, lagrangeTermSSE2(table, indices, -1, _mm_mul_ps(a, cdeg), 1.0f / 24.0f));
+		sum = _mm_add_ps(sum, lagrangeTermSSE2(table, indices, 0, _mm_mul_ps(ab, deg), -1.0f / 12.0f));
+		sum = _mm_add_ps(sum, lagrangeTermSSE2(table, indices, 1, _mm_mul_ps(abc, eg), 1.0f / 12.0f));
+		sum = _mm_add_ps(sum, lagrangeTermSSE2(table, indices, 2, _mm_mul_ps(abcd, g), -1.0f / 24.0f));
+		return _mm_add_ps(sum, lagrangeTermSSE2(table, indices, 3, _mm_mul_ps(abcd, e), 1.0f / 120.0f));
+	}
+
+	static forcedinline __m128 lagrangeTermSSE2(const float* table, const int32* indices, int k, __m128 weight, float scale) noexcept
+	{
+		return _mm_mul_ps(_mm_mul_ps(loadSSE2(table, indices, k), weight), _mm_set1_ps(scale));
+	}
+   #endif
+};
@@ -0,0 +1,559 @@
+/*
+  ==============================================================================
+
+    VoiceBank.cpp
+
+  ==============================================================================
+*/
+
+#include "VoiceBank.h"
+#include "SimdConfig.h"
+#include "KernelDispatch.h"
+
+void VoiceBank::setCapacity(int maxVoices)
+{
+	jassert(maxVoices >= 0);
+
+	//round up so that every array starts on its own cache line and the SIMD loop never needs a tail
+	auto paddedVoices = getPaddedVoices(maxVoices);
+	auto bytesPerArray = (size_t)paddedVoices * sizeof(float);
+	static_assert (sizeof(float) == sizeof(int32), "all voice arrays share the same stride");
+
+	//all arrays in one block, plus room to slide the first one onto a 64-byte boundary
+	storage.calloc(bytesPerArray * numArrays + 64);
+	auto* aligned = (char*)(((pointer_sized_uint)storage.get() + 63) & ~(pointer_sized_uint)63);
+	auto nextArray = [&aligned, bytesPerArray] { auto* array = aligned; aligned += bytesPerArray; return array; };
+
+	phases = (uint32*)nextArray();
+	phaseIncrements = (uint32*)nextArray();
+	phaseDeltas = (float*)nextArray();
+	gains = (float*)nextArray();
+	tableIds = (int32*)nextArray();
+	targetPhaseIncrements = (uint32*)nextArray();
+	targetGains = (float*)nextArray();
+	phaseDeltaRatios = (float*)nextArray();
+	gainSteps = (float*)nextArray();
+	blockEndPhaseDeltas = (float*)nextArray();
+	blockEndGains = (float*)nextArray();
+	rampSamplesRemaining = (int32*)nextArray();
+
+	capacity = maxVoices;
+	numVoices = 0;
+	hasActiveRamps = false;
+}
+
+void VoiceBank::setWavetableSet(const WavetableSet* set) noexcept
+{
+	if (set == nullptr)
+	{
+		wavetableSet = nullptr;
+		return;
+	}
+
+	//the phases are fractions of a cycle, so only the split into index and fraction changes with the table size
+	wavetableSet = set;
+	tableSize = set->getTableSize();
+	tableStride = set->getTableStride();
+	indexShift = FixedPointPhase::getIndexShift(tableSize);
+	fractionMask = FixedPointPhase::getFractionMask(indexShift);
+	fractionScale = FixedPointPhase::getFractionScale(indexShift);
+
+	//The SIMD kernels gather from the padding behind the last voice too, and a smaller set has fewer levels,
+	//so every lane they read needs a level that exists in the new set.
+	auto paddedVoices = getPaddedVoices(numVoices);
+
+	for (auto voice = 0; voice < paddedVoices; ++voice)
+		tableIds[voice] = getLevelForPhaseDelta(jmax(phaseDeltas[voice], (float)targetPhaseIncrements[voice]));
+}
+
+int VoiceBank::addVoice(float frequency, float sampleRate, float gain) noexcept
+{
+	if (numVoices >= capacity)
+		return -1;
+
+	auto voiceIndex = numVoices;
+	startVoice(voiceIndex, frequency, sampleRate, gain);
+
+	return voiceIndex;
+}
+
+void VoiceBank::startVoice(int voiceIndex, float frequency, float sampleRate, float gain) noexcept
+{
+	jassert(isPositiveAndBelow(voiceIndex, capacity));
+
+	numVoices = jmax(numVoices, voiceIndex + 1);
+	phases[voiceIndex] = 0;
+	rampSamplesRemaining[voiceIndex] = 0;
+	setFrequency(voiceIndex, frequency, sampleRate);
+	setGain(voiceIndex, gain);
+}
+
+void VoiceBank::setNumVoices(int newNumVoices) noexcept
+{
+	jassert(isPositiveAndNotGreaterThan(newNumVoices, capacity));
+	newNumVoices = jlimit(0, capacity, newNumVoices);
+
+	//The SIMD kernels still render the slots cut off here when they share a group with a live voice, and prepareRamps()
+	//only looks at the voices below numVoices. So they go back to the silent state of a slot never used, with no ramp
+	//whose steps could bring them back and level 0, which every set has, for the gathers.
+	if (newNumVoices < numVoices)
+		clearVoices(newNumVoices, numVoices);
+
+	numVoices = newNumVoices;
+}
+
+void VoiceBank::removeAllVoices() noexcept
+{
+	//the padding lanes behind the last voice are rendered too, so they have to go back to silence
+	clearVoices(0, getPaddedVoices(numVoices));
+
+	numVoices = 0;
+	hasActiveRamps = false;
+}
+
+void VoiceBank::clearVoices(int firstVoice, int endVoice) noexcept
+{
+	//every array is getPaddedVoices(capacity) long and they follow each other, starting with phases
+	auto* array = (char*)phases;
+	auto bytesPerArray = (size_t)getPaddedVoices(capacity) * sizeof(float);
+
+	for (auto i = 0; i < numArrays; ++i, array += bytesPerArray)
+		zeromem(array + (size_t)firstVoice * sizeof(float), (size_t)(endVoice - firstVoice) * sizeof(float));
+}
+
+uint32 VoiceBank::getPhaseIncrementForFrequency(float frequency, float sampleRate) const noexcept
+{
+	return FixedPointPhase::getIncrement(frequency, sampleRate);
+}
+
+int VoiceBank::getLevelForPhaseDelta(float phaseDelta) const noexcept
+{
+	return wavetableSet != nullptr ? wavetableSet->getLevelForPhaseDelta(FixedPointPhase::getTableDelta(phaseDelta, tableSize)) : 0;
+}
+
+void VoiceBank::setFrequency(int voiceIndex, float frequency, float sampleRate) noexcept
+{
+	jassert(isPositiveAndBelow(voiceIndex, numVoices));
+
+	auto increment = getPhaseIncrementForFrequency(frequency, sampleRate);
+	phaseIncrements[voiceIndex] = increment;
+	targetPhaseIncrements[voiceIndex] = increment;
+	phaseDeltas[voiceIndex] = (float)increment;
+	tableIds[voiceIndex] = getLevelForPhaseDelta(phaseDeltas[voiceIndex]);
+}
+
+void VoiceBank::setGain(int voiceIndex, float gain) noexcept
+{
+	jassert(isPositiveAndBelow(voiceIndex, numVoices));
+	gains[voiceIndex] = gain;
+	targetGains[voiceIndex] = gain;
+}
+
+void VoiceBank::rampFrequency(int voiceIndex, float frequency, float sampleRate, int rampLengthSamples) noexcept
+{
+	jassert(isPositiveAndBelow(voiceIndex, numVoices));
+
+	//an exponential ramp can't start from or end at zero, so those jump
+	auto increment = getPhaseIncrementForFrequency(frequency, sampleRate);
+	if (rampLengthSamples <= 0 || increment == 0 || phaseIncrements[voiceIndex] == 0)
+	{
+		setFrequency(voiceIndex, frequency, sampleRate);
+		return;
+	}
+
+	targetPhaseIncrements[voiceIndex] = increment;
+	rampSamplesRemaining[voiceIndex] = rampLengthSamples;
+	hasActiveRamps = true;
+}
+
+void VoiceBank::rampGain(int voiceIndex, float gain, int rampLengthSamples) noexcept
+{
+	jassert(isPositiveAndBelow(voiceIndex, numVoices));
+
+	if (rampLengthSamples <= 0)
+	{
+		setGain(voiceIndex, gain);
+		return;
+	}
+
+	targetGains[voiceIndex] = gain;
+	rampSamplesRemaining[voiceIndex] = rampLengthSamples;
+	hasActiveRamps = true;
+}
+
+bool VoiceBank::prepareRamps(int numSamples) noexcept
+{
+	//Each block covers numSamples / remaining of what is left of a ramp. If the ramp ends inside this block,
+	//it is stretched to the end of the block, so the steps stay constant across the whole block.
+	auto anyRamping = false;
+
+	for (auto voice = 0; voice < numVoices; ++voice)
+	{
+		auto remaining = rampSamplesRemaining[voice];
+
+		if (remaining <= 0)
+		{
+			phaseDeltaRatios[voice] = 1.0f;
+			gainSteps[voice] = 0.0f;
+			continue;
+		}
+
+		anyRamping = true;
+		auto portion = (float)numSamples / (float)jmax(remaining, numSamples);
+
+		//a voice sitting at zero only ever gets a gain ramp, rampFrequency() jumps out of zero
+		auto startDelta = phaseDeltas[voice];
+		auto endDelta = startDelta;
+
+		if (startDelta > 0.0f)
+		{
+			endDelta = startDelta * std::pow((float)targetPhaseIncrements[voice] / startDelta, portion);
+			phaseDeltaRatios[voice] = std::pow(endDelta / startDelta, 1.0f / (float)numSamples);
+		}
+		else
+		{
+			phaseDeltaRatios[voice] = 1.0f;
+		}
+
+		blockEndPhaseDeltas[voice] = endDelta;
+
+		auto endGain = gains[voice] + (targetGains[voice] - gains[voice]) * portion;
+		gainSteps[voice] = (endGain - gains[voice]) / (float)numSamples;
+		blockEndGains[voice] = endGain;
+
+		//use the level for the higher of the two ends so the whole block stays below Nyquist
+		tableIds[voice] = getLevelForPhaseDelta(jmax(startDelta, endDelta));
+	}
+
+	return anyRamping;
+}
+
+void VoiceBank::finishRamps(int numSamples) noexcept
+{
+	//the kernel's running products drift a little, so every ramping voice is set to exactly where the ramp should be,
+	//and one that has arrived gets its exact integer increment back
+	auto anyRamping = false;
+
+	for (auto voice = 0; voice < numVoices; ++voice)
+	{
+		auto remaining = rampSamplesRemaining[voice];
+
+		if (remaining <= 0)
+			continue;
+
+		if ((remaining -= numSamples) > 0)
+		{
+			phaseDeltas[voice] = blockEndPhaseDeltas[voice];
+			phaseIncrements[voice] = (uint32)blockEndPhaseDeltas[voice];
+			gains[voice] = blockEndGains[voice];
+			anyRamping = true;
+		}
+		else
+		{
+			remaining = 0;
+			phaseIncrements[voice] = targetPhaseIncrements[voice];
+			phaseDeltas[voice] = (float)targetPhaseIncrements[voice];
+			gains[voice] = targetGains[voice];
+			tableIds[voice] = getLevelForPhaseDelta(phaseDeltas[voice]);
+		}
+
+		rampSamplesRemaining[voice] = remaining;
+	}
+
+	hasActiveRamps = anyRamping;
+}
+
+void VoiceBank::renderBlock(float* dest, int numSamples) noexcept
+{
+	if (numVoices == 0 || wavetableSet == nullptr || numSamples <= 0)
+		return;
+
+	beginBlock(numSamples);
+	renderVoices(dest, numSamples, 0, numVoices);
+	endBlock(numSamples);
+}
+
+void VoiceBank::beginBlock(int numSamples) noexcept
+{
+	isRampingBlock = hasActiveRamps && wavetableSet != nullptr && numSamples > 0 && prepareRamps(numSamples);
+
+	if (! isRampingBlock)
+		hasActiveRamps = false;
+}
+
+void VoiceBank::renderVoices(float* dest, int numSamples, int firstVoice, int endVoice) noexcept
+{
+	//a range starting mid-group would render the lanes in front of it twice
+	jassert(firstVoice % voiceAlignment == 0);
+	endVoice = jmin(endVoice, numVoices);
+
+	if (wavetableSet == nullptr || numSamples <= 0 || firstVoice >= endVoice)
+		return;
+
+	if (isRampingBlock)
+		renderVoiceRange<true>(dest, numSamples, firstVoice, endVoice);
+	else
+		renderVoiceRange<false>(dest, numSamples, firstVoice, endVoice);
+}
+
+void VoiceBank::endBlock(int numSamples) noexcept
+{
+	if (isRampingBlock)
+		finishRamps(numSamples);
+
+	isRampingBlock = false;
+}
+
+//==============================================================================
+//Everything the kernels read and write, gathered once per range. The kernels are free functions, not members,
+//because the AVX2 and AVX-512 ones are compiled with their own target attributes.
+struct VoiceKernelArrays
+{
+	uint32* phases;
+	uint32* phaseIncrements;
+	float* phaseDeltas;
+	float* gains;
+	const int32* tableIds;
+	const float* phaseDeltaRatios;
+	const float* gainSteps;
+
+	const float* tables;
+	int tableStride, indexShift;
+	uint32 fractionMask;
+	float fractionScale;
+};
+
+//voices are walked in whole groups; the lanes past numVoices are the zero-gain padding,
+//and a range ending mid-group only happens for the last one, since the others end on a multiple of voiceAlignment
+#if AUDIOAPP_HAS_AVX2
+AUDIOAPP_TARGET_AVX2 static forcedinline float horizontalSum(__m256 v) noexcept
+{
+	auto sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+	return _mm_cvtss_f32(sum);
+}
+
+template <bool isRamping, TableInterpolation::Mode mode>
+AUDIOAPP_TARGET_AVX2 static void renderVoicesAVX2(const VoiceKernelArrays& v, float* dest, int numSamples, int firstVoice, int endVoice) noexcept
+{
+	auto endLane = (endVoice + 7) & ~7;
+	const auto shiftV = _mm_cvtsi32_si128(v.indexShift);
+	const auto fractionMaskV = _mm256_set1_epi32((int32)v.fractionMask);
+	const auto fractionScaleV = _mm256_set1_ps(v.fractionScale);
+	const auto strideV = _mm256_set1_epi32(v.tableStride);
+
+	for (auto sample = 0; sample < numSamples; ++sample)
+	{
+		auto sum = _mm256_setzero_ps();
+
+		for (auto voice = firstVoice; voice < endLane; voice += 8)
+		{
+			auto phase = _mm256_load_si256((const __m256i*)(v.phases + voice));
+			auto increment = _mm256_load_si256((const __m256i*)(v.phaseIncrements + voice));
+			auto gain = _mm256_load_ps(v.gains + voice);
+
+			//index from the top bits and fraction from the rest, offset into the table this voice is using,
+			//then every neighbour the interpolation needs in one gather each
+			auto index0 = _mm256_srl_epi32(phase, shiftV);
+			auto frac = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(phase, fractionMaskV)), fractionScaleV);
+			auto tableId = _mm256_load_si256((const __m256i*)(v.tableIds + voice));
+			auto offset = _mm256_add_epi32(_mm256_mullo_epi32(tableId, strideV), index0);
+			auto currentSamples = TableInterpolation::interpolateAVX2(v.tables, offset, frac, TableInterpolation::Tag<mode>());
+
+			sum = _mm256_add_ps(sum, _mm256_mul_ps(currentSamples, gain));
+
+			//the integer add wraps by itself
+			_mm256_store_si256((__m256i*)(v.phases + voice), _mm256_add_epi32(phase, increment));
+
+			if (isRamping)
+			{
+				auto phaseDelta = _mm256_mul_ps(_mm256_load_ps(v.phaseDeltas + voice), _mm256_load_ps(v.phaseDeltaRatios + voice));
+				_mm256_store_ps(v.phaseDeltas + voice, phaseDelta);
+				_mm256_store_si256((__m256i*)(v.phaseIncrements + voice), _mm256_cvttps_epi32(phaseDelta));
+				_mm256_store_ps(v.gains + voice, _mm256_add_ps(gain, _mm256_load_ps(v.gainSteps + voice)));
+			}
+		}
+
+		dest[sample] += horizontalSum(sum);
+	}
+
+	//MSVC mixes these VEX instructions with legacy SSE ones elsewhere, which stalls on some cores without this
+	_mm256_zeroupper();
+}
+#endif
+
+#if AUDIOAPP_HAS_AVX512
+//the two halves are added, then summed like the AVX2 kernel's sum
+AUDIOAPP_TARGET_AVX512 static forcedinline float horizontalSum(__m512 v) noexcept
+{
+	auto upper = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1));
+	auto sum = _mm256_add_ps(_mm512_castps512_ps256(v), upper);
+	auto quarter = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+	quarter = _mm_add_ps(quarter, _mm_movehl_ps(quarter, quarter));
+	quarter = _mm_add_ss(quarter, _mm_shuffle_ps(quarter, quarter, 1));
+	return _mm_cvtss_f32(quarter);
+}
+
+//the AVX2 kernel at twice the width: a group is a whole voiceAlignment, so there are no padding lanes beyond it
+template <bool isRamping, TableInterpolation::Mode mode>
+AUDIOAPP_TARGET_AVX512 static void renderVoicesAVX512(const VoiceKernelArrays& v, float* dest, int numSamples, int firstVoice, int endVoice) noexcept
+{
+	auto endLane = (endVoice + 15) & ~15;
+	const auto shiftV = _mm_cvtsi32_si128(v.indexShift);
+	const auto fractionMaskV = _mm512_set1_epi32((int32)v.fractionMask);
+	const auto fractionScaleV = _mm512_set1_ps(v.fractionScale);
+	const auto strideV = _mm512_set1_epi32(v.tableStride);
+
+	for (auto sample = 0; sample < numSamples; ++sample)
+	{
+		auto sum = _mm512_setzero_ps();
+
+		for (auto voice = firstVoice; voice < endLane; voice += 16)
+		{
+			auto phase = _mm512_load_si512(v.phases + voice);
+			auto increment = _mm512_load_si512(v.phaseIncrements + voice);
+			auto gain = _mm512_load_ps(v.gains + voice);
+
+			auto index0 = _mm512_srl_epi32(phase, shiftV);
+			auto frac = _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_and_si512(phase, fractionMaskV)), fractionScaleV);
+			auto tableId = _mm512_load_si512(v.tableIds + voice);
+			auto offset = _mm512_add_epi32(_mm512_mullo_epi32(tableId, strideV), index0);
+			auto currentSamples = TableInterpolation::interpolateAVX512(v.tables, offset, frac, TableInterpolation::Tag<mode>());
+
+			sum = _mm512_add_ps(sum, _mm512_mul_ps(currentSamples, gain));
+
+			_mm512_store_si512(v.phases + voice, _mm512_add_epi32(phase, increment));
+
+			if (isRamping)
+			{
+				auto phaseDelta = _mm512_mul_ps(_mm512_load_ps(v.phaseDeltas + voice), _mm512_load_ps(v.phaseDeltaRatios + voice));
+				_mm512_store_ps(v.phaseDeltas + voice, phaseDelta);
+				_mm512_store_si512(v.phaseIncrements + voice, _mm512_cvttps_epi32(phaseDelta));
+				_mm512_store_ps(v.gains + voice, _mm512_add_ps(gain, _mm512_load_ps(v.gainSteps + voice)));
+			}
+		}
+
+		dest[sample] += horizontalSum(sum);
+	}
+
+	_mm256_zeroupper();
+}
+#endif
+
+#if AUDIOAPP_HAS_SSE2
+static forcedinline float horizontalSum(__m128 v) noexcept
+{
+	auto sum = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+	return _mm_cvtss_f32(sum);
+}
+
+template <bool isRamping, TableInterpolation::Mode mode>
+static void renderVoicesSSE2(const VoiceKernelArrays& v, float* dest, int numSamples, int firstVoice, int endVoice) noexcept
+{
+	auto endLane = (endVoice + 3) & ~3;
+	const auto shiftV = _mm_cvtsi32_si128(v.indexShift);
+	const auto fractionMaskV = _mm_set1_epi32((int32)v.fractionMask);
+	const auto fractionScaleV = _mm_set1_ps(v.fractionScale);
+	auto* tables = v.tables;
+	alignas(16) int32 indices[4];
+
+	for (auto sample = 0; sample < numSamples; ++sample)
+	{
+		auto sum = _mm_setzero_ps();
+
+		for (auto voice = firstVoice; voice < endLane; voice += 4)
+		{
+			auto phase = _mm_load_si128((const __m128i*)(v.phases + voice));
+			auto increment = _mm_load_si128((const __m128i*)(v.phaseIncrements + voice));
+			auto gain = _mm_load_ps(v.gains + voice);
+			auto index0 = _mm_srl_epi32(phase, shiftV);
+			auto frac = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(phase, fractionMaskV)), fractionScaleV);
+
+			//SSE2 has neither a gather nor a 32-bit multiply, so the table offsets are formed in scalar
+			_mm_store_si128((__m128i*)indices, index0);
+			for (auto lane = 0; lane < 4; ++lane)
+				indices[lane] += v.tableIds[voice + lane] * v.tableStride;
+
+			auto currentSamples = TableInterpolation::interpolateSSE2(tables, indices, frac, TableInterpolation::Tag<mode>());
+
+			sum = _mm_add_ps(sum, _mm_mul_ps(currentSamples, gain));
+
+			_mm_store_si128((__m128i*)(v.phases + voice), _mm_add_epi32(phase, increment));
+
+			if (isRamping)
+			{
+				auto phaseDelta = _mm_mul_ps(_mm_load_ps(v.phaseDeltas + voice), _mm_load_ps(v.phaseDeltaRatios + voice));
+				_mm_store_ps(v.phaseDeltas + voice, phaseDelta);
+				_mm_store_si128((__m128i*)(v.phaseIncrements + voice), _mm_cvttps_epi32(phaseDelta));
+				_mm_store_ps(v.gains + voice, _mm_add_ps(gain, _mm_load_ps(v.gainSteps + voice)));
+			}
+		}
+
+		dest[sample] += horizontalSum(sum);
+	}
+}
+#endif
+
+template <bool isRamping, TableInterpolation::Mode mode>
+static void renderVoicesScalar(const VoiceKernelArrays& v, float* dest, int numSamples, int firstVoice, int endVoice) noexcept
+{
+	for (auto sample = 0; sample < numSamples; ++sample)
+	{
+		auto sum = 0.0f;
+
+		for (auto voice = firstVoice; voice < endVoice; ++voice)
+		{
+			auto phase = v.phases[voice];
+			auto index0 = (int)(phase >> v.indexShift);
+			auto frac = (float)(phase & v.fractionMask) * v.fractionScale;
+			auto* table = v.tables + v.tableIds[voice] * v.tableStride;
+			sum += TableInterpolation::interpolate(table + index0, frac, TableInterpolation::Tag<mode>()) * v.gains[voice];
+
+			v.phases[voice] = phase + v.phaseIncrements[voice];
+
+			if (isRamping)
+			{
+				v.phaseDeltas[voice] *= v.phaseDeltaRatios[voice];
+				v.phaseIncrements[voice] = (uint32)v.phaseDeltas[voice];
+				v.gains[voice] += v.gainSteps[voice];
+			}
+		}
+
+		dest[sample] += sum;
+	}
+}
+
+template <bool isRamping>
+void VoiceBank::renderVoiceRange(float* dest, int numSamples, int firstVoice, int endVoice) noexcept
+{
+	switch (interpolation)
+	{
+		case TableInterpolation::Mode::truncate:	renderVoiceRange<isRamping, TableInterpolation::Mode::truncate>(dest, numSamples, firstVoice, endVoice); break;
+		case TableInterpolation::Mode::hermite:		renderVoiceRange<isRamping, TableInterpolation::Mode::hermite>(dest, numSamples, firstVoice, endVoice); break;
+		case TableInterpolation::Mode::lagrange:	renderVoiceRange<isRamping, TableInterpolation::Mode::lagrange>(dest, numSamples, firstVoice, endVoice); break;
+		default:									renderVoiceRange<isRamping, TableInterpolation::Mode::linear>(dest, numSamples, firstVoice, endVoice); break;
+	}
+}
+
+template <bool isRamping, TableInterpolation::Mode mode>
+void VoiceBank::renderVoiceRange(float* dest, int numSamples, int firstVoice, int endVoice) noexcept
+{
+	VoiceKernelArrays arrays { phases, phaseIncrements, phaseDeltas, gains, tableIds, phaseDeltaRatios, gainSteps,
+							   wavetableSet->getTables(), tableStride, indexShift, fractionMask, fractionScale };
+
+	switch (KernelDispatch::getActiveLevel())
+	{
+	   #if AUDIOAPP_HAS_AVX512
+		case KernelDispatch::Level::avx512:	renderVoicesAVX512<isRamping, mode>(arrays, dest, numSamples, firstVoice, endVoice); break;
+	   #endif
+	   #if AUDIOAPP_HAS_AVX2
+		case KernelDispatch::Level::avx2:	renderVoicesAVX2<isRamping, mode>(arrays, dest, numSamples, firstVoice, endVoice); break;
+	   #endif
+	   #if AUDIOAPP_HAS_SSE2
+		case KernelDispatch::Level::sse2:	renderVoicesSSE2<isRamping, mode>(arrays, dest, numSamples, firstVoice, endVoice); break;
+	   #endif
+		default:							renderVoicesScalar<isRamping, mode>(arrays, dest, numSamples, firstVoice, endVoice); break;
+	}
+}
@@ -0,0 +1,128 @@
+/*
+  ==============================================================================
+
+    VoiceBank.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "WavetableSet.h"
+#include "FixedPointPhase.h"
+
+
+//Holds every wavetable voice as a structure of arrays instead of one heap object per voice.
+//Phase, phase increment, gain and table id each live in their own contiguous, 64-byte aligned array,
+//so renderBlock() can walk all voices in one pass and load 4 or 8 of them into a SIMD register at once.
+//The table id of a voice is the mipmap level of the current WavetableSet that suits its frequency.
+//Phases are FixedPointPhase values, so they wrap for free and don't depend on the table size of the set.
+//
+//Frequency and gain can also glide to a new value: the increment ramps exponentially (constant pitch speed)
+//and the gain linearly. The per-sample steps are worked out once per block, so the kernel just multiplies and
+//adds them without any branching, and blocks without a ramp in progress skip that work entirely.
+class VoiceBank
+{
+	public:
+		VoiceBank() {}
+
+		//allocates room for maxVoices; this is the only call that allocates, so never make it from the audio thread
+		void setCapacity(int maxVoices);
+		int getCapacity() const noexcept { return capacity; }
+		int getNumVoices() const noexcept { return numVoices; }
+
+		//Switches every voice over to another waveform, picking the level of each from its current increment.
+		//The set can have any power-of-two table size; the phases carry over unchanged.
+		//The bank only keeps the pointer, the caller owns the set and has to keep it alive while the bank uses it.
+		void setWavetableSet(const WavetableSet* set) noexcept;
+		const WavetableSet* getWavetableSet() const noexcept { return wavetableSet; }
+
+		//how every voice reads between the samples of its table; linear unless set otherwise
+		void setInterpolation(TableInterpolation::Mode newMode) noexcept { interpolation = newMode; }
+		TableInterpolation::Mode getInterpolation() const noexcept { return interpolation; }
+
+		//appends a voice and returns its index, or -1 when the bank is already full
+		int addVoice(float frequency, float sampleRate, float gain) noexcept;
+		void removeAllVoices() noexcept;
+
+		//Restarts the voice in a given slot from phase 0, with any ramp cancelled; the bank grows to include it if needed.
+		//This and setNumVoices() are for callers that manage the slots themselves, like a VoicePool.
+		void startVoice(int voiceIndex, float frequency, float sampleRate, float gain) noexcept;
+
+		//Only voices below numVoices are rendered. Slots cut off this way are cleared like slots never used, since the
+		//SIMD padding behind the last voice is still rendered.
+		void setNumVoices(int newNumVoices) noexcept;
+
+		float getGain(int voiceIndex) const noexcept { return gains[voiceIndex]; }
+		const float* getGains() const noexcept { return gains; }
+		bool isRamping(int voiceIndex) const noexcept { return rampSamplesRemaining[voiceIndex] > 0; }
+
+		//calculate the phase increment via 2^32 * (frequency / samplerate) and pick the matching level; jumps straight there
+		void setFrequency(int voiceIndex, float frequency, float sampleRate) noexcept;
+		void setGain(int voiceIndex, float gain) noexcept;
+
+		//Glides to the new value over rampLengthSamples. A voice has one ramp for both parameters, so starting
+		//a new one restarts the countdown for whichever of the two hasn't arrived yet.
+		void rampFrequency(int voiceIndex, float frequency, float sampleRate, int rampLengthSamples) noexcept;
+		void rampGain(int voiceIndex, float gain, int rampLengthSamples) noexcept;
+
+		//adds numSamples of every voice on top of whatever is already in dest
+		void renderBlock(float* dest, int numSamples) noexcept;
+
+		//Renders a block in pieces, e.g. from several threads at once: beginBlock() once, then renderVoices() for ranges
+		//that don't overlap and start on a multiple of voiceAlignment, then endBlock() once. Each range adds its voices
+		//on top of its own dest. renderBlock() is the same sequence with a single range covering every voice.
+		void beginBlock(int numSamples) noexcept;
+		void renderVoices(float* dest, int numSamples, int firstVoice, int endVoice) noexcept;
+		void endBlock(int numSamples) noexcept;
+
+		//the arrays are padded to a whole number of cache lines, which also covers the widest SIMD group
+		static constexpr int voiceAlignment = 16;
+
+	private:
+		uint32 getPhaseIncrementForFrequency(float frequency, float sampleRate) const noexcept;
+		int getLevelForPhaseDelta(float phaseDelta) const noexcept;
+
+		static int getPaddedVoices(int voices) noexcept { return (voices + voiceAlignment - 1) / voiceAlignment * voiceAlignment; }
+
+		//zeroes the slots in [firstVoice, endVoice) in every array: silent, no ramp, phase 0 and level 0
+		void clearVoices(int firstVoice, int endVoice) noexcept;
+
+		bool prepareRamps(int numSamples) noexcept;
+		void finishRamps(int numSamples) noexcept;
+
+		template <bool isRamping>
+		void renderVoiceRange(float* dest, int numSamples, int firstVoice, int endVoice) noexcept;
+		template <bool isRamping, TableInterpolation::Mode mode>
+		void renderVoiceRange(float* dest, int numSamples, int firstVoice, int endVoice) noexcept;
+
+		static constexpr int numArrays = 12;
+
+		HeapBlock<char> storage;
+		uint32* phases = nullptr;
+		uint32* phaseIncrements = nullptr;	//what the kernel adds, exact so a steady note never drifts
+		float* phaseDeltas = nullptr;		//the same increments as floats, for the exponential ramps
+		float* gains = nullptr;
+		int32* tableIds = nullptr;
+
+		//ramp state: where each voice is heading, the per-sample steps and end values for the current block, and samples left
+		uint32* targetPhaseIncrements = nullptr;
+		float* targetGains = nullptr;
+		float* phaseDeltaRatios = nullptr;
+		float* gainSteps = nullptr;
+		float* blockEndPhaseDeltas = nullptr;
+		float* blockEndGains = nullptr;
+		int32* rampSamplesRemaining = nullptr;
+
+		int capacity = 0, numVoices = 0;
+		bool hasActiveRamps = false, isRampingBlock = false;
+
+		const WavetableSet* wavetableSet = nullptr;
+		int tableSize = 0, tableStride = 0, indexShift = 32;
+		uint32 fractionMask = 0;
+		float fractionScale = 0.0f;
+		TableInterpolation::Mode interpolation = TableInterpolation::Mode::linear;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoiceBank)
+};
@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    VoicePool.cpp
+
+  ==============================================================================
+*/
+
+#include "VoicePool.h"
+
+VoicePool::VoicePool(int capacityToUse)
+	: capacity(jmax(1, capacityToUse)),
+	states((size_t)capacity, true),
+	noteNumbers((size_t)capacity, true),
+	frequencies((size_t)capacity, true),
+	velocities((size_t)capacity, true),
+	startTimes((size_t)capacity, true)
+{
+}
+
+void VoicePool::reset() noexcept
+{
+	zeromem(states.get(), (size_t)capacity * sizeof(uint8));
+	endVoice = 0;
+	numActive = 0;
+	numReleasing = 0;
+}
+
+int VoicePool::startNote(int noteNumber, float frequency, float velocity, const float* levels) noexcept
+{
+	auto voice = 0;
+
+	while (voice < capacity && states[voice] != (uint8)State::free)
+		++voice;
+
+	if (voice == capacity)
+		voice = findVoiceToSteal(levels);
+	else
+		++numActive;
+
+	if (states[voice] == (uint8)State::releasing)
+		--numReleasing;
+
+	states[voice] = (uint8)State::playing;
+	noteNumbers[voice] = noteNumber;
+	frequencies[voice] = frequency;
+	velocities[voice] = velocity;
+	startTimes[voice] = noteCounter++;
+	endVoice = jmax(endVoice, voice + 1);
+
+	return voice;
+}
+
+void VoicePool::releaseVoice(int voice) noexcept
+{
+	jassert(isPositiveAndBelow(voice, capacity));
+
+	if (states[voice] == (uint8)State::playing)
+	{
+		states[voice] = (uint8)State::releasing;
+		++numReleasing;
+	}
+}
+
+void VoicePool::free(int voice) noexcept
+{
+	jassert(isPositiveAndBelow(voice, capacity));
+
+	if (states[voice] == (uint8)State::free)
+		return;
+
+	if (states[voice] == (uint8)State::releasing)
+		--numReleasing;
+
+	states[voice] = (uint8)State::free;
+	--numActive;
+
+	//pull the end back over any free slots at the top
+	while (endVoice > 0 && states[endVoice - 1] == (uint8)State::free)
+		--endVoice;
+}
+
+int VoicePool::findVoiceToSteal(const float* levels) const noexcept
+{
+	//a voice that is already fading out is the least noticeable one to cut, so those are looked at first
+	auto stealFrom = numReleasing > 0 ? State::releasing : State::playing;
+	auto best = -1;
+
+	for (auto voice = 0; voice < capacity; ++voice)
+	{
+		if (states[voice] != (uint8)stealFrom)
+			continue;
+
+		if (best < 0)
+		{
+			best = voice;
+		}
+		else if (policy == StealingPolicy::quietest)
+		{
+			auto level = levels != nullptr ? std::abs(levels[voice]) : velocities[voice];
+			auto bestLevel = levels != nullptr ? std::abs(levels[best]) : velocities[best];
+
+			//equally quiet voices fall back to the older one
+			if (level < bestLevel || (level == bestLevel && startTimes[voice] < startTimes[best]))
+				best = voice;
+		}
+		else if (startTimes[voice] < startTimes[best])
+		{
+			best = voice;
+		}
+	}
+
+	return jmax(0, best);
+}
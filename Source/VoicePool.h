@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    VoicePool.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+
+//Decides which voice slot plays which note, for a fixed number of slots allocated once in the constructor.
+//The pool only keeps the bookkeeping (note, frequency, velocity, age and state of every slot); the sound itself
+//lives in the VoiceBank or oscillator array that uses the same slot indices.
+//
+//A note-on takes the lowest free slot, which keeps the range of slots the renderer has to walk short. When every
+//slot is busy, a voice is stolen: a releasing one if there is any, otherwise a playing one, and within that group
+//either the one that started first or the one that is currently the quietest.
+class VoicePool
+{
+	public:
+		enum class StealingPolicy
+		{
+			oldest,
+			quietest
+		};
+
+		enum class State : uint8
+		{
+			free = 0,
+			playing,
+			releasing
+		};
+
+		explicit VoicePool(int capacity);
+
+		//frees every slot; doesn't allocate, so it can be called from the audio thread
+		void reset() noexcept;
+
+		void setStealingPolicy(StealingPolicy newPolicy) noexcept { policy = newPolicy; }
+		StealingPolicy getStealingPolicy() const noexcept { return policy; }
+
+		//Returns the slot the new note should play on, stealing one if needed.
+		//levels holds the current level of every slot for the quietest policy; without it the velocities are compared.
+		int startNote(int noteNumber, float frequency, float velocity, const float* levels = nullptr) noexcept;
+
+		//moves a playing slot into its release; free() it once the release has died away
+		void releaseVoice(int voice) noexcept;
+		void free(int voice) noexcept;
+
+		void setFrequency(int voice, float frequency) noexcept { frequencies[voice] = frequency; }
+
+		int getCapacity() const noexcept { return capacity; }
+
+		//voices that are playing or releasing
+		int getNumActive() const noexcept { return numActive; }
+		int getNumReleasing() const noexcept { return numReleasing; }
+
+		//one past the highest slot that isn't free; nothing at or above it needs rendering
+		int getEndVoice() const noexcept { return endVoice; }
+
+		State getState(int voice) const noexcept { return (State)states[voice]; }
+		int getNoteNumber(int voice) const noexcept { return noteNumbers[voice]; }
+		float getFrequency(int voice) const noexcept { return frequencies[voice]; }
+		float getVelocity(int voice) const noexcept { return velocities[voice]; }
+
+	private:
+		int findVoiceToSteal(const float* levels) const noexcept;
+
+		const int capacity;
+		HeapBlock<uint8> states;
+		HeapBlock<int> noteNumbers;
+		HeapBlock<float> frequencies, velocities;
+		HeapBlock<int64> startTimes;
+
+		StealingPolicy policy = StealingPolicy::oldest;
+		int64 noteCounter = 0;
+		int endVoice = 0, numActive = 0, numReleasing = 0;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (VoicePool)
+};
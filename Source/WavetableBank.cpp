@@ -0,0 +1,436 @@
+/*
+  ==============================================================================
+
+    WavetableBank.cpp
+
+  ==============================================================================
+*/
+
+#include "WavetableBank.h"
+#include "SimdConfig.h"
+#include "KernelDispatch.h"
+
+//the kernels index the whole bank with 32-bit lanes, which leaves plenty of room at 2^30 samples (4 GB)
+static const int64 maxBankSamples = (int64)1 << 30;
+
+//the smallest page of any platform this runs on; touching one sample in every page this size touches them all
+static const size_t samplesPerPage = 4096 / sizeof(float);
+
+//==============================================================================
+WavetableBank::Ptr WavetableBank::load(const File& file, String& errorMessage, int defaultFrameSize)
+{
+	if (! file.existsAsFile())
+	{
+		errorMessage = "Can't find " + file.getFullPathName();
+		return nullptr;
+	}
+
+	//read-only and not exclusive, so the pages are shared with every other process that maps the same file
+	std::unique_ptr<MemoryMappedFile> mappedFile (new MemoryMappedFile(file, MemoryMappedFile::readOnly));
+
+	if (mappedFile->getData() == nullptr)
+	{
+		errorMessage = "Couldn't map " + file.getFullPathName() + " into memory";
+		return nullptr;
+	}
+
+	Layout layout;
+
+	if (! parseLayout(mappedFile->getData(), mappedFile->getSize(), file.hasFileExtension("wav;wave"), defaultFrameSize, layout, errorMessage))
+	{
+		errorMessage = file.getFileName() + ": " + errorMessage;
+		return nullptr;
+	}
+
+	return new WavetableBank(file, std::move(mappedFile), layout);
+}
+
+WavetableBank::WavetableBank(const File& fileToUse, std::unique_ptr<MemoryMappedFile> mappedFileToUse, const Layout& layout)
+	: file(fileToUse),
+	mappedFile(std::move(mappedFileToUse)),
+	frames(reinterpret_cast<const float*>(static_cast<const uint8*>(mappedFile->getData()) + layout.offset)),
+	frameSize(layout.frameSize),
+	numFrames(layout.numFrames)
+{
+}
+
+bool WavetableBank::parseLayout(const void* data, size_t size, bool isWav, int defaultFrameSize, Layout& layout, String& errorMessage)
+{
+	//the samples are played where they lie, so they have to be in the machine's own byte order already
+	if (ByteOrder::isBigEndian())
+	{
+		errorMessage = "the samples are little-endian and this machine isn't";
+		return false;
+	}
+
+	auto* bytes = static_cast<const uint8*>(data);
+	errorMessage = String();
+
+	if (isWav)
+	{
+		if (! parseWavLayout(bytes, size, defaultFrameSize, layout, errorMessage))
+			return false;
+	}
+	else if (size >= (size_t)rawHeaderSize && ByteOrder::littleEndianInt(bytes) == rawMagic)
+	{
+		if (ByteOrder::littleEndianInt(bytes + 4) != rawVersion)
+		{
+			errorMessage = "WTBK version " + String(ByteOrder::littleEndianInt(bytes + 4)) + " isn't one this build can read";
+			return false;
+		}
+
+		//out-of-range values are kept out of range rather than wrapped, so the checks below catch them
+		layout.offset = (size_t)rawHeaderSize;
+		layout.frameSize = (int)jmin(ByteOrder::littleEndianInt(bytes + 8), (uint32)maxFrameSize * 2);
+		layout.numFrames = (int)jmin(ByteOrder::littleEndianInt(bytes + 12), (uint32)std::numeric_limits<int>::max());
+	}
+	else
+	{
+		//no header, so the whole file is frames of the size the caller gave
+		layout.offset = 0;
+		layout.frameSize = defaultFrameSize;
+		layout.numFrames = defaultFrameSize > 0 ? (int)jmin(size / sizeof(float) / (size_t)defaultFrameSize, (size_t)std::numeric_limits<int>::max()) : 0;
+	}
+
+	if (layout.frameSize < minFrameSize || layout.frameSize > maxFrameSize || ! isPowerOfTwo(layout.frameSize))
+		errorMessage = "a frame size of " + String(layout.frameSize) + " samples isn't a power of two from 16 to 65536";
+	else if (layout.numFrames < 1)
+		errorMessage = "there isn't a single whole frame of " + String(layout.frameSize) + " samples in it";
+	else if (layout.offset % sizeof(float) != 0)
+		errorMessage = "the samples don't start on a 4-byte boundary";
+	else if (layout.offset + (size_t)layout.numFrames * (size_t)layout.frameSize * sizeof(float) > size)
+		errorMessage = "it is shorter than its header says";
+	else if ((int64)layout.numFrames * layout.frameSize > maxBankSamples)
+		errorMessage = "it holds more than 2^30 samples";
+
+	return errorMessage.isEmpty();
+}
+
+bool WavetableBank::parseWavLayout(const uint8* data, size_t size, int defaultFrameSize, Layout& layout, String& errorMessage)
+{
+	if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0)
+	{
+		errorMessage = "it isn't a RIFF WAVE file";
+		return false;
+	}
+
+	auto frameSize = defaultFrameSize;
+	auto foundFormat = false;
+	const uint8* samples = nullptr;
+	size_t numSampleBytes = 0;
+
+	//Every chunk is a four-letter id and a little-endian length, padded to an even number of bytes. A length running
+	//past the end of the file (a recording that was cut short, or a streamed header) is trimmed to what's there.
+	for (size_t position = 12; position + 8 <= size;)
+	{
+		auto* chunk = data + position;
+		auto* body = chunk + 8;
+		auto chunkSize = (size_t)ByteOrder::littleEndianInt(chunk + 4);
+		auto available = jmin(chunkSize, size - position - 8);
+
+		if (std::memcmp(chunk, "fmt ", 4) == 0)
+		{
+			if (available < 16)
+			{
+				errorMessage = "its format chunk is cut short";
+				return false;
+			}
+
+			auto format = ByteOrder::littleEndianShort(body);
+			auto numChannels = (int)ByteOrder::littleEndianShort(body + 2);
+			auto bitsPerSample = (int)ByteOrder::littleEndianShort(body + 14);
+
+			//WAVE_FORMAT_EXTENSIBLE keeps the actual format in the first two bytes of its sub-format GUID
+			if (format == 0xfffe && available >= 26)
+				format = ByteOrder::littleEndianShort(body + 24);
+
+			//3 is WAVE_FORMAT_IEEE_FLOAT
+			if (format != 3 || bitsPerSample != 32 || numChannels != 1)
+			{
+				errorMessage = "only mono 32-bit float WAVs can be played without converting them, this one has "
+							 + String(numChannels) + " channel(s) of " + String(bitsPerSample) + "-bit " + (format == 3 ? "float" : "integer") + " samples";
+				return false;
+			}
+
+			foundFormat = true;
+		}
+		else if (std::memcmp(chunk, "clm ", 4) == 0)
+		{
+			//wavetable editors write "<!>2048 ..." here, the number being the frame size
+			if (available > 3 && std::memcmp(body, "<!>", 3) == 0)
+			{
+				auto value = 0;
+
+				for (size_t i = 3; i < available && body[i] >= '0' && body[i] <= '9' && value <= maxFrameSize; ++i)
+					value = value * 10 + (body[i] - '0');
+
+				if (value > 0)
+					frameSize = value;
+			}
+		}
+		else if (std::memcmp(chunk, "data", 4) == 0)
+		{
+			samples = body;
+			numSampleBytes = available;
+		}
+
+		position += 8 + chunkSize + (chunkSize & 1);
+	}
+
+	if (! foundFormat || samples == nullptr)
+	{
+		errorMessage = foundFormat ? "it has no data chunk" : "it has no format chunk";
+		return false;
+	}
+
+	layout.offset = (size_t)(samples - data);
+	layout.frameSize = frameSize;
+	layout.numFrames = frameSize > 0 ? (int)jmin(numSampleBytes / sizeof(float) / (size_t)frameSize, (size_t)std::numeric_limits<int>::max()) : 0;
+	return true;
+}
+
+void WavetableBank::touchFrames(float position, int numFramesEachSide) const noexcept
+{
+	auto centre = roundToInt(jlimit(0.0f, 1.0f, position) * (float)(numFrames - 1));
+	auto firstFrame = jmax(0, centre - numFramesEachSide);
+	auto endFrame = jmin(numFrames, centre + numFramesEachSide + 1);
+
+	auto* start = getFrame(firstFrame);
+	auto numSamples = (size_t)(endFrame - firstFrame) * (size_t)frameSize;
+	auto sum = 0.0f;
+
+	for (size_t sample = 0; sample < numSamples; sample += samplesPerPage)
+		sum += start[sample];
+
+	//the last page may only be partly covered by the stride above; the volatile keeps the reads from being optimised away
+	sum += start[numSamples - 1];
+	volatile float sink = sum;
+	ignoreUnused(sink);
+}
+
+//==============================================================================
+//Everything the kernels read, gathered once per block. Like the other kernels they are free functions rather than
+//members, because the AVX2 one is compiled with its own target attribute.
+struct FrameReader
+{
+	const float* frames;		//the whole bank
+	int indexShift, frameBits;
+	uint32 indexMask, fractionMask;
+	float fractionScale;
+	int maxFirstFrame;			//the last frame that still has one after it, or 0 for a bank of one frame
+	int nextFrameOffset;		//from a frame to the one after it, 0 for a bank of one frame
+
+	//The sample at phase, framePosition frames into the bank: linear between the two neighbours in each of the two
+	//frames either side, then linear between the frames. A frame has no guard sample, so the upper neighbour wraps.
+	forcedinline float getSample(uint32 phase, float framePosition) const noexcept
+	{
+		auto frame = jmin((int)framePosition, maxFirstFrame);
+		auto morph = framePosition - (float)frame;
+
+		auto index0 = phase >> indexShift;
+		auto index1 = (index0 + 1) & indexMask;
+		auto frac = (float)(phase & fractionMask) * fractionScale;
+
+		auto* first = frames + ((size_t)frame << frameBits);
+		auto* second = first + nextFrameOffset;
+		auto firstValue = first[index0] + frac * (first[index1] - first[index0]);
+		auto secondValue = second[index0] + frac * (second[index1] - second[index0]);
+
+		return firstValue + morph * (secondValue - firstValue);
+	}
+};
+
+//Same maths as FrameReader::getSample(), with every lane at its own phase and its own frame position, so a position
+//gliding through the block can cross into the next frame pair at any sample. The frame positions are worked out with
+//exactly the operations of the scalar tail. Each returns how many samples it rendered and leaves the tail to the caller.
+#if AUDIOAPP_HAS_AVX2
+AUDIOAPP_TARGET_AVX2 static int renderBankAVX2(const FrameReader& reader, float* dest, int numSamples, float gain, uint32& currentPhase,
+											   uint32 phaseDelta, float framePosition, float framePositionStep) noexcept
+{
+	const auto shiftV = _mm_cvtsi32_si128(reader.indexShift);
+	const auto frameShiftV = _mm_cvtsi32_si128(reader.frameBits);
+	const auto indexMaskV = _mm256_set1_epi32((int32)reader.indexMask);
+	const auto fractionMaskV = _mm256_set1_epi32((int32)reader.fractionMask);
+	const auto fractionScaleV = _mm256_set1_ps(reader.fractionScale);
+	const auto maxFirstFrameV = _mm256_set1_epi32(reader.maxFirstFrame);
+	const auto oneV = _mm256_set1_epi32(1);
+	const auto gainV = _mm256_set1_ps(gain);
+	const auto framePositionV = _mm256_set1_ps(framePosition);
+	const auto framePositionStepV = _mm256_set1_ps(framePositionStep);
+	const auto* secondFrames = reader.frames + reader.nextFrameOffset;
+
+	const auto lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const auto laneDeltas = _mm256_mullo_epi32(lanes, _mm256_set1_epi32((int32)phaseDelta));
+	const auto groupDelta = phaseDelta * 8;
+	auto sample = 0;
+
+	for (; sample + 8 <= numSamples; sample += 8)
+	{
+		auto phase = _mm256_add_epi32(_mm256_set1_epi32((int32)currentPhase), laneDeltas);
+		auto index0 = _mm256_srl_epi32(phase, shiftV);
+		auto index1 = _mm256_and_si256(_mm256_add_epi32(index0, oneV), indexMaskV);
+		auto frac = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(phase, fractionMaskV)), fractionScaleV);
+
+		//each lane's frame pair, as the offset of its first frame from the start of the bank
+		auto sampleIndices = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(sample), lanes));
+		auto positions = _mm256_add_ps(framePositionV, _mm256_mul_ps(framePositionStepV, sampleIndices));
+		auto frame = _mm256_min_epi32(_mm256_cvttps_epi32(positions), maxFirstFrameV);
+		auto morph = _mm256_sub_ps(positions, _mm256_cvtepi32_ps(frame));
+		auto frameStart = _mm256_sll_epi32(frame, frameShiftV);
+		auto offset0 = _mm256_add_epi32(frameStart, index0);
+		auto offset1 = _mm256_add_epi32(frameStart, index1);
+
+		auto first0 = _mm256_i32gather_ps(reader.frames, offset0, 4);
+		auto first1 = _mm256_i32gather_ps(reader.frames, offset1, 4);
+		auto second0 = _mm256_i32gather_ps(secondFrames, offset0, 4);
+		auto second1 = _mm256_i32gather_ps(secondFrames, offset1, 4);
+		auto firstValues = _mm256_add_ps(first0, _mm256_mul_ps(frac, _mm256_sub_ps(first1, first0)));
+		auto secondValues = _mm256_add_ps(second0, _mm256_mul_ps(frac, _mm256_sub_ps(second1, second0)));
+		auto currentSamples = _mm256_add_ps(firstValues, _mm256_mul_ps(morph, _mm256_sub_ps(secondValues, firstValues)));
+
+		auto* out = dest + sample;
+		_mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(out), _mm256_mul_ps(currentSamples, gainV)));
+
+		currentPhase += groupDelta;
+	}
+
+	_mm256_zeroupper();
+	return sample;
+}
+#endif
+
+#if AUDIOAPP_HAS_SSE2
+static int renderBankSSE2(const FrameReader& reader, float* dest, int numSamples, float gain, uint32& currentPhase,
+						  uint32 phaseDelta, float framePosition, float framePositionStep) noexcept
+{
+	const auto shiftV = _mm_cvtsi32_si128(reader.indexShift);
+	const auto frameShiftV = _mm_cvtsi32_si128(reader.frameBits);
+	const auto indexMaskV = _mm_set1_epi32((int32)reader.indexMask);
+	const auto fractionMaskV = _mm_set1_epi32((int32)reader.fractionMask);
+	const auto fractionScaleV = _mm_set1_ps(reader.fractionScale);
+	const auto maxFirstFrameV = _mm_set1_epi32(reader.maxFirstFrame);
+	const auto oneV = _mm_set1_epi32(1);
+	const auto gainV = _mm_set1_ps(gain);
+	const auto framePositionV = _mm_set1_ps(framePosition);
+	const auto framePositionStepV = _mm_set1_ps(framePositionStep);
+	const auto* frames = reader.frames;
+	const auto* secondFrames = reader.frames + reader.nextFrameOffset;
+
+	const auto lanes = _mm_setr_epi32(0, 1, 2, 3);
+	const auto laneDeltas = _mm_setr_epi32(0, (int32)phaseDelta, (int32)(phaseDelta * 2), (int32)(phaseDelta * 3));
+	const auto groupDelta = phaseDelta * 4;
+
+	alignas(16) int32 offsets0[4], offsets1[4];
+	auto sample = 0;
+
+	for (; sample + 4 <= numSamples; sample += 4)
+	{
+		auto phase = _mm_add_epi32(_mm_set1_epi32((int32)currentPhase), laneDeltas);
+		auto index0 = _mm_srl_epi32(phase, shiftV);
+		auto index1 = _mm_and_si128(_mm_add_epi32(index0, oneV), indexMaskV);
+		auto frac = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(phase, fractionMaskV)), fractionScaleV);
+
+		//SSE2 has no integer min, so the frames past the last pair are swapped for it with a compare and a select
+		auto sampleIndices = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(sample), lanes));
+		auto positions = _mm_add_ps(framePositionV, _mm_mul_ps(framePositionStepV, sampleIndices));
+		auto frame = _mm_cvttps_epi32(positions);
+		auto isPastLast = _mm_cmpgt_epi32(frame, maxFirstFrameV);
+		frame = _mm_or_si128(_mm_and_si128(isPastLast, maxFirstFrameV), _mm_andnot_si128(isPastLast, frame));
+		auto morph = _mm_sub_ps(positions, _mm_cvtepi32_ps(frame));
+		auto frameStart = _mm_sll_epi32(frame, frameShiftV);
+
+		//no gather either, so the offsets go through memory once and the loads are done in scalar
+		_mm_store_si128((__m128i*)offsets0, _mm_add_epi32(frameStart, index0));
+		_mm_store_si128((__m128i*)offsets1, _mm_add_epi32(frameStart, index1));
+
+		auto first0 = _mm_setr_ps(frames[offsets0[0]], frames[offsets0[1]], frames[offsets0[2]], frames[offsets0[3]]);
+		auto first1 = _mm_setr_ps(frames[offsets1[0]], frames[offsets1[1]], frames[offsets1[2]], frames[offsets1[3]]);
+		auto second0 = _mm_setr_ps(secondFrames[offsets0[0]], secondFrames[offsets0[1]], secondFrames[offsets0[2]], secondFrames[offsets0[3]]);
+		auto second1 = _mm_setr_ps(secondFrames[offsets1[0]], secondFrames[offsets1[1]], secondFrames[offsets1[2]], secondFrames[offsets1[3]]);
+		auto firstValues = _mm_add_ps(first0, _mm_mul_ps(frac, _mm_sub_ps(first1, first0)));
+		auto secondValues = _mm_add_ps(second0, _mm_mul_ps(frac, _mm_sub_ps(second1, second0)));
+		auto currentSamples = _mm_add_ps(firstValues, _mm_mul_ps(morph, _mm_sub_ps(secondValues, firstValues)));
+
+		auto* out = dest + sample;
+		_mm_storeu_ps(out, _mm_add_ps(_mm_loadu_ps(out), _mm_mul_ps(currentSamples, gainV)));
+
+		currentPhase += groupDelta;
+	}
+
+	return sample;
+}
+#endif
+
+//==============================================================================
+void WavetableBankOscillator::setBank(const WavetableBank* newBank) noexcept
+{
+	bank = newBank;
+
+	if (bank == nullptr)
+		return;
+
+	//the phase is a fraction of a cycle, so it carries over to a bank of any frame size
+	indexShift = FixedPointPhase::getIndexShift(bank->getFrameSize());
+	frameBits = 32 - indexShift;
+	indexMask = (uint32)bank->getFrameSize() - 1;
+	fractionMask = FixedPointPhase::getFractionMask(indexShift);
+	fractionScale = FixedPointPhase::getFractionScale(indexShift);
+}
+
+void WavetableBankOscillator::setFrequency(float frequency, float sampleRate) noexcept
+{
+	phaseDelta = FixedPointPhase::getIncrement(frequency, sampleRate);
+}
+
+void WavetableBankOscillator::setPosition(float newPosition) noexcept
+{
+	targetPosition = jlimit(0.0f, 1.0f, newPosition);
+}
+
+void WavetableBankOscillator::reset() noexcept
+{
+	currentPhase = 0;
+	position = targetPosition;
+}
+
+void WavetableBankOscillator::renderBlock(float* dest, int numSamples, float gain) noexcept
+{
+	if (bank == nullptr)
+		return;
+
+	auto numFrames = bank->getNumFrames();
+	FrameReader reader { bank->getFrames(), indexShift, frameBits, indexMask, fractionMask, fractionScale,
+						 jmax(0, numFrames - 2), numFrames > 1 ? bank->getFrameSize() : 0 };
+
+	//the position glides from where the last block left it to the target, measured in frames from here on
+	auto lastFrame = (float)(numFrames - 1);
+	auto framePosition = position * lastFrame;
+	auto framePositionStep = (targetPosition - position) * lastFrame / (float)numSamples;
+	auto sample = 0;
+
+	switch (KernelDispatch::getActiveLevel())
+	{
+	   #if AUDIOAPP_HAS_AVX2
+		case KernelDispatch::Level::avx512:
+		case KernelDispatch::Level::avx2:
+			sample = renderBankAVX2(reader, dest, numSamples, gain, currentPhase, phaseDelta, framePosition, framePositionStep);
+			break;
+	   #endif
+	   #if AUDIOAPP_HAS_SSE2
+		case KernelDispatch::Level::sse2:
+			sample = renderBankSSE2(reader, dest, numSamples, gain, currentPhase, phaseDelta, framePosition, framePositionStep);
+			break;
+	   #endif
+		default:
+			break;
+	}
+
+	//whatever doesn't fill a whole vector (or everything, with the scalar kernels)
+	for (; sample < numSamples; ++sample)
+	{
+		dest[sample] += reader.getSample(currentPhase, framePosition + framePositionStep * (float)sample) * gain;
+		currentPhase += phaseDelta;
+	}
+
+	position = targetPosition;
+}
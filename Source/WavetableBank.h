@@ -0,0 +1,122 @@
+/*
+  ==============================================================================
+
+    WavetableBank.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "FixedPointPhase.h"
+
+
+//A wavetable made of many single-cycle frames (typically 256 frames of 2048 samples) that a voice sweeps through,
+//played straight out of a memory-mapped file.
+//
+//The file is mapped read-only and shared, and the frames are never copied: loading only reads the header, and
+//a page of samples is read from disk the first time a voice plays it. The pages belong to the OS file cache, so
+//every process that plays the same bank shares one copy, and the OS can drop them again under memory pressure
+//without any swapping. Banks of hundreds of megabytes therefore load instantly and cost only what is played.
+//
+//Two layouts are understood:
+//	WAV		mono 32-bit float, frames back to back. The frame size comes from a "clm " chunk ("<!>2048 ...")
+//			when there is one, as wavetable synths write it, otherwise from the caller.
+//	raw		the "WTBK" header below followed by the frames as little-endian 32-bit floats, or with no header at all,
+//			in which case the caller's frame size applies
+//Anything else (16-bit WAVs, stereo, ...) would have to be converted into memory first, which is exactly what this
+//class is for avoiding, so it is refused with a message saying why.
+//
+//The frames are played as they are, without mipmaps: building those would mean reading the whole bank.
+//High notes of bright frames alias accordingly.
+class WavetableBank : public ReferenceCountedObject
+{
+	public:
+		using Ptr = ReferenceCountedObjectPtr<WavetableBank>;
+
+		//Maps the file and checks its layout. Returns nullptr and says why in errorMessage if it can't be played.
+		//defaultFrameSize is used when the file doesn't say, and has to be a power of two like every frame size.
+		static Ptr load(const File& file, String& errorMessage, int defaultFrameSize = 2048);
+
+		const File& getFile() const noexcept	{ return file; }
+		int getFrameSize() const noexcept		{ return frameSize; }
+		int getNumFrames() const noexcept		{ return numFrames; }
+
+		//every frame back to back, frameSize samples each with no guard sample; this is the mapped file itself
+		const float* getFrames() const noexcept				{ return frames; }
+		const float* getFrame(int frame) const noexcept		{ return frames + (size_t)frame * (size_t)frameSize; }
+
+		//Reads one sample from every page of the frames either side of the position (0 is the first frame, 1 the last),
+		//so whoever plays them next finds them in memory. Call it from the message thread whenever the position jumps,
+		//so the page faults happen there instead of on the audio thread.
+		void touchFrames(float position, int numFramesEachSide = 2) const noexcept;
+
+		//the header of the raw layout: the magic, the version, then the frame size and count, all little-endian uint32
+		static constexpr uint32 rawMagic = 0x4b425457;	//"WTBK"
+		static constexpr uint32 rawVersion = 1;
+		static constexpr int rawHeaderSize = 16;
+
+		static constexpr int minFrameSize = 16;
+		static constexpr int maxFrameSize = 1 << 16;
+
+	private:
+		//where the frames are inside a mapped file, and how big they are
+		struct Layout
+		{
+			size_t offset = 0;
+			int frameSize = 0, numFrames = 0;
+		};
+
+		WavetableBank(const File& file, std::unique_ptr<MemoryMappedFile> mappedFile, const Layout& layout);
+
+		//works out the layout from the start of the mapped file; false with errorMessage set if it can't be played
+		static bool parseLayout(const void* data, size_t size, bool isWav, int defaultFrameSize, Layout& layout, String& errorMessage);
+		static bool parseWavLayout(const uint8* data, size_t size, int defaultFrameSize, Layout& layout, String& errorMessage);
+
+		const File file;
+		std::unique_ptr<MemoryMappedFile> mappedFile;
+		const float* frames;
+		const int frameSize, numFrames;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetableBank)
+};
+
+//==============================================================================
+//Plays a WavetableBank at one pitch, interpolating within each frame and between the two frames either side of
+//its position, so sweeping the position morphs smoothly from one frame into the next.
+//
+//The phase is the same FixedPointPhase as the other wavetable voices. Each output sample reads four table values,
+//two neighbours in two neighbouring frames; the vector kernels do that with gathers for 8 (AVX2) or 4 (SSE2)
+//samples at a time, each lane with its own frame pair, so the position can glide within a block.
+class WavetableBankOscillator
+{
+	public:
+		WavetableBankOscillator() {}
+
+		//The bank to play, or nullptr for silence; the caller keeps it alive for as long as this renders from it.
+		//The phase and the position carry over, so a new bank takes over mid-note.
+		void setBank(const WavetableBank* newBank) noexcept;
+		const WavetableBank* getBank() const noexcept		{ return bank; }
+
+		void setFrequency(float frequency, float sampleRate) noexcept;
+
+		//0 plays the first frame, 1 the last; reached by the end of the next rendered block, so moving it doesn't click
+		void setPosition(float newPosition) noexcept;
+
+		//back to the start of the cycle, with the position jumping straight to its target
+		void reset() noexcept;
+
+		//adds numSamples of the oscillator, scaled by gain, on top of whatever is already in dest
+		void renderBlock(float* dest, int numSamples, float gain) noexcept;
+
+	private:
+		const WavetableBank* bank = nullptr;
+		uint32 currentPhase = 0, phaseDelta = 0;	//FixedPointPhase units: the top bits index the frame
+		int indexShift = 32, frameBits = 0;		//frameBits is log2 of the frame size
+		uint32 indexMask = 0, fractionMask = 0;
+		float fractionScale = 0.0f;
+		float position = 0.0f, targetPosition = 0.0f;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetableBankOscillator)
+};
@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    WavetableCache.cpp
+
+  ==============================================================================
+*/
+
+#include "WavetableCache.h"
+
+//the shapes prefetch() builds, which is every one in the waveform selector
+static const WavetableSet::Shape stockShapes[] = { WavetableSet::Shape::sine, WavetableSet::Shape::triangle, WavetableSet::Shape::harmonics,
+												   WavetableSet::Shape::saw, WavetableSet::Shape::square, WavetableSet::Shape::noise };
+
+bool WavetableCache::Key::operator== (const Key& other) const noexcept
+{
+	//the hash only narrows it down, two spectra that collide still get a set each
+	return shape == other.shape && tableSize == other.tableSize && levelsPerOctave == other.levelsPerOctave
+		&& spectrumHash == other.spectrumHash && spectrum == other.spectrum;
+}
+
+int WavetableCache::KeyHash::generateHash(const Key& key, int upperLimit) const noexcept
+{
+	auto hash = key.spectrumHash ^ ((uint64)key.shape << 40) ^ ((uint64)key.tableSize << 8) ^ (uint64)key.levelsPerOctave;
+	hash ^= hash >> 29;
+	return (int)(hash % (uint64)upperLimit);
+}
+
+//==============================================================================
+WavetableCache::WavetableCache()
+{
+}
+
+WavetableCache::~WavetableCache()
+{
+	//the jobs write into sets, so they have to be gone before it is; none of them takes more than a few milliseconds
+	builder.removeAllJobs(true, 10000);
+}
+
+void WavetableCache::prefetch(int tableSize, int levelsPerOctave)
+{
+	for (auto shape : stockShapes)
+	{
+		Key key { shape, tableSize, levelsPerOctave, 0, {} };
+
+		if (find(key) != nullptr)
+			continue;
+
+		builder.addJob([this, key]
+		{
+			//a getSet() on another thread may have beaten this job to it
+			if (find(key) == nullptr)
+				insert(key, new WavetableSet(key.shape, key.tableSize, key.levelsPerOctave));
+		});
+	}
+}
+
+WavetableSet::Ptr WavetableCache::getSet(WavetableSet::Shape shape, int tableSize, int levelsPerOctave)
+{
+	jassert(shape != WavetableSet::Shape::custom);
+	Key key { shape, tableSize, levelsPerOctave, 0, {} };
+
+	if (auto set = find(key))
+		return set;
+
+	return insert(key, new WavetableSet(shape, tableSize, levelsPerOctave));
+}
+
+WavetableSet::Ptr WavetableCache::getSet(const float* magnitudes, const float* phases, int numHarmonics, int tableSize, int levelsPerOctave)
+{
+	auto key = makeCustomKey(magnitudes, phases, numHarmonics, tableSize, levelsPerOctave);
+
+	if (auto set = find(key))
+		return set;
+
+	return insert(key, new WavetableSet(magnitudes, phases, numHarmonics, tableSize, levelsPerOctave));
+}
+
+WavetableBank::Ptr WavetableCache::getBank(const File& file, String& errorMessage, int defaultFrameSize)
+{
+	auto key = file.getFullPathName() + "|" + String(file.getLastModificationTime().toMilliseconds()) + "|" + String(defaultFrameSize);
+	const ScopedLock sl(lock);
+
+	if (banks.contains(key))
+		return banks[key];
+
+	auto bank = WavetableBank::load(file, errorMessage, defaultFrameSize);
+
+	if (bank != nullptr)
+		banks.set(key, bank);
+
+	return bank;
+}
+
+int WavetableCache::getNumSets() const
+{
+	const ScopedLock sl(lock);
+	return sets.size();
+}
+
+void WavetableCache::collectGarbage()
+{
+	const ScopedLock sl(lock);
+	Array<Key> unused;
+
+	//A set an engine has published or retired still has those references, so only the ones it has let go of are dropped.
+	//The count is read through getReference(), since the iterator hands out copies that would add one of their own.
+	for (HashMap<Key, WavetableSet::Ptr, KeyHash>::Iterator i (sets); i.next();)
+		if (i.getKey().shape == WavetableSet::Shape::custom && sets.getReference(i.getKey())->getReferenceCount() == 1)
+			unused.add(i.getKey());
+
+	for (auto& key : unused)
+		sets.remove(key);
+}
+
+WavetableSet::Ptr WavetableCache::find(const Key& key) const
+{
+	const ScopedLock sl(lock);
+	return sets.contains(key) ? sets[key] : WavetableSet::Ptr();
+}
+
+WavetableSet::Ptr WavetableCache::insert(const Key& key, WavetableSet::Ptr set)
+{
+	const ScopedLock sl(lock);
+
+	if (sets.contains(key))
+		return sets[key];
+
+	sets.set(key, set);
+	return set;
+}
+
+WavetableCache::Key WavetableCache::makeCustomKey(const float* magnitudes, const float* phases, int numHarmonics,
+												  int tableSize, int levelsPerOctave)
+{
+	Key key { WavetableSet::Shape::custom, tableSize, levelsPerOctave, hashSpectrum(magnitudes, phases, numHarmonics), {} };
+	key.spectrum.addArray(magnitudes, numHarmonics + 1);
+
+	//a null phase array means all zeros, and is stored that way so it matches one spelled out
+	for (auto n = 0; n <= numHarmonics; ++n)
+		key.spectrum.add(phases != nullptr ? phases[n] : 0.0f);
+
+	return key;
+}
+
+uint64 WavetableCache::hashSpectrum(const float* magnitudes, const float* phases, int numHarmonics) noexcept
+{
+	//64-bit FNV-1a over the bits of both arrays; a null phase array hashes like one full of zeros, which is what it means
+	auto hash = (uint64)14695981039346656037ull;
+	auto addFloat = [&hash] (float value)
+	{
+		uint32 bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		for (auto byte = 0; byte < 4; ++byte)
+		{
+			hash ^= (bits >> (byte * 8)) & 0xff;
+			hash *= 1099511628211ull;
+		}
+	};
+
+	for (auto n = 0; n <= numHarmonics; ++n)
+	{
+		addFloat(magnitudes[n]);
+		addFloat(phases != nullptr ? phases[n] : 0.0f);
+	}
+
+	//0 is what the stock shapes use
+	return hash != 0 ? hash : 1;
+}
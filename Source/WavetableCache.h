@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    WavetableCache.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "WavetableSet.h"
+#include "WavetableBank.h"
+
+
+//Every wavetable set the process has built, keyed by shape, table size, levels per octave and, for custom sets,
+//the spectrum they were built from. Sets are immutable, so one copy can be shared by every engine that asks for it.
+//
+//prefetch() builds the stock shapes for a table size on a background thread, so by the time anyone switches
+//waveform the set is already here and getSet() is a hash lookup. Asking for a set that isn't built yet
+//builds it on the calling thread instead of waiting for the background one.
+//
+//Hold it through a SharedResourcePointer<WavetableCache>; it lives as long as anything is still pointing at it.
+//That makes it one store per process, so in the plugin build every instance a host loads plays from the same
+//sets instead of building its own copies.
+//Wavetable banks are kept here too, by file, so every engine that plays one shares a single mapping of it.
+//
+//All calls are thread safe, but none of them belong on the audio thread.
+class WavetableCache
+{
+	public:
+		WavetableCache();
+		~WavetableCache();
+
+		//queues every stock shape at this resolution that isn't cached yet, and returns straight away
+		void prefetch(int tableSize, int levelsPerOctave = 1);
+
+		//the set for a stock shape, built here if nothing has built it yet
+		WavetableSet::Ptr getSet(WavetableSet::Shape shape, int tableSize, int levelsPerOctave = 1);
+
+		//the set for an arbitrary spectrum, laid out as in the WavetableSet constructor; identical spectra share a set
+		WavetableSet::Ptr getSet(const float* magnitudes, const float* phases, int numHarmonics, int tableSize, int levelsPerOctave = 1);
+
+		//The bank in the file, mapped here the first time anyone asks for it and shared from then on; a file that has
+		//changed since is mapped again. Returns nullptr with errorMessage set if WavetableBank::load() can't play it.
+		WavetableBank::Ptr getBank(const File& file, String& errorMessage, int defaultFrameSize = 2048);
+
+		int getNumSets() const;
+
+		//Drops the custom sets nobody but the cache points at any more, so regenerating a spectrum over and over doesn't
+		//keep every version of it. The stock shapes stay: there are only a few per table size and they're asked for again.
+		void collectGarbage();
+
+	private:
+		struct Key
+		{
+			WavetableSet::Shape shape;
+			int tableSize, levelsPerOctave;
+			uint64 spectrumHash;	//0 for the stock shapes
+			Array<float> spectrum;	//the magnitudes then the phases, compared when the hashes match; empty for the stock shapes
+
+			bool operator== (const Key& other) const noexcept;
+			bool operator!= (const Key& other) const noexcept	{ return ! operator== (other); }
+		};
+
+		struct KeyHash
+		{
+			int generateHash(const Key& key, int upperLimit) const noexcept;
+		};
+
+		static uint64 hashSpectrum(const float* magnitudes, const float* phases, int numHarmonics) noexcept;
+		static Key makeCustomKey(const float* magnitudes, const float* phases, int numHarmonics, int tableSize, int levelsPerOctave);
+
+		WavetableSet::Ptr find(const Key& key) const;
+
+		//keeps whichever set got here first, so two threads that built the same key end up sharing one
+		WavetableSet::Ptr insert(const Key& key, WavetableSet::Ptr set);
+
+		CriticalSection lock;
+		HashMap<Key, WavetableSet::Ptr, KeyHash> sets;
+
+		//keyed by path, modification time and default frame size; mapping only reads the header, so it happens under the lock
+		HashMap<String, WavetableBank::Ptr> banks;
+
+		//One thread is plenty: each set is a handful of FFTs, and this stays off the cores the audio workers use.
+		//Declared last, so it's gone before the map its jobs write into.
+		ThreadPool builder { 1 };
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetableCache)
+};
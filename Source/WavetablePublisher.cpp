@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    WavetablePublisher.cpp
+
+  ==============================================================================
+*/
+
+#include "WavetablePublisher.h"
+#include "WavetableSet.h"
+#include "WavetableBank.h"
+
+template <typename SetType>
+WavetablePublisher<SetType>::~WavetablePublisher()
+{
+	collectGarbage();
+
+	if (auto* unclaimed = pending.exchange(nullptr))
+		unclaimed->decReferenceCount();
+
+	if (current != nullptr)
+		current->decReferenceCount();
+}
+
+template <typename SetType>
+void WavetablePublisher<SetType>::publish(typename SetType::Ptr newSet)
+{
+	jassert(newSet != nullptr);
+
+	//the pending slot owns one reference; whoever takes a set out of it takes that reference with it
+	newSet->incReferenceCount();
+
+	if (auto* unclaimed = pending.exchange(newSet.get(), std::memory_order_acq_rel))
+		unclaimed->decReferenceCount();
+}
+
+template <typename SetType>
+SetType* WavetablePublisher<SetType>::acquire() noexcept
+{
+	//With nowhere to put the outgoing set, keep the current one for another block rather than free it here.
+	//Only this thread writes to the FIFO, so the free space can only grow before the write below.
+	if (retiredFifo.getFreeSpace() == 0)
+		return current;
+
+	auto* incoming = pending.exchange(nullptr, std::memory_order_acq_rel);
+
+	if (incoming == nullptr)
+		return current;
+
+	if (current != nullptr)
+	{
+		int start1, size1, start2, size2;
+		retiredFifo.prepareToWrite(1, start1, size1, start2, size2);
+		jassert(size1 + size2 == 1);
+
+		retiredSets[size1 > 0 ? start1 : start2] = current;
+		retiredFifo.finishedWrite(1);
+	}
+
+	current = incoming;
+	return current;
+}
+
+template <typename SetType>
+void WavetablePublisher<SetType>::collectGarbage()
+{
+	int start1, size1, start2, size2;
+	retiredFifo.prepareToRead(retiredFifo.getNumReady(), start1, size1, start2, size2);
+
+	for (auto i = 0; i < size1; ++i)
+		retiredSets[start1 + i]->decReferenceCount();
+
+	for (auto i = 0; i < size2; ++i)
+		retiredSets[start2 + i]->decReferenceCount();
+
+	retiredFifo.finishedRead(size1 + size2);
+}
+
+//the only two kinds of set there are, so the definitions can stay out of the header
+template class WavetablePublisher<WavetableSet>;
+template class WavetablePublisher<WavetableBank>;
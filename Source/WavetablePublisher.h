@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    WavetablePublisher.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+
+//Hands wavetable sets from the message thread to the audio thread without locks, RCU style.
+//A set is built completely off the audio thread and published with an atomic exchange. The audio thread picks it
+//up at the start of a block, and the set it replaces goes into a FIFO instead of being freed. collectGarbage() on the
+//message thread drops those references later, so the audio callback never waits, allocates, frees or sees a half-written table.
+//
+//SetType is any ReferenceCountedObject with a Ptr; it is instantiated for WavetableSet and WavetableBank.
+template <typename SetType>
+class WavetablePublisher
+{
+	public:
+		WavetablePublisher() {}
+
+		//the audio callback has to be stopped before this runs
+		~WavetablePublisher();
+
+		//message thread: queues a fully built set; if the audio thread never picked up the previous one, that one is dropped here
+		void publish(typename SetType::Ptr newSet);
+
+		//audio thread: returns the set to render this block with, switching to a newly published one if there is one
+		SetType* acquire() noexcept;
+
+		//message thread: releases the sets the audio thread has retired
+		void collectGarbage();
+
+	private:
+		static constexpr int maxRetiredSets = 32;
+
+		std::atomic<SetType*> pending { nullptr };
+		SetType* current = nullptr; //only ever touched by the audio thread
+
+		AbstractFifo retiredFifo { maxRetiredSets };
+		SetType* retiredSets[maxRetiredSets] = {};
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetablePublisher)
+};
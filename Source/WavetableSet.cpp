@@ -0,0 +1,159 @@
+/*
+  ==============================================================================
+
+    WavetableSet.cpp
+
+  ==============================================================================
+*/
+
+#include "WavetableSet.h"
+#include "SpectralWavetableBuilder.h"
+
+//the noise table's phases
+static const int64 noiseSeed = 0x41415745;
+
+WavetableSet::WavetableSet(Shape shapeToUse, int size, int levels)
+	: shape(shapeToUse), tableSize(size), levelsPerOctave(levels)
+{
+	jassert(shape != Shape::custom);
+	allocateLevels();
+
+	//Index n holds the amplitude and phase of harmonic n.
+	auto numHarmonics = tableSize / 2;
+	HeapBlock<float> amplitudes((size_t)numHarmonics + 1, true);
+	HeapBlock<float> phases((size_t)numHarmonics + 1, true);
+
+	switch (shape)
+	{
+		case Shape::sine:
+			amplitudes[1] = 1.0f;
+			break;
+
+		case Shape::triangle:
+			//odd harmonics falling at 1/n^2, as cosines so the ramp starts at -1 like the old table
+			for (auto n = 1; n <= numHarmonics; n += 2)
+			{
+				amplitudes[n] = -8.0f / (MathConstants<float>::pi * MathConstants<float>::pi * (float)(n * n));
+				phases[n] = MathConstants<float>::halfPi;
+			}
+			break;
+
+		case Shape::harmonics:
+		{
+			//additive SAW with 8 harmonics, 180 degrees out of phase for an upward ramp
+			int harmonics[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+			float harmonicWeights[] = { 1.0f, 0.5f, 0.33333333f, 0.25f, 0.2f, 0.16666666f, 0.142857142f, 0.125f };
+
+			jassert(numElementsInArray(harmonics) == numElementsInArray(harmonicWeights));
+			for (auto harmonic = 0; harmonic < numElementsInArray(harmonics); ++harmonic)
+			{
+				if (harmonics[harmonic] <= numHarmonics)
+				{
+					amplitudes[harmonics[harmonic]] = harmonicWeights[harmonic];
+					phases[harmonics[harmonic]] = MathConstants<float>::pi;
+				}
+			}
+			break;
+		}
+
+		case Shape::saw:
+			//every harmonic at 1/n, negated so the ramp rises from -1 to 1
+			for (auto n = 1; n <= numHarmonics; ++n)
+				amplitudes[n] = -2.0f / (MathConstants<float>::pi * (float)n);
+			break;
+
+		case Shape::square:
+			//odd harmonics at 1/n, low for the first half of the cycle and high for the second
+			for (auto n = 1; n <= numHarmonics; n += 2)
+				amplitudes[n] = -4.0f / (MathConstants<float>::pi * (float)n);
+			break;
+
+		case Shape::noise:
+		{
+			//Flat spectrum with random phases, which is white noise limited to the level's band. The seed is fixed,
+			//so every run (and every replay of an event log) plays the same noise.
+			Random random(noiseSeed);
+			for (auto n = 1; n <= numHarmonics; ++n)
+			{
+				amplitudes[n] = 1.0f;
+				phases[n] = random.nextFloat() * MathConstants<float>::twoPi;
+			}
+			break;
+		}
+
+		default:
+			jassertfalse;
+			break;
+	}
+
+	fillLevels(amplitudes, phases, numHarmonics);
+}
+
+WavetableSet::WavetableSet(const float* magnitudes, const float* phases, int numHarmonics, int size, int levels)
+	: shape(Shape::custom), tableSize(size), levelsPerOctave(levels)
+{
+	allocateLevels();
+	fillLevels(magnitudes, phases, jmin(numHarmonics, tableSize / 2));
+}
+
+void WavetableSet::allocateLevels()
+{
+	jassert(isPowerOfTwo(tableSize) && tableSize >= 4);
+	jassert(levelsPerOctave == 1 || levelsPerOctave == 2);
+
+	//one level per (half) octave from tableSize / 2 harmonics down to a single one
+	auto numOctaves = 0;
+	while ((2 << numOctaves) < tableSize)
+		++numOctaves;
+
+	numLevels = numOctaves * levelsPerOctave + 1;
+	tables.calloc((size_t)(numLevels * getTableStride()));
+}
+
+void WavetableSet::fillLevels(const float* magnitudes, const float* phases, int numHarmonics)
+{
+	//Every level is built from the same spectrum, only cut off at a lower harmonic, so the timbre stays
+	//consistent when an oscillator moves between levels. Each one costs a single inverse FFT.
+	SpectralWavetableBuilder builder(tableSize);
+
+	for (auto level = 0; level < numLevels; ++level)
+	{
+		auto* samples = tables.get() + level * getTableStride() + TableInterpolation::guardSamplesBefore;
+		builder.buildTable(samples, magnitudes, phases, jmin(numHarmonics, getMaxHarmonic(level)));
+
+		//the builder already wrote the first guard sample behind the table, the rest wrap around the same way
+		for (auto i = 1; i < TableInterpolation::guardSamplesAfter; ++i)
+			samples[tableSize + i] = samples[i];
+
+		for (auto i = 1; i <= TableInterpolation::guardSamplesBefore; ++i)
+			samples[-i] = samples[tableSize - i];
+	}
+
+	//scale every level by the same amount, taken from the fullest one, so the loudness doesn't jump between levels
+	auto peak = 0.0f;
+	auto* fullest = getTable(0);
+	for (auto i = 0; i < tableSize; ++i)
+		peak = jmax(peak, std::abs(fullest[i]));
+
+	if (peak > 0.0f)
+		FloatVectorOperations::multiply(tables, 1.0f / peak, numLevels * getTableStride());
+}
+
+int WavetableSet::getMaxHarmonic(int level) const noexcept
+{
+	jassert(isPositiveAndBelow(level, numLevels));
+
+	auto maxHarmonic = (int)((float)(tableSize / 2) * std::exp2(-(float)level / (float)levelsPerOctave));
+	return jmax(1, maxHarmonic);
+}
+
+int WavetableSet::getLevelForPhaseDelta(float tableDelta) const noexcept
+{
+	//An oscillator stepping tableDelta samples through the table can play tableSize / (2 * tableDelta) harmonics
+	//before reaching Nyquist. Level 0 holds tableSize / 2 of them, and every level divides that by 2^(1 / levelsPerOctave).
+	if (tableDelta <= 1.0f)
+		return 0;
+
+	auto level = (int)std::ceil((float)levelsPerOctave * std::log2(tableDelta));
+	return jmin(level, numLevels - 1);
+}
@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    WavetableSet.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "TableInterpolation.h"
+
+
+//A mipmap of band-limited wavetables for one waveform.
+//Level 0 holds every harmonic the table can represent (tableSize / 2), and each following level drops
+//the top octave (or half octave), down to a plain sine in the last level. An oscillator picks the level whose 
+//highest harmonic still sits below Nyquist at the note it plays, so the output is alias-free without
+//oversampling or BLEP corrections at runtime.
+//Sets are immutable once built and reference counted, so they can be handed to the audio thread and released later.
+class WavetableSet : public ReferenceCountedObject
+{
+	public:
+		using Ptr = ReferenceCountedObjectPtr<WavetableSet>;
+
+		//same order as the waveform selector in MainComponent
+		enum class Shape
+		{
+			sine = 0,
+			triangle,
+			harmonics,
+			saw,
+			square,
+			noise,
+			custom
+		};
+
+		//tableSize has to be a power of two; levelsPerOctave is 1 for octave steps or 2 for half-octave steps
+		WavetableSet(Shape shape, int tableSize, int levelsPerOctave = 1);
+
+		//builds the set from an arbitrary spectrum, laid out as in SpectralWavetableBuilder::buildTable()
+		//(numHarmonics + 1 entries indexed by harmonic number, up to tableSize / 2 harmonics, phases may be nullptr)
+		WavetableSet(const float* magnitudes, const float* phases, int numHarmonics, int tableSize, int levelsPerOctave = 1);
+
+		Shape getShape() const noexcept { return shape; }
+		int getTableSize() const noexcept { return tableSize; }
+		int getNumLevels() const noexcept { return numLevels; }
+
+		//All levels back to back, getTableStride() samples apart. Each one is wrapped in the guard samples
+		//TableInterpolation needs, copied from the other end of the cycle, so getTable(level)[-2] is the second to last
+		//sample and getTable(level)[tableSize + 2] is the third one. getTables() is level 0, the others follow it.
+		const float* getTables() const noexcept { return getTable(0); }
+		const float* getTable(int level) const noexcept { return tables.get() + level * getTableStride() + TableInterpolation::guardSamplesBefore; }
+		int getTableStride() const noexcept { return tableSize + TableInterpolation::numGuardSamples; }
+
+		//highest harmonic kept in the given level
+		int getMaxHarmonic(int level) const noexcept;
+
+		//the fullest level that stays below Nyquist for an oscillator advancing tableDelta samples of the table per output sample
+		int getLevelForPhaseDelta(float tableDelta) const noexcept;
+		int getLevelForFrequency(float frequency, float sampleRate) const noexcept { return getLevelForPhaseDelta(frequency * tableSize / sampleRate); }
+
+	private:
+		void allocateLevels();
+		void fillLevels(const float* magnitudes, const float* phases, int numHarmonics);
+
+		Shape shape;
+		int tableSize, levelsPerOctave, numLevels;
+		HeapBlock<float> tables;
+
+		JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (WavetableSet)
+};